@@ -0,0 +1,882 @@
+#ifndef DUAL_CMATH
+#   define DUAL_CMATH
+
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace dnn
+{
+    // Elementary functions usable in constant expressions.
+    //
+    // dnn::cmath::f(x) returns what std::f(x) returns. Evaluated at run time
+    // it is std::f, libm and nothing else; evaluated at compile time, where
+    // libm cannot be called, it runs the portable code in cmath_detail. That
+    // code works in long double, so float and double results are within an
+    // ulp or two of libm, and long double results within a few ulps, apart
+    // from pow to a non-integer exponent, which goes through exp(y log x) and
+    // is good to about 16.
+    //
+    // Complex arguments go to the std::complex overloads, which are not usable
+    // in constant expressions; the functions without one, such as expm1,
+    // log1p, cbrt, hypot and atan2, take real arguments only.
+    //
+    // Compile-time limits: signed zeros are not told apart except by copysign
+    // of float and double; sin, cos and tan reduce their argument with a
+    // 152-bit pi/2, lose accuracy past |x| ~ 2^30 and give NaN past 2^62.
+
+    namespace cmath_detail
+    {
+        using wide = long double;
+
+        template<typename T>
+        inline constexpr T infinity = std::numeric_limits<T>::infinity();
+
+        template<typename T>
+        inline constexpr T quiet_nan = std::numeric_limits<T>::quiet_NaN();
+
+        inline constexpr wide ln2_hi = 0x1.62e42feep-1L;             // 32 bits, k ln2_hi is exact
+        inline constexpr wide ln2_lo = 0x1.a39ef35793c76p-33L;
+        inline constexpr wide pio2_1 = 0x1.921fb544p0L;               // pi/2 in 33 bit pieces
+        inline constexpr wide pio2_2 = 0x1.0b4611a6p-34L;
+        inline constexpr wide pio2_3 = 0x1.3198a2ep-69L;
+        inline constexpr wide pio2_4 = 0x1.b839a252049c1p-104L;
+        inline constexpr wide pi_2 = 1.570796326794896619231321691639751442L;
+        inline constexpr wide pi = 3.141592653589793238462643383279502884L;
+        inline constexpr wide pi_4 = 0.785398163397448309615660845819875721L;
+
+        constexpr auto
+        isnan(wide x) noexcept
+            -> bool
+        { return x != x; }
+
+        constexpr auto
+        isinf(wide x) noexcept
+            -> bool
+        { return x == infinity<wide> || x == -infinity<wide>; }
+
+        // -0 + 0 is +0
+        constexpr auto
+        fabs(wide x) noexcept
+            -> wide
+        { return x < wide{} ? -x : x + wide{}; }
+
+        template<typename T>
+        constexpr auto
+        signbit(T x) noexcept
+            -> bool
+        {
+            if constexpr (std::is_same_v<T, double>)
+                return std::bit_cast<std::uint64_t>(x) >> 63;
+            else if constexpr (std::is_same_v<T, float>)
+                return std::bit_cast<std::uint32_t>(x) >> 31;
+            else
+                return x < T{};
+        }
+
+        // x = m 2^e with m in [1, 2), for finite x > 0
+        constexpr auto
+        frexp(wide x, long& e) noexcept
+            -> wide
+        {
+            e = 0;
+            while (x >= 0x1p64L)
+            {
+                x *= 0x1p-64L;
+                e += 64;
+            }
+            while (x < 0x1p-64L)
+            {
+                x *= 0x1p64L;
+                e -= 64;
+            }
+            while (x >= 2)
+            {
+                x *= 0.5L;
+                ++e;
+            }
+            while (x < 1)
+            {
+                x *= 2;
+                --e;
+            }
+            return x;
+        }
+
+        // m 2^e, inf rather than overflow, which is not a constant expression
+        constexpr auto
+        ldexp(wide m, long e) noexcept
+            -> wide
+        {
+            if (isnan(m) || isinf(m) || m == wide{})
+                return m;
+            long k;
+            const wide a = frexp(fabs(m), k);
+            e += k;
+            if (e >= std::numeric_limits<wide>::max_exponent)
+                return m < 0 ? -infinity<wide> : infinity<wide>;
+            if (e < std::numeric_limits<wide>::min_exponent - std::numeric_limits<wide>::digits - 1)
+                return m < 0 ? -wide{} : wide{};
+            wide r = a;
+            for (; e > 64; e -= 64)
+                r *= 0x1p64L;
+            for (; e < -64; e += 64)
+                r *= 0x1p-64L;
+            for (; e > 0; --e)
+                r *= 2;
+            for (; e < 0; ++e)
+                r *= 0.5L;
+            return m < 0 ? -r : r;
+        }
+
+        // nearest integer, for |x| well below 2^62
+        constexpr auto
+        nearest(wide x) noexcept
+            -> long long
+        { return static_cast<long long>(x < 0 ? x - 0.5L : x + 0.5L); }
+
+        constexpr auto
+        is_integer(wide x) noexcept
+            -> bool
+        { return fabs(x) >= 0x1p63L || x == static_cast<wide>(static_cast<long long>(x)); }
+
+        constexpr auto
+        sqrt(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || x == wide{} || x == infinity<wide>)
+                return x;
+            if (x < 0)
+                return quiet_nan<wide>;
+            long e;
+            wide m = frexp(x, e);
+            if (e % 2 != 0)
+            {
+                m *= 2;
+                --e;
+            }
+            wide y = (m + 1) * 0.5L;
+            for (int i = 0; i < 6; ++i)
+                y = 0.5L * (y + m / y);
+            return ldexp(y, e / 2);
+        }
+
+        constexpr auto
+        cbrt(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || x == wide{} || isinf(x))
+                return x;
+            long e;
+            wide m = frexp(fabs(x), e);
+            for (; e % 3 != 0; --e)
+                m *= 2;
+            wide y = m < 2 ? 1.1L : m < 4 ? 1.4L : 1.8L;
+            for (int i = 0; i < 6; ++i)
+                y -= (y * y * y - m) / (3 * y * y);
+            y = ldexp(y, e / 3);
+            return x < 0 ? -y : y;
+        }
+
+        // e^r - 1 for |r| <= ln2 / 2
+        constexpr auto
+        expm1_series(wide r) noexcept
+            -> wide
+        {
+            wide term = r, sum = r;
+            for (int n = 2; n < 40 && fabs(term) > fabs(sum) * 0x1p-70L; ++n)
+            {
+                term *= r / n;
+                sum += term;
+            }
+            return sum;
+        }
+
+        constexpr auto
+        exp(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x))
+                return x;
+            if (x > 11357)
+                return infinity<wide>;
+            if (x < -11400)
+                return wide{};
+            const long long k = nearest(x / (ln2_hi + ln2_lo));
+            const wide r = (x - k * ln2_hi) - k * ln2_lo;
+            return ldexp(1 + expm1_series(r), static_cast<long>(k));
+        }
+
+        constexpr auto
+        expm1(wide x) noexcept
+            -> wide
+        {
+            if (fabs(x) <= 0.34657359L)
+                return expm1_series(x);
+            if (x < -50)
+                return -1;
+            return exp(x) - 1;
+        }
+
+        constexpr auto
+        log(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || x == infinity<wide>)
+                return x;
+            if (x < 0)
+                return quiet_nan<wide>;
+            if (x == wide{})
+                return -infinity<wide>;
+            long e;
+            wide m = frexp(x, e);
+            if (m > 1.41421356237309504880L)
+            {
+                m *= 0.5L;
+                ++e;
+            }
+            // log m = 2 atanh s
+            const wide s = (m - 1) / (m + 1);
+            const wide s2 = s * s;
+            wide power = s, sum = s;
+            for (int n = 3; n < 60; n += 2)
+            {
+                power *= s2;
+                sum += power / n;
+            }
+            return e * ln2_hi + (e * ln2_lo + 2 * sum);
+        }
+
+        // as the dual overloads: from m = e^|x| - 1, at |x| then with the parity
+        // restored, and past the point where e^-|x| no longer counts as
+        // h * h / 2 with h = e^(|x| / 2), which m * (m + 2) would overflow long before
+        inline constexpr wide sinh_large = (std::numeric_limits<wide>::digits + 2) * 0.34657359027997264L;
+
+        constexpr auto
+        sinh(wide x) noexcept
+            -> wide
+        {
+            wide s;
+            if (fabs(x) > sinh_large)
+            {
+                const wide h = exp(0.5L * fabs(x));
+                s = h * (0.5L * h);
+            }
+            else
+            {
+                const wide m = expm1(fabs(x));
+                s = 0.5L * m * (m + 2) / (m + 1);
+            }
+            return x < 0 ? -s : s;
+        }
+
+        constexpr auto
+        cosh(wide x) noexcept
+            -> wide
+        {
+            if (fabs(x) > sinh_large)
+            {
+                const wide h = exp(0.5L * fabs(x));
+                return h * (0.5L * h);
+            }
+            const wide m = expm1(fabs(x));
+            return 0.5L * m * (m + 2) / (m + 1) + 1 / (m + 1);
+        }
+
+        constexpr auto
+        tanh(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x))
+                return x;
+            const wide a = fabs(x);
+            const wide t = a > 40 ? 1 : expm1(2 * a) / (expm1(2 * a) + 2);
+            return x < 0 ? -t : t;
+        }
+
+        // log(1 + x) = log(u) x / (u - 1) with u = 1 + x rounded, which cancels the rounding
+        constexpr auto
+        log1p(wide x) noexcept
+            -> wide
+        {
+            const wide u = 1 + x;
+            if (u == 1)
+                return x;
+            if (isinf(u))
+                return u;
+            return log(u) * (x / (u - 1));
+        }
+
+        // x - n pi/2 and the quadrant n mod 4, for |x| < 2^62
+        constexpr auto
+        reduce(wide x, int& quadrant) noexcept
+            -> wide
+        {
+            const long long n = nearest(x / pi_2);
+            quadrant = static_cast<int>(n & 3);
+            return (((x - n * pio2_1) - n * pio2_2) - n * pio2_3) - n * pio2_4;
+        }
+
+        // sin and cos for |r| <= pi/4
+        constexpr auto
+        sin_series(wide r) noexcept
+            -> wide
+        {
+            const wide r2 = r * r;
+            wide term = r, sum = r;
+            for (int n = 2; n < 40 && fabs(term) > fabs(sum) * 0x1p-70L; n += 2)
+            {
+                term *= -r2 / (n * (n + 1));
+                sum += term;
+            }
+            return sum;
+        }
+
+        constexpr auto
+        cos_series(wide r) noexcept
+            -> wide
+        {
+            const wide r2 = r * r;
+            wide term = 1, sum = 1;
+            for (int n = 1; n < 40 && fabs(term) > 0x1p-70L; n += 2)
+            {
+                term *= -r2 / (n * (n + 1));
+                sum += term;
+            }
+            return sum;
+        }
+
+        constexpr auto
+        sin(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || fabs(x) >= 0x1p62L)
+                return quiet_nan<wide>;
+            int q;
+            const wide r = reduce(x, q);
+            switch (q)
+            {
+                case 0:  return sin_series(r);
+                case 1:  return cos_series(r);
+                case 2:  return -sin_series(r);
+                default: return -cos_series(r);
+            }
+        }
+
+        constexpr auto
+        cos(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || fabs(x) >= 0x1p62L)
+                return quiet_nan<wide>;
+            int q;
+            const wide r = reduce(x, q);
+            switch (q)
+            {
+                case 0:  return cos_series(r);
+                case 1:  return -sin_series(r);
+                case 2:  return -cos_series(r);
+                default: return sin_series(r);
+            }
+        }
+
+        constexpr auto
+        tan(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || fabs(x) >= 0x1p62L)
+                return quiet_nan<wide>;
+            int q;
+            const wide r = reduce(x, q);
+            return q % 2 == 0 ? sin_series(r) / cos_series(r) : -cos_series(r) / sin_series(r);
+        }
+
+        // atan x = 2 atan(x / (1 + sqrt(1 + x^2))) until |x| <= 1/8, then the series
+        constexpr auto
+        atan(wide x) noexcept
+            -> wide
+        {
+            if (isnan(x))
+                return x;
+            if (isinf(x))
+                return x < 0 ? -pi_2 : pi_2;
+            wide a = fabs(x);
+            const bool inverted = a > 1;
+            if (inverted)
+                a = 1 / a;
+            int halvings = 0;
+            for (; a > 0.125L; ++halvings)
+                a = a / (1 + sqrt(1 + a * a));
+            const wide a2 = a * a;
+            wide power = a, sum = a;
+            for (int n = 3; n < 60; n += 2)
+            {
+                power *= -a2;
+                sum += power / n;
+            }
+            sum = ldexp(sum, halvings);
+            if (inverted)
+                sum = pi_2 - sum;
+            return x < 0 ? -sum : sum;
+        }
+
+        constexpr auto
+        atan2(wide y, wide x) noexcept
+            -> wide
+        {
+            if (isnan(x) || isnan(y))
+                return x + y;
+            if (isinf(x) && isinf(y))
+                return (x > 0 ? pi_4 : 3 * pi_4) * (y < 0 ? -1 : 1);
+            if (x == wide{})
+                return y == wide{} ? wide{} : y < 0 ? -pi_2 : pi_2;
+            const wide a = atan(y / x);
+            if (x > 0)
+                return a;
+            return y < 0 ? a - pi : a + pi;
+        }
+
+        constexpr auto
+        asin(wide x) noexcept
+            -> wide
+        { return fabs(x) > 1 ? quiet_nan<wide> : atan2(x, sqrt((1 - x) * (1 + x))); }
+
+        constexpr auto
+        acos(wide x) noexcept
+            -> wide
+        { return fabs(x) > 1 ? quiet_nan<wide> : atan2(sqrt((1 - x) * (1 + x)), x); }
+
+        constexpr auto
+        hypot(wide x, wide y) noexcept
+            -> wide
+        {
+            if (isinf(x) || isinf(y))
+                return infinity<wide>;
+            const wide a = fabs(x), b = fabs(y);
+            const wide s = a > b ? a : b;
+            if (isnan(s) || s == wide{})
+                return s;
+            return s * sqrt((a / s) * (a / s) + (b / s) * (b / s));
+        }
+
+        constexpr auto
+        pow(wide x, wide y) noexcept
+            -> wide
+        {
+            if (y == wide{} || x == 1)
+                return 1;
+            if (isnan(x) || isnan(y))
+                return x + y;
+            const bool integer = is_integer(y);
+            const bool odd = integer && fabs(y) < 0x1p63L && static_cast<long long>(y) % 2 != 0;
+            if (x == wide{} || isinf(x))
+            {
+                const bool big = isinf(x) == (y > 0);
+                const wide r = big ? infinity<wide> : wide{};
+                return x < 0 && odd ? -r : r;
+            }
+            if (x < 0 && !integer)
+                return quiet_nan<wide>;
+
+            // integer powers by squaring the mantissa, with the exponent
+            // counted apart so that nothing overflows on the way
+            if (integer && fabs(y) <= 1024)
+            {
+                long long n = static_cast<long long>(fabs(y));
+                long e;
+                wide base = frexp(fabs(x), e);
+                wide m = 1;
+                long long exponent = 0, base_exponent = e;
+                for (; n; n >>= 1)
+                {
+                    if (n & 1)
+                    {
+                        long k;
+                        m = frexp(m * base, k);
+                        exponent += k + base_exponent;
+                    }
+                    long k;
+                    base = frexp(base * base, k);
+                    base_exponent = 2 * base_exponent + k;
+                }
+                if (y < 0)
+                {
+                    m = 1 / m;
+                    exponent = -exponent;
+                }
+                if (exponent > 20000 || exponent < -20000)
+                    m = exponent > 0 ? infinity<wide> : wide{};
+                else
+                    m = ldexp(m, static_cast<long>(exponent));
+                return x < 0 && odd ? -m : m;
+            }
+            const wide r = exp(y * log(fabs(x)));
+            return x < 0 && odd ? -r : r;
+        }
+
+        // the wide result as R, saturating rather than overflowing
+        template<typename R>
+        constexpr auto
+        narrow(wide x) noexcept
+            -> R
+        {
+            if (x > std::numeric_limits<R>::max())
+                return infinity<R>;
+            if (x < -std::numeric_limits<R>::max())
+                return -infinity<R>;
+            return static_cast<R>(x);
+        }
+    }  /// namespace cmath_detail
+
+    namespace cmath
+    {
+        template<typename T>
+        constexpr auto
+        sqrt(const T& x) noexcept
+            -> decltype(std::sqrt(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::sqrt(x))>(cmath_detail::sqrt(x)); }
+            else
+            { return std::sqrt(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        cbrt(const T& x) noexcept
+            -> decltype(std::cbrt(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::cbrt(x))>(cmath_detail::cbrt(x)); }
+            else
+            { return std::cbrt(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        exp(const T& x) noexcept
+            -> decltype(std::exp(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::exp(x))>(cmath_detail::exp(x)); }
+            else
+            { return std::exp(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        expm1(const T& x) noexcept
+            -> decltype(std::expm1(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::expm1(x))>(cmath_detail::expm1(x)); }
+            else
+            { return std::expm1(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        log(const T& x) noexcept
+            -> decltype(std::log(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::log(x))>(cmath_detail::log(x)); }
+            else
+            { return std::log(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        log1p(const T& x) noexcept
+            -> decltype(std::log1p(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::log1p(x))>(cmath_detail::log1p(x)); }
+            else
+            { return std::log1p(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        sin(const T& x) noexcept
+            -> decltype(std::sin(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::sin(x))>(cmath_detail::sin(x)); }
+            else
+            { return std::sin(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        cos(const T& x) noexcept
+            -> decltype(std::cos(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::cos(x))>(cmath_detail::cos(x)); }
+            else
+            { return std::cos(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        tan(const T& x) noexcept
+            -> decltype(std::tan(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::tan(x))>(cmath_detail::tan(x)); }
+            else
+            { return std::tan(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        asin(const T& x) noexcept
+            -> decltype(std::asin(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::asin(x))>(cmath_detail::asin(x)); }
+            else
+            { return std::asin(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        acos(const T& x) noexcept
+            -> decltype(std::acos(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::acos(x))>(cmath_detail::acos(x)); }
+            else
+            { return std::acos(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        atan(const T& x) noexcept
+            -> decltype(std::atan(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::atan(x))>(cmath_detail::atan(x)); }
+            else
+            { return std::atan(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        sinh(const T& x) noexcept
+            -> decltype(std::sinh(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::sinh(x))>(cmath_detail::sinh(x)); }
+            else
+            { return std::sinh(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        cosh(const T& x) noexcept
+            -> decltype(std::cosh(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::cosh(x))>(cmath_detail::cosh(x)); }
+            else
+            { return std::cosh(x); }
+        }
+
+        template<typename T>
+        constexpr auto
+        tanh(const T& x) noexcept
+            -> decltype(std::tanh(x))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::tanh(x))>(cmath_detail::tanh(x)); }
+            else
+            { return std::tanh(x); }
+        }
+
+        template<typename T, typename U>
+        constexpr auto
+        atan2(const T& x, const U& y) noexcept
+            -> decltype(std::atan2(x, y))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::atan2(x, y))>(cmath_detail::atan2(x, y)); }
+            else
+            { return std::atan2(x, y); }
+        }
+
+        template<typename T, typename U>
+        constexpr auto
+        hypot(const T& x, const U& y) noexcept
+            -> decltype(std::hypot(x, y))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::hypot(x, y))>(cmath_detail::hypot(x, y)); }
+            else
+            { return std::hypot(x, y); }
+        }
+
+        template<typename T, typename U>
+        constexpr auto
+        pow(const T& x, const U& y) noexcept
+            -> decltype(std::pow(x, y))
+        {
+            if consteval
+            { return cmath_detail::narrow<decltype(std::pow(x, y))>(cmath_detail::pow(x, y)); }
+            else
+            { return std::pow(x, y); }
+        }
+
+        template<typename T>
+        constexpr auto
+        abs(const T& x) noexcept
+            -> decltype(std::abs(x))
+        {
+            if consteval
+            {
+                if constexpr (std::is_floating_point_v<T>)
+                    return x < T{} ? -x : x + T{};
+                else
+                    return x < T{} ? -x : x;
+            }
+            else
+            { return std::abs(x); }
+        }
+
+        template<typename T, typename U>
+        constexpr auto
+        copysign(const T& x, const U& s) noexcept
+            -> decltype(std::copysign(x, s))
+        {
+            using real_type = decltype(std::copysign(x, s));
+            if consteval
+            {
+                const real_type a = cmath::abs(static_cast<real_type>(x));
+                return cmath_detail::signbit(static_cast<real_type>(s)) ? -a : a;
+            }
+            else
+            { return std::copysign(x, s); }
+        }
+
+        template<typename T, typename U>
+        constexpr auto
+        fmax(const T& x, const U& y) noexcept
+            -> decltype(std::fmax(x, y))
+        {
+            using real_type = decltype(std::fmax(x, y));
+            if consteval
+            {
+                const real_type a = x, b = y;
+                return a != a ? b : b != b ? a : a < b ? b : a;
+            }
+            else
+            { return std::fmax(x, y); }
+        }
+
+        ///{@   complex arguments
+        template<typename T>
+        auto
+        sqrt(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::sqrt(z); }
+
+        template<typename T>
+        auto
+        exp(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::exp(z); }
+
+        template<typename T>
+        auto
+        log(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::log(z); }
+
+        template<typename T>
+        auto
+        sin(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::sin(z); }
+
+        template<typename T>
+        auto
+        cos(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::cos(z); }
+
+        template<typename T>
+        auto
+        tan(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::tan(z); }
+
+        template<typename T>
+        auto
+        asin(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::asin(z); }
+
+        template<typename T>
+        auto
+        acos(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::acos(z); }
+
+        template<typename T>
+        auto
+        atan(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::atan(z); }
+
+        template<typename T>
+        auto
+        sinh(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::sinh(z); }
+
+        template<typename T>
+        auto
+        cosh(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::cosh(z); }
+
+        template<typename T>
+        auto
+        tanh(const std::complex<T>& z)
+            -> std::complex<T>
+        { return std::tanh(z); }
+
+        // the modulus, a real number
+        template<typename T>
+        auto
+        abs(const std::complex<T>& z)
+            -> T
+        { return std::abs(z); }
+
+        template<typename T, typename U>
+        auto
+        pow(const std::complex<T>& z, const U& w)
+            -> decltype(std::pow(z, w))
+        { return std::pow(z, w); }
+
+        template<typename T, typename U>
+        auto
+        pow(const T& x, const std::complex<U>& w)
+            -> decltype(std::pow(x, w))
+        { return std::pow(x, w); }
+
+        template<typename T, typename U>
+        auto
+        pow(const std::complex<T>& z, const std::complex<U>& w)
+            -> decltype(std::pow(z, w))
+        { return std::pow(z, w); }
+        ///@}   complex arguments
+    }  /// namespace cmath
+
+}  /// namespace dnn
+
+#endif  /// DUAL_CMATH
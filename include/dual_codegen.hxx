@@ -0,0 +1,625 @@
+#ifndef DUAL_CODEGEN
+#   define DUAL_CODEGEN
+
+#include <dual_numbers.hxx>
+#include <dual_trace.hxx>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dnn
+{
+    // Native kernels generated from a trace.
+    //
+    // emit_cpp turns a trace<T> into a standalone C++ translation unit that
+    // computes the same values and tangents with plain scalars, with the
+    // trace's guards as early returns. On the way it
+    //  - merges instructions that repeat an earlier one on the same arguments,
+    //    and lets sin and cos, and the functions whose derivative is their own
+    //    value, share the calls they have in common;
+    //  - drops values that reach no output or guard;
+    //  - drops tangents that are zero because no active input reaches them,
+    //    or that feed only guards. Inputs are active unless options.active
+    //    says otherwise, and the seeds of inactive ones are never read.
+    //
+    // compiled_trace compiles that unit with the system compiler into a shared
+    // library, keyed by a hash of the source and the command line in
+    // options.cache, so the same trace is compiled once per user, and loads
+    // it with dlopen. The names in the cache are predictable, so it must not
+    // be writable by anyone else: the default is dnn_codegen in
+    // $XDG_CACHE_HOME or ~/.cache, created 0700, and a cache directory or
+    // library that is not the user's own and private is refused. The unit
+    // exports
+    //
+    //     int NAME(const real* x, const real* seed, real* re, real* d);
+    //     size_t NAME_batch(size_t n, const real* x, const real* seed, real* re, real* d);
+    //
+    // the first returning 0 when a guard fails, the second running n points
+    // stored one after the other and returning how many passed their guards
+    // before the first that did not.
+
+    struct codegen_options
+    {
+        // the compiler, $CXX when empty and c++ when that is unset too
+        std::string compiler;
+        std::string flags = "-O2 -fno-math-errno";
+        // inputs whose seed may be nonzero, all of them when empty
+        std::vector<bool> active;
+        std::string name = "dnn_kernel";
+        // the per-user default when empty
+        std::filesystem::path cache;
+    };
+
+    namespace codegen_detail
+    {
+        template<typename T>
+        inline constexpr std::string_view type_name =
+            std::is_same_v<T, float> ? "float" : std::is_same_v<T, double> ? "double" : "long double";
+
+        // an exact literal of type T
+        template<typename T>
+        auto
+        literal(T v)
+            -> std::string
+        {
+            if (v != v)
+                return std::string{"std::numeric_limits<real>::quiet_NaN()"};
+            if (v == std::numeric_limits<T>::infinity() || v == -std::numeric_limits<T>::infinity())
+                return std::string{v < 0 ? "-" : ""} + "std::numeric_limits<real>::infinity()";
+
+            std::array<char, 64> buffer;
+            const auto [end, error] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), v < 0 ? -v : v, std::chars_format::hex);
+            std::string s = std::string{v < 0 ? "-0x" : "0x"} + std::string{buffer.data(), end};
+            if constexpr (std::is_same_v<T, float>)
+                s += "f";
+            else if constexpr (!std::is_same_v<T, double>)
+                s += "L";
+            return "real(" + s + ")";
+        }
+
+        // FNV-1a, stable across builds unlike std::hash
+        inline auto
+        fingerprint(std::string_view s)
+            -> std::uint64_t
+        {
+            std::uint64_t h = 14695981039346656037ull;
+            for (const unsigned char c : s)
+                h = (h ^ c) * 1099511628211ull;
+            return h;
+        }
+
+        // $XDG_CACHE_HOME/dnn_codegen, else ~/.cache/dnn_codegen, else a
+        // directory of the temporary one named after the user id
+        inline auto
+        default_cache()
+            -> std::filesystem::path
+        {
+            const char* xdg = std::getenv("XDG_CACHE_HOME");
+            if (xdg && *xdg == '/')
+                return std::filesystem::path{xdg} / "dnn_codegen";
+            const char* home = std::getenv("HOME");
+            if (home && *home == '/')
+                return std::filesystem::path{home} / ".cache" / "dnn_codegen";
+            return std::filesystem::temp_directory_path() / ("dnn_codegen-" + std::to_string(::geteuid()));
+        }
+
+        // Creates directory 0700 when missing and checks that it, or the file
+        // when given, is what it claims to be and belongs to nobody but the
+        // calling user; others could otherwise plant the library dlopen loads.
+        inline auto
+        check_private(const std::filesystem::path& path, bool directory)
+            -> void
+        {
+            if (directory)
+            {
+                std::filesystem::create_directories(path.parent_path());
+                if (::mkdir(path.c_str(), 0700) != 0 && errno != EEXIST)
+                    throw std::system_error(errno, std::generic_category(), "dnn: cannot create " + path.string());
+            }
+            struct stat st;
+            if (::lstat(path.c_str(), &st) != 0)
+                throw std::system_error(errno, std::generic_category(), "dnn: cannot inspect " + path.string());
+            if ((directory ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) || st.st_uid != ::geteuid() || (st.st_mode & 022) != 0)
+                throw std::runtime_error("dnn: " + path.string() + " is not private to the current user");
+        }
+
+        constexpr auto
+        is_guard(trace_op op) noexcept
+            -> bool
+        { return op >= trace_op::guard_less; }
+
+        constexpr auto
+        has_constant(trace_op op) noexcept
+            -> bool
+        { return (op >= trace_op::add_c && op <= trace_op::ratan2_c) || op >= trace_op::guard_less_c; }
+
+        constexpr auto
+        is_binary(trace_op op) noexcept
+            -> bool
+        {
+            switch (op)
+            {
+                case trace_op::add: case trace_op::sub: case trace_op::mul: case trace_op::div:
+                case trace_op::pow: case trace_op::hypot: case trace_op::atan2:
+                case trace_op::guard_less: case trace_op::guard_less_equal: case trace_op::guard_equal:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }  /// namespace codegen_detail
+
+    template<typename T>
+    auto
+    emit_cpp(const trace<T>& t, const codegen_options& options = {})
+        -> std::string
+    {
+        using namespace codegen_detail;
+
+        const auto code = t.instructions();
+        const auto constants = t.constants();
+        const std::size_t inputs = t.inputs();
+        const std::size_t slots = inputs + code.size();
+        auto slot_of = [&](std::size_t i) { return inputs + i; };
+
+        // common subexpressions: each slot maps to the first slot computing the same thing
+        std::vector<std::size_t> rep(slots);
+        std::map<std::tuple<trace_op, std::size_t, std::size_t, T>, std::size_t> seen;
+        for (std::size_t k = 0; k < inputs; ++k)
+            rep[k] = k;
+        for (std::size_t i = 0; i < code.size(); ++i)
+        {
+            const auto& in = code[i];
+            const std::size_t k = slot_of(i);
+            rep[k] = k;
+            if (is_guard(in.op))
+                continue;
+            std::size_t a = rep[in.a], b = is_binary(in.op) ? rep[in.b] : 0;
+            if ((in.op == trace_op::add || in.op == trace_op::mul || in.op == trace_op::hypot) && b < a)
+                std::swap(a, b);
+            const T c = has_constant(in.op) ? constants[in.b] : T{};
+            const auto [it, inserted] = seen.try_emplace({in.op, a, b, c}, k);
+            rep[k] = it->second;
+        }
+        auto find = [&](trace_op op, std::size_t a) -> std::size_t
+        {
+            const auto it = seen.find({op, a, 0, T{}});
+            return it == seen.end() ? slots : it->second;
+        };
+
+        // tangents known to be zero, from inactive inputs forward
+        std::vector<bool> zero(slots, false);
+        for (std::size_t k = 0; k < inputs; ++k)
+            zero[k] = !options.active.empty() && !(k < options.active.size() && options.active[k]);
+        for (std::size_t i = 0; i < code.size(); ++i)
+        {
+            const auto& in = code[i];
+            const std::size_t k = slot_of(i);
+            if (rep[k] != k || is_guard(in.op))
+                continue;
+            zero[k] = zero[rep[in.a]] && (!is_binary(in.op) || zero[rep[in.b]]);
+        }
+
+        // liveness, backwards from the outputs and guards
+        std::vector<bool> value_live(slots, false), tangent_live(slots, false);
+        for (const auto o : t.outputs())
+        {
+            value_live[rep[o]] = true;
+            tangent_live[rep[o]] = !zero[rep[o]];
+        }
+        for (std::size_t i = code.size(); i-- > 0;)
+        {
+            const auto& in = code[i];
+            const std::size_t k = slot_of(i);
+            const std::size_t a = rep[in.a], b = is_binary(in.op) ? rep[in.b] : slots;
+            if (is_guard(in.op))
+            {
+                value_live[a] = true;
+                if (b < slots)
+                    value_live[b] = true;
+                continue;
+            }
+            if (rep[k] != k)
+                continue;
+            if (tangent_live[k])
+            {
+                value_live[k] = true;
+                tangent_live[a] = tangent_live[a] || !zero[a];
+                if (b < slots)
+                    tangent_live[b] = tangent_live[b] || !zero[b];
+            }
+            if (value_live[k])
+            {
+                value_live[a] = true;
+                if (b < slots)
+                    value_live[b] = true;
+            }
+        }
+
+        std::ostringstream os;
+        os << "// generated by dnn::emit_cpp from a trace of " << code.size() << " instructions\n"
+           << "#include <cmath>\n#include <cstddef>\n#include <limits>\n\n"
+           << "namespace\n{\n    using real = " << type_name<T> << ";\n\n"
+           << "    inline int\n    kernel(const real* x, const real* seed, real* re, real* d)\n    {\n"
+           << "        static_cast<void>(seed);\n";
+
+        auto v = [](std::size_t k) { return "v" + std::to_string(k); };
+        auto dv = [](std::size_t k) { return "d" + std::to_string(k); };
+        auto line = [&](const std::string& s) { os << "        " << s << ";\n"; };
+
+        std::vector<bool> hoisted(slots, false);
+        for (std::size_t k = 0; k < inputs; ++k)
+        {
+            if (value_live[k])
+                line("const real " + v(k) + " = x[" + std::to_string(k) + "]");
+            if (tangent_live[k])
+                line("const real " + dv(k) + " = seed[" + std::to_string(k) + "]");
+        }
+
+        for (std::size_t i = 0; i < code.size(); ++i)
+        {
+            const auto& in = code[i];
+            const std::size_t k = slot_of(i);
+            const std::size_t ai = rep[in.a];
+            const std::size_t bi = is_binary(in.op) ? rep[in.b] : slots;
+            const std::string u = v(ai), du = dv(ai);
+            const std::string w = bi < slots ? v(bi) : std::string{};
+            const std::string dw = bi < slots ? dv(bi) : std::string{};
+            const std::string c = has_constant(in.op) ? literal(constants[in.b]) : std::string{};
+            const bool zu = zero[ai], zw = bi < slots && zero[bi];
+            const std::string y = v(k), dy = dv(k);
+            const std::string tag = std::to_string(k);
+
+            if (is_guard(in.op))
+            {
+                std::string test;
+                switch (in.op)
+                {
+                    case trace_op::guard_less:            test = u + " < " + w; break;
+                    case trace_op::guard_less_equal:      test = u + " <= " + w; break;
+                    case trace_op::guard_equal:           test = u + " == " + w; break;
+                    case trace_op::guard_less_c:          test = u + " < " + c; break;
+                    case trace_op::guard_greater_c:       test = u + " > " + c; break;
+                    case trace_op::guard_less_equal_c:    test = u + " <= " + c; break;
+                    case trace_op::guard_greater_equal_c: test = u + " >= " + c; break;
+                    default:                              test = u + " == " + c; break;
+                }
+                os << "        if (" << (in.flag ? "!" : "") << "(" << test << "))\n            return 0;\n";
+                continue;
+            }
+            if (rep[k] != k || !value_live[k])
+                continue;
+
+            // the value of a related call on the same argument when the trace
+            // has one, computed here already when it comes later
+            auto shared = [&](trace_op op, const std::string& call)
+            {
+                const std::size_t s = find(op, ai);
+                if (s == slots || !value_live[s])
+                    return call;
+                if (s > k && !hoisted[s])
+                {
+                    line("const real " + v(s) + " = " + call);
+                    hoisted[s] = true;
+                }
+                return v(s);
+            };
+            // a sum of the terms whose tangent is not known to be zero
+            auto sum = [](std::initializer_list<std::pair<bool, std::string>> terms)
+            {
+                std::string s;
+                for (const auto& [zero_term, term] : terms)
+                    if (zero_term)
+                        continue;
+                    else if (s.empty())
+                        s = term;
+                    else if (term.front() == '-')
+                        s += " - " + term.substr(1);
+                    else
+                        s += " + " + term;
+                return s;
+            };
+
+            const bool tangent = tangent_live[k];
+            std::string value, slope;
+            switch (in.op)
+            {
+                case trace_op::add:   value = u + " + " + w; slope = sum({{zu, du}, {zw, dw}}); break;
+                case trace_op::sub:   value = u + " - " + w; slope = sum({{zu, du}, {zw, "-" + dw}}); break;
+                case trace_op::mul:   value = u + " * " + w; slope = sum({{zu, du + " * " + w}, {zw, u + " * " + dw}}); break;
+                case trace_op::div:
+                    value = u + " / " + w;
+                    slope = "(" + sum({{zu, du + " * " + w}, {zw, "-" + u + " * " + dw}}) + ") / (" + w + " * " + w + ")";
+                    break;
+                case trace_op::neg:   value = "-" + u; slope = "-" + du; break;
+                case trace_op::sqrt:  value = "std::sqrt(" + u + ")"; slope = du + " / (real(2) * " + y + ")"; break;
+                case trace_op::sin:   value = "std::sin(" + u + ")"; slope = shared(trace_op::cos, "std::cos(" + u + ")") + " * " + du; break;
+                case trace_op::cos:   value = "std::cos(" + u + ")"; slope = "-" + shared(trace_op::sin, "std::sin(" + u + ")") + " * " + du; break;
+                case trace_op::tan:   value = "std::tan(" + u + ")"; slope = "(real(1) + " + y + " * " + y + ") * " + du; break;
+                case trace_op::exp:   value = "std::exp(" + u + ")"; slope = y + " * " + du; break;
+                case trace_op::log:   value = "std::log(" + u + ")"; slope = du + " / " + u; break;
+                case trace_op::pow:
+                    value = "std::pow(" + u + ", " + w + ")";
+                    slope = sum({{zu, w + " * std::pow(" + u + ", " + w + " - 1) * " + du},
+                                 {zw, "(" + dw + " != real(0) ? std::log(" + u + ") * " + y + " * " + dw + " : real(0))"}});
+                    break;
+                case trace_op::acos:  value = "std::acos(" + u + ")"; slope = "-" + du + " / std::sqrt((real(1) - " + u + ") * (real(1) + " + u + "))"; break;
+                case trace_op::asin:  value = "std::asin(" + u + ")"; slope = du + " / std::sqrt((real(1) - " + u + ") * (real(1) + " + u + "))"; break;
+                case trace_op::atan:  value = "std::atan(" + u + ")"; slope = du + " / (real(1) + " + u + " * " + u + ")"; break;
+                case trace_op::hypot:
+                    value = "std::hypot(" + u + ", " + w + ")";
+                    slope = sum({{zu, "(" + u + " / " + y + ") * " + du}, {zw, "(" + w + " / " + y + ") * " + dw}});
+                    break;
+                case trace_op::sinh:
+                case trace_op::cosh:
+                    // as dual: from m = expm1(|x|), or h = e^(|x|/2) past the cutover
+                    line("const real x" + tag + " = std::abs(" + u + ")");
+                    line("real a" + tag + ", c" + tag);
+                    os << "        if (x" << tag << " > (std::numeric_limits<real>::digits + 2) * real(0.34657359027997264))\n"
+                       << "        {\n"
+                       << "            const real h = std::exp(real(0.5) * x" << tag << ");\n"
+                       << "            a" << tag << " = h * (real(0.5) * h);\n"
+                       << "            c" << tag << " = a" << tag << ";\n"
+                       << "        }\n"
+                       << "        else\n"
+                       << "        {\n"
+                       << "            const real m = std::expm1(x" << tag << ");\n"
+                       << "            const real i = real(1) / (m + real(1));\n"
+                       << "            a" << tag << " = real(0.5) * m * (m + real(2)) * i;\n"
+                       << "            c" << tag << " = a" << tag << " + i;\n"
+                       << "        }\n";
+                    line("const real s" + tag + " = std::copysign(a" + tag + ", " + u + ")");
+                    value = in.op == trace_op::sinh ? "s" + tag : "c" + tag;
+                    slope = (in.op == trace_op::sinh ? "c" : "s") + tag + " * " + du;
+                    break;
+                case trace_op::tanh:
+                    line("const real x" + tag + " = std::abs(" + u + ")");
+                    line("const real m" + tag + " = std::expm1(real(2) * x" + tag + ")");
+                    // as dual: rounds to 1 from the cutover of sinh/cosh
+                    line("const bool l" + tag + " = x" + tag + " > (std::numeric_limits<real>::digits + 2) * real(0.34657359027997264)");
+                    line("const real q" + tag + " = l" + tag + " ? real(1) : (m" + tag + " + real(2)) / (m" + tag + " + real(1))");
+                    value = "std::copysign(l" + tag + " ? real(1) : m" + tag + " / (m" + tag + " + real(2)), " + u + ")";
+                    slope = "real(4) / ((m" + tag + " + real(2)) * q" + tag + ") * " + du;
+                    break;
+                case trace_op::atan2:
+                case trace_op::atan2_c:
+                case trace_op::ratan2_c:
+                {
+                    // as dual: both scaled by max(|x|, |y|)
+                    const bool r = in.op == trace_op::ratan2_c;
+                    const std::string ny = r ? c : u, nx = r ? u : in.op == trace_op::atan2 ? w : c;
+                    const bool zy = r || zu, zx = in.op == trace_op::atan2 ? zw : in.op == trace_op::atan2_c ? true : zu;
+                    const std::string dny = r ? "" : du, dnx = r ? du : dw;
+                    value = "std::atan2(" + ny + ", " + nx + ")";
+                    if (tangent)
+                    {
+                        line("const real s" + tag + " = std::fmax(std::abs(" + nx + "), std::abs(" + ny + "))");
+                        line("const real xs" + tag + " = " + nx + " / s" + tag);
+                        line("const real ys" + tag + " = " + ny + " / s" + tag);
+                        slope = "s" + tag + " == real(0) ? real(0) : (" + sum({{zy, "xs" + tag + " * " + dny}, {zx, "-ys" + tag + " * " + dnx}})
+                              + ") / (s" + tag + " * (xs" + tag + " * xs" + tag + " + ys" + tag + " * ys" + tag + "))";
+                    }
+                    break;
+                }
+                case trace_op::log1p: value = "std::log1p(" + u + ")"; slope = du + " / (real(1) + " + u + ")"; break;
+                case trace_op::expm1:
+                    value = "std::expm1(" + u + ")";
+                    slope = "(" + u + " < " + literal(T(-0.6931471805599453)) + " ? " + shared(trace_op::exp, "std::exp(" + u + ")")
+                          + " : " + y + " + real(1)) * " + du;
+                    break;
+                case trace_op::cbrt:  value = "std::cbrt(" + u + ")"; slope = du + " / (real(3) * " + y + " * " + y + ")"; break;
+                case trace_op::abs:   value = "std::abs(" + u + ")"; slope = "real((real(0) < " + u + ") - (" + u + " < real(0))) * " + du; break;
+
+                case trace_op::add_c:  value = u + " + " + c; slope = du; break;
+                case trace_op::sub_c:  value = u + " - " + c; slope = du; break;
+                case trace_op::rsub_c: value = c + " - " + u; slope = "-" + du; break;
+                case trace_op::mul_c:  value = u + " * " + c; slope = du + " * " + c; break;
+                case trace_op::div_c:  value = u + " / " + c; slope = du + " / " + c; break;
+                case trace_op::rdiv_c: value = c + " / " + u; slope = "-" + c + " * " + du + " / (" + u + " * " + u + ")"; break;
+                case trace_op::pow_c:  value = "std::pow(" + u + ", " + c + ")"; slope = c + " * std::pow(" + u + ", " + c + " - 1) * " + du; break;
+                case trace_op::rpow_c: value = "std::pow(" + c + ", " + u + ")"; slope = "std::log(" + c + ") * " + y + " * " + du; break;
+                case trace_op::hypot_c: value = "std::hypot(" + u + ", " + c + ")"; slope = "(" + u + " / " + y + ") * " + du; break;
+                default: break;
+            }
+            if (!hoisted[k])
+                line("const real " + y + " = " + value);
+            if (tangent)
+                line("const real " + dy + " = " + slope);
+        }
+
+        const auto outputs = t.outputs();
+        for (std::size_t o = 0; o < outputs.size(); ++o)
+        {
+            const std::size_t k = rep[outputs[o]];
+            line("re[" + std::to_string(o) + "] = " + v(k));
+            line("d[" + std::to_string(o) + "] = " + (zero[k] ? std::string{"real(0)"} : dv(k)));
+        }
+        os << "        return 1;\n    }\n}\n\n";
+
+        const std::string in = std::to_string(inputs), out = std::to_string(outputs.size());
+        os << "extern \"C\" int\n" << options.name << "(const real* x, const real* seed, real* re, real* d)\n"
+           << "{ return kernel(x, seed, re, d); }\n\n"
+           << "extern \"C\" std::size_t\n" << options.name << "_batch(std::size_t n, const real* x, const real* seed, real* re, real* d)\n"
+           << "{\n    for (std::size_t i = 0; i < n; ++i)\n"
+           << "        if (!kernel(x + i * " << in << ", seed + i * " << in << ", re + i * " << out << ", d + i * " << out << "))\n"
+           << "            return i;\n    return n;\n}\n";
+        return os.str();
+    }
+
+    template<typename T>
+    class compiled_trace
+    {
+    public:
+
+        using kernel_type = int (*)(const T*, const T*, T*, T*);
+        using batch_type = std::size_t (*)(std::size_t, const T*, const T*, T*, T*);
+
+    public:
+
+        explicit
+        compiled_trace(const trace<T>& t, const codegen_options& options = {})
+            : m_source{ emit_cpp(t, options) }
+            , m_inputs{ t.inputs() }
+            , m_outputs{ t.outputs().size() }
+        {
+            std::string compiler = options.compiler;
+            if (compiler.empty())
+            {
+                const char* cxx = std::getenv("CXX");
+                compiler = cxx && *cxx ? cxx : "c++";
+            }
+            const std::string command = compiler + " " + options.flags + " -fPIC -shared";
+
+            const auto cache = options.cache.empty() ? codegen_detail::default_cache() : options.cache;
+            codegen_detail::check_private(cache, true);
+            char stem[32];
+            std::snprintf(stem, sizeof stem, "dnn_%016llx",
+                          static_cast<unsigned long long>(codegen_detail::fingerprint(m_source + '\n' + command)));
+            const auto base = cache / stem;
+            m_library = base;
+            m_library += ".so";
+
+            if (!std::filesystem::exists(m_library))
+            {
+                // every file is written under a name of its own, by process and
+                // build, and the results renamed into place, so concurrent
+                // builds neither truncate each other's source nor see half a library
+                static std::atomic<unsigned> builds{0};
+                const std::string own = "." + std::to_string(::getpid()) + "." + std::to_string(builds++);
+                auto partial = base, source_path = base, log = base;
+                partial += own + ".tmp";
+                source_path += own + ".cxx";
+                log += own + ".log";
+                std::ofstream{source_path} << m_source;
+
+                const std::string line = command + " '" + source_path.string() + "' -o '" + partial.string() + "' > '" + log.string() + "' 2>&1";
+                if (std::system(line.c_str()) != 0)
+                {
+                    std::ifstream in{log};
+                    std::stringstream message;
+                    message << in.rdbuf();
+                    throw std::runtime_error("dnn: compiling generated code failed: " + line + "\n" + message.str());
+                }
+                auto kept = base;
+                kept += ".cxx";
+                std::filesystem::rename(source_path, kept);
+                std::filesystem::remove(log);
+                std::filesystem::permissions(partial, std::filesystem::perms::owner_all);
+                std::filesystem::rename(partial, m_library);
+            }
+            codegen_detail::check_private(m_library, false);
+
+            m_handle = ::dlopen(m_library.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!m_handle)
+                throw std::runtime_error(std::string{"dnn: cannot load generated code: "} + ::dlerror());
+            m_kernel = reinterpret_cast<kernel_type>(::dlsym(m_handle, options.name.c_str()));
+            m_batch = reinterpret_cast<batch_type>(::dlsym(m_handle, (options.name + "_batch").c_str()));
+            if (!m_kernel || !m_batch)
+            {
+                ::dlclose(m_handle);
+                throw std::runtime_error("dnn: generated code lacks " + options.name);
+            }
+        }
+
+        compiled_trace(compiled_trace&& other) noexcept
+            : m_source{ std::move(other.m_source) }
+            , m_library{ std::move(other.m_library) }
+            , m_handle{ std::exchange(other.m_handle, nullptr) }
+            , m_kernel{ other.m_kernel }
+            , m_batch{ other.m_batch }
+            , m_inputs{ other.m_inputs }
+            , m_outputs{ other.m_outputs }
+        { }
+
+        compiled_trace(const compiled_trace&) = delete;
+        auto operator= (const compiled_trace&) -> compiled_trace& = delete;
+        auto operator= (compiled_trace&&) -> compiled_trace& = delete;
+
+        ~compiled_trace()
+        {
+            if (m_handle)
+                ::dlclose(m_handle);
+        }
+
+        // as trace::replay
+        auto
+        operator()(std::span<const T> x, std::span<const T> seed, std::span<dual<T>> y) const
+            -> bool
+        {
+            if (x.size() != m_inputs || seed.size() != m_inputs || y.size() != m_outputs)
+                throw std::invalid_argument("dnn: compiled trace called with the wrong number of inputs or outputs");
+            constexpr std::size_t small = 16;
+            T re[small], d[small];
+            std::vector<T> heap;
+            T* pr = re;
+            T* pd = d;
+            if (m_outputs > small)
+            {
+                heap.resize(2 * m_outputs);
+                pr = heap.data();
+                pd = pr + m_outputs;
+            }
+            if (!m_kernel(x.data(), seed.data(), pr, pd))
+                return false;
+            for (std::size_t k = 0; k < m_outputs; ++k)
+                y[k] = dual<T>{pr[k], pd[k]};
+            return true;
+        }
+
+        // n points, inputs() values and seeds and outputs() results each, in
+        // order; the number evaluated before the first failed guard
+        auto
+        batch(std::size_t n, const T* x, const T* seed, T* re, T* d) const
+            -> std::size_t
+        { return m_batch(n, x, seed, re, d); }
+
+        auto
+        source() const noexcept
+            -> const std::string&
+        { return m_source; }
+
+        auto
+        library() const noexcept
+            -> const std::filesystem::path&
+        { return m_library; }
+
+    private:
+
+        std::string m_source;
+        std::filesystem::path m_library;
+        void* m_handle = nullptr;
+        kernel_type m_kernel = nullptr;
+        batch_type m_batch = nullptr;
+        std::size_t m_inputs;
+        std::size_t m_outputs;
+    };
+
+}  /// namespace dnn
+
+#endif  /// DUAL_CODEGEN
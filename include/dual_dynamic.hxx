@@ -0,0 +1,655 @@
+#ifndef DUAL_DYNAMIC
+#   define DUAL_DYNAMIC
+
+#include <dual_numbers.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dnn
+{
+    // Duals with a number of tangents chosen at runtime, stored in an arena.
+    //
+    // dual_arena is a per-thread bump allocator: allocating is a pointer
+    // increment, nothing is freed individually. An arena_scope remembers the
+    // arena's position and rewinds to it when it ends, which frees everything
+    // allocated inside at once; the memory stays with the arena for the next
+    // scope, so after warm up a loop of scoped evaluations never calls malloc.
+    //
+    // A ddual holds its real part, its width and a pointer to its tangents in
+    // the arena of the thread that created it. It must not outlive the scope
+    // it was created in; results needed afterwards are copied out first.
+    // It also records the depth of that scope, so that assigning to it from
+    // an inner scope, as in acc = acc + x, copies into its own tangents
+    // rather than taking storage the inner scope frees. When the tangents
+    // must grow there, the new ones come from a heap block the arena keeps
+    // until the outer scope ends.
+    // Width 0 stands for a constant, whose tangents are all zero, so constants
+    // mix with values of any width.
+
+    class dual_arena
+    {
+    public:
+
+        // a position to rewind to
+        struct mark
+        {
+            std::size_t block;
+            std::size_t offset;
+        };
+
+        static constexpr std::size_t block_bytes = std::size_t{1} << 16;
+
+        // the depth of the outermost code, outside every scope
+        static constexpr std::size_t outermost = 0;
+
+    public:
+
+        // the arena of the calling thread
+        static auto
+        local() noexcept
+            -> dual_arena&
+        {
+            thread_local dual_arena arena;
+            return arena;
+        }
+
+        dual_arena(const dual_arena&) = delete;
+        auto operator= (const dual_arena&) -> dual_arena& = delete;
+
+        auto
+        allocate(std::size_t bytes, std::size_t alignment)
+            -> void*
+        {
+            std::size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+            if (m_block >= m_blocks.size() || offset + bytes > m_blocks[m_block].size)
+            {
+                next_block(bytes + alignment);
+                offset = (m_offset + alignment - 1) & ~(alignment - 1);
+            }
+            m_offset = offset + bytes;
+            return m_blocks[m_block].data.get() + offset;
+        }
+
+        template<typename T>
+        auto
+        allocate(std::size_t n)
+            -> T*
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "the arena never runs destructors");
+            return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        }
+
+        // Storage for n T that lives until the scope at depth ends, which may
+        // enclose the current one: that takes a heap block, released when the
+        // arena leaves depth.
+        template<typename T>
+        auto
+        allocate_at(std::size_t depth, std::size_t n)
+            -> T*
+        {
+            if (depth >= m_depth)
+                return allocate<T>(n);
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+            m_held.push_back({depth, std::make_unique_for_overwrite<unsigned char[]>(n * sizeof(T))});
+            return reinterpret_cast<T*>(m_held.back().data.get());
+        }
+
+        auto
+        position() const noexcept
+            -> mark
+        { return {m_block, m_offset}; }
+
+        auto
+        rewind(const mark& m) noexcept
+            -> void
+        {
+            m_block = m.block;
+            m_offset = m.offset;
+        }
+
+        // the number of open scopes
+        auto
+        depth() const noexcept
+            -> std::size_t
+        { return m_depth; }
+
+        // opens a scope, returning the position its end rewinds to
+        auto
+        enter() noexcept
+            -> mark
+        {
+            ++m_depth;
+            return position();
+        }
+
+        // closes the innermost scope, opened at m
+        auto
+        leave(const mark& m) noexcept
+            -> void
+        {
+            rewind(m);
+            --m_depth;
+            while (!m_held.empty() && m_held.back().depth > m_depth)
+                m_held.pop_back();
+        }
+
+        // bytes in use up to the current position
+        auto
+        used() const noexcept
+            -> std::size_t
+        {
+            std::size_t n = m_offset;
+            for (std::size_t b = 0; b < m_block && b < m_blocks.size(); ++b)
+                n += m_blocks[b].size;
+            return n;
+        }
+
+        // blocks taken from the allocator so far
+        auto
+        blocks() const noexcept
+            -> std::size_t
+        { return m_blocks.size(); }
+
+    private:
+
+        struct block
+        {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        struct held_block
+        {
+            std::size_t depth;
+            std::unique_ptr<unsigned char[]> data;
+        };
+
+        dual_arena() = default;
+
+        // Moves on to the next block, reusing a retained one when it is large
+        // enough and inserting a new one otherwise.
+        auto
+        next_block(std::size_t bytes)
+            -> void
+        {
+            const std::size_t next = m_blocks.empty() ? 0 : m_block + 1;
+            if (next >= m_blocks.size() || m_blocks[next].size < bytes)
+            {
+                const std::size_t size = std::max(block_bytes, bytes);
+                m_blocks.insert(m_blocks.begin() + static_cast<std::ptrdiff_t>(std::min(next, m_blocks.size())),
+                                block{std::make_unique_for_overwrite<unsigned char[]>(size), size});
+            }
+            m_block = next;
+            m_offset = 0;
+        }
+
+        std::vector<block> m_blocks;
+        std::size_t m_block = 0;
+        std::size_t m_offset = 0;
+        std::size_t m_depth = outermost;
+        // blocks of outer scopes, innermost last
+        std::vector<held_block> m_held;
+    };
+
+    // Rewinds the calling thread's arena to where it was on construction.
+    class arena_scope
+    {
+    public:
+
+        arena_scope() noexcept
+            : m_mark{ dual_arena::local().enter() }
+        { }
+
+        arena_scope(const arena_scope&) = delete;
+        auto operator= (const arena_scope&) -> arena_scope& = delete;
+
+        ~arena_scope()
+        { dual_arena::local().leave(m_mark); }
+
+    private:
+
+        dual_arena::mark m_mark;
+    };
+
+    template<typename T>
+    class ddual
+    {
+    public:
+
+        using base_real_type = T;
+
+        static_assert(std::is_trivially_destructible_v<base_real_type>);
+
+    public:
+
+        explicit
+        ddual(const base_real_type& re = base_real_type{}) noexcept
+            : m_re{ re }
+        { }
+
+        // n zero tangents
+        ddual(const base_real_type& re, std::size_t n)
+            : m_re{ re }
+            , m_d{ n ? dual_arena::local().allocate<base_real_type>(n) : nullptr }
+            , m_width{ n }
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                m_d[i] = base_real_type{};
+        }
+
+        // input i of n
+        static auto
+        variable(const base_real_type& re, std::size_t i, std::size_t n)
+            -> ddual
+        {
+            ddual x{re, n};
+            x.m_d[i] = base_real_type{1};
+            return x;
+        }
+
+        // copies take fresh tangents from the arena, moves take those of the
+        // source, which is left a constant without tangents
+        ddual(const ddual& other)
+            : m_re{ other.m_re }
+            , m_d{ other.m_width ? dual_arena::local().allocate<base_real_type>(other.m_width) : nullptr }
+            , m_width{ other.m_width }
+        {
+            for (std::size_t i = 0; i < m_width; ++i)
+                m_d[i] = other.m_d[i];
+        }
+
+        ddual(ddual&& other) noexcept
+            : m_re{ other.m_re }
+            , m_d{ std::exchange(other.m_d, nullptr) }
+            , m_width{ std::exchange(other.m_width, 0) }
+        { }
+
+        // Assignment keeps the tangents in storage that lives as long as this
+        // ddual: its own when they fit, else fresh storage of its scope.
+        auto
+        operator= (const ddual& other)
+            -> ddual&
+        {
+            if (this == &other)
+                return *this;
+            if (m_width < other.m_width)
+                m_d = dual_arena::local().allocate_at<base_real_type>(m_depth, other.m_width);
+            m_re = other.m_re;
+            m_width = other.m_width;
+            for (std::size_t i = 0; i < m_width; ++i)
+                m_d[i] = other.m_d[i];
+            return *this;
+        }
+
+        // takes the tangents of other only when its scope encloses this one
+        auto
+        operator= (ddual&& other)
+            -> ddual&
+        {
+            if (this == &other)
+                return *this;
+            if (other.m_depth > m_depth)
+                return *this = static_cast<const ddual&>(other);
+            m_re = other.m_re;
+            m_d = std::exchange(other.m_d, nullptr);
+            m_width = std::exchange(other.m_width, 0);
+            return *this;
+        }
+
+        auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_re; }
+
+        auto
+        width() const noexcept
+            -> std::size_t
+        { return m_width; }
+
+        auto
+        d() const noexcept
+            -> std::span<const base_real_type>
+        { return {m_d, m_width}; }
+
+        auto
+        d(std::size_t i) const noexcept
+            -> base_real_type
+        { return i < m_width ? m_d[i] : base_real_type{}; }
+
+        // value a and tangents scaled by s
+        auto
+        chain(const base_real_type& a, const base_real_type& s) const
+            -> ddual
+        {
+            ddual r{a};
+            if (m_width == 0)
+                return r;
+            r.m_d = dual_arena::local().allocate<base_real_type>(m_width);
+            r.m_width = m_width;
+            for (std::size_t i = 0; i < m_width; ++i)
+                r.m_d[i] = s * m_d[i];
+            return r;
+        }
+
+        // value a and tangents su du + sv dv
+        static auto
+        chain(const base_real_type& a, const base_real_type& su, const ddual& u, const base_real_type& sv, const ddual& v)
+            -> ddual
+        {
+            if (v.m_width == 0)
+                return u.chain(a, su);
+            if (u.m_width == 0)
+                return v.chain(a, sv);
+
+            ddual r{a};
+            r.m_width = std::max(u.m_width, v.m_width);
+            r.m_d = dual_arena::local().allocate<base_real_type>(r.m_width);
+            const std::size_t n = std::min(u.m_width, v.m_width);
+            for (std::size_t i = 0; i < n; ++i)
+                r.m_d[i] = su * u.m_d[i] + sv * v.m_d[i];
+            for (std::size_t i = n; i < u.m_width; ++i)
+                r.m_d[i] = su * u.m_d[i];
+            for (std::size_t i = n; i < v.m_width; ++i)
+                r.m_d[i] = sv * v.m_d[i];
+            return r;
+        }
+
+        ///{@  dynamic dual unary arithmetic
+        auto
+        operator+= (const ddual& v)
+            -> ddual&
+        {
+            if (v.m_width > m_width)
+                return *this = *this + v;
+            m_re += v.m_re;
+            for (std::size_t i = 0; i < v.m_width; ++i)
+                m_d[i] += v.m_d[i];
+            return *this;
+        }
+
+        auto
+        operator-= (const ddual& v)
+            -> ddual&
+        {
+            if (v.m_width > m_width)
+                return *this = *this - v;
+            m_re -= v.m_re;
+            for (std::size_t i = 0; i < v.m_width; ++i)
+                m_d[i] -= v.m_d[i];
+            return *this;
+        }
+
+        auto
+        operator*= (const ddual& v)
+            -> ddual&
+        { return *this = *this * v; }
+
+        auto
+        operator/= (const ddual& v)
+            -> ddual&
+        { return *this = *this / v; }
+
+        auto
+        operator+= (const base_real_type& v) noexcept
+            -> ddual&
+        {
+            m_re += v;
+            return *this;
+        }
+
+        auto
+        operator-= (const base_real_type& v) noexcept
+            -> ddual&
+        {
+            m_re -= v;
+            return *this;
+        }
+
+        auto
+        operator*= (const base_real_type& v) noexcept
+            -> ddual&
+        {
+            m_re *= v;
+            for (std::size_t i = 0; i < m_width; ++i)
+                m_d[i] *= v;
+            return *this;
+        }
+
+        auto
+        operator/= (const base_real_type& v) noexcept
+            -> ddual&
+        { return *this *= base_real_type{1} / v; }
+        ///@}  dynamic dual unary arithmetic
+
+        ///{@  dynamic dual arithmetic
+        // defined as friends so that plain numbers convert to base_real_type
+        friend auto
+        operator+ (const ddual& u)
+            -> ddual
+        { return u; }
+
+        friend auto
+        operator- (const ddual& u)
+            -> ddual
+        { return u.chain(-u.m_re, base_real_type{-1}); }
+
+        friend auto
+        operator+ (const ddual& u, const ddual& v)
+            -> ddual
+        { return chain(u.m_re + v.m_re, base_real_type{1}, u, base_real_type{1}, v); }
+
+        friend auto
+        operator- (const ddual& u, const ddual& v)
+            -> ddual
+        { return chain(u.m_re - v.m_re, base_real_type{1}, u, base_real_type{-1}, v); }
+
+        friend auto
+        operator* (const ddual& u, const ddual& v)
+            -> ddual
+        { return chain(u.m_re * v.m_re, v.m_re, u, u.m_re, v); }
+
+        friend auto
+        operator/ (const ddual& u, const ddual& v)
+            -> ddual
+        {
+            const base_real_type inv = base_real_type{1} / v.m_re;
+            const base_real_type q = u.m_re * inv;
+            return chain(q, inv, u, -q * inv, v);
+        }
+
+        friend auto
+        operator+ (const ddual& u, const base_real_type& v)
+            -> ddual
+        { return u.chain(u.m_re + v, base_real_type{1}); }
+
+        friend auto
+        operator+ (const base_real_type& u, const ddual& v)
+            -> ddual
+        { return v.chain(u + v.m_re, base_real_type{1}); }
+
+        friend auto
+        operator- (const ddual& u, const base_real_type& v)
+            -> ddual
+        { return u.chain(u.m_re - v, base_real_type{1}); }
+
+        friend auto
+        operator- (const base_real_type& u, const ddual& v)
+            -> ddual
+        { return v.chain(u - v.m_re, base_real_type{-1}); }
+
+        friend auto
+        operator* (const ddual& u, const base_real_type& v)
+            -> ddual
+        { return u.chain(u.m_re * v, v); }
+
+        friend auto
+        operator* (const base_real_type& u, const ddual& v)
+            -> ddual
+        { return v.chain(u * v.m_re, u); }
+
+        friend auto
+        operator/ (const ddual& u, const base_real_type& v)
+            -> ddual
+        { return u.chain(u.m_re / v, base_real_type{1} / v); }
+
+        friend auto
+        operator/ (const base_real_type& u, const ddual& v)
+            -> ddual
+        {
+            const base_real_type q = u / v.m_re;
+            return v.chain(q, -q / v.m_re);
+        }
+        ///@}  dynamic dual arithmetic
+
+        ///{@   dynamic dual comparison operators
+        // on the real part, like dual
+        friend auto
+        operator== (const ddual& u, const ddual& v) noexcept
+            -> bool
+        { return u.m_re == v.m_re; }
+
+        friend auto
+        operator<=> (const ddual& u, const ddual& v) noexcept
+        { return u.m_re <=> v.m_re; }
+
+        friend auto
+        operator== (const ddual& u, const base_real_type& v) noexcept
+            -> bool
+        { return u.m_re == v; }
+
+        friend auto
+        operator<=> (const ddual& u, const base_real_type& v) noexcept
+        { return u.m_re <=> v; }
+        ///@}   dynamic dual comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const ddual& v)
+            -> std::ostream&
+        {
+            os << v.m_re << " + [";
+            for (std::size_t i = 0; i < v.m_width; ++i)
+                os << (i ? ", " : "") << v.m_d[i];
+            os << "]_eps";
+            return os;
+        }
+        ///@}   ostream
+
+    private:
+
+        base_real_type m_re;
+        base_real_type* m_d = nullptr;
+        std::size_t m_width = 0;
+        // the scope the ddual was created in
+        std::size_t m_depth = dual_arena::local().depth();
+    };
+
+    ///{@   elementary functions of dynamic duals
+    template<typename T>
+    auto
+    sqrt(const ddual<T>& x)
+        -> ddual<T>
+    {
+        const T s = std::sqrt(x.re());
+        return x.chain(s, T{1} / (T{2} * s));
+    }
+
+    template<typename T>
+    auto
+    exp(const ddual<T>& x)
+        -> ddual<T>
+    {
+        const T e = std::exp(x.re());
+        return x.chain(e, e);
+    }
+
+    template<typename T>
+    auto
+    log(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::log(x.re()), T{1} / x.re()); }
+
+    template<typename T>
+    auto
+    sin(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::sin(x.re()), std::cos(x.re())); }
+
+    template<typename T>
+    auto
+    cos(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::cos(x.re()), -std::sin(x.re())); }
+
+    template<typename T>
+    auto
+    tan(const ddual<T>& x)
+        -> ddual<T>
+    {
+        const T t = std::tan(x.re());
+        return x.chain(t, T{1} + t * t);
+    }
+
+    template<typename T>
+    auto
+    atan(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::atan(x.re()), T{1} / (T{1} + x.re() * x.re())); }
+
+    template<typename T>
+    auto
+    tanh(const ddual<T>& x)
+        -> ddual<T>
+    {
+        const T c = std::cosh(x.re());
+        return x.chain(std::tanh(x.re()), T{1} / (c * c));
+    }
+
+    template<typename T>
+    auto
+    log1p(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::log1p(x.re()), T{1} / (T{1} + x.re())); }
+
+    template<typename T>
+    auto
+    expm1(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::expm1(x.re()), std::exp(x.re())); }
+
+    template<typename T>
+    auto
+    abs(const ddual<T>& x)
+        -> ddual<T>
+    { return x.chain(std::abs(x.re()), static_cast<T>((T{} < x.re()) - (x.re() < T{}))); }
+
+    template<typename T>
+    auto
+    pow(const ddual<T>& x, const std::type_identity_t<T>& n)
+        -> ddual<T>
+    { return x.chain(std::pow(x.re(), n), n * std::pow(x.re(), n - T{1})); }
+
+    template<typename T>
+    auto
+    pow(const ddual<T>& x, const ddual<T>& n)
+        -> ddual<T>
+    {
+        const T p = std::pow(x.re(), n.re());
+        return ddual<T>::chain(p, n.re() * std::pow(x.re(), n.re() - T{1}), x, n.width() ? p * std::log(x.re()) : T{}, n);
+    }
+    ///@}   elementary functions of dynamic duals
+
+}  /// namespace dnn
+
+#endif  /// DUAL_DYNAMIC
@@ -0,0 +1,288 @@
+#ifndef DUAL_FFT
+#   define DUAL_FFT
+
+#include <dual_numbers.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace dnn
+{
+    // Fast Fourier transforms of dual signals.
+    //
+    // The transform is linear, so the tangent of a spectrum is the spectrum of
+    // the tangent. Running a generic FFT on dual<std::complex<T>> does that
+    // with dual butterflies, each of which multiplies both parts by the same
+    // twiddle through std::complex. Here the value and tangent are
+    // split into planes of real and imaginary parts and transformed together
+    // instead: every butterfly loads its twiddle once and applies it to both
+    // planes with plain multiplies that vectorise, and no NaN-checking
+    // complex multiply is ever called.
+    //
+    // A real dual signal r + d eps takes a single complex transform of
+    // z = r + i d, the two-for-one packing. The spectra of r and d are both
+    // Hermitian, so they are recovered as (Z[k] + conj Z[n-k]) / 2 and
+    // (Z[k] - conj Z[n-k]) / 2i. The inverse packs the two half spectra the
+    // same way.
+    //
+    // The transform is a radix-2 decimation in frequency on power-of-two sizes,
+    // followed by a bit-reversal permutation. Stages whose butterflies span
+    // more than a block are run across the whole array. The rest only mix
+    // elements within one block, so each block runs them all while it is in
+    // cache. The default block holds 2048 points of both planes, 64 KiB in double.
+    //
+    // A plan keeps its scratch planes, so one plan serves one thread at a time.
+
+    template<typename T>
+    class fft_plan
+    {
+    public:
+
+        using base_real_type = T;
+        using complex_type = std::complex<T>;
+
+        static constexpr std::size_t default_block = 2048;
+
+    public:
+
+        explicit
+        fft_plan(std::size_t n, std::size_t block = default_block)
+            : m_n{ n }
+            , m_block{ std::min(std::max<std::size_t>(block, 2), std::max<std::size_t>(n, 1)) }
+            , m_twiddle_re(n > 1 ? n - 1 : 0)
+            , m_twiddle_im(n > 1 ? n - 1 : 0)
+            , m_reverse(n)
+            , m_re(n), m_im(n), m_dre(n), m_dim(n)
+        {
+            if (n == 0 || (n & (n - 1)) != 0)
+                throw std::invalid_argument("dnn: fft size must be a power of two");
+            if ((m_block & (m_block - 1)) != 0)
+                throw std::invalid_argument("dnn: fft block must be a power of two");
+
+            // the twiddles of the stage with half span h are contiguous from h - 1
+            for (std::size_t h = 1; h < n; h *= 2)
+                for (std::size_t j = 0; j < h; ++j)
+                {
+                    const long double a = -std::numbers::pi_v<long double> * static_cast<long double>(j) / static_cast<long double>(h);
+                    m_twiddle_re[h - 1 + j] = static_cast<T>(std::cos(a));
+                    m_twiddle_im[h - 1 + j] = static_cast<T>(std::sin(a));
+                }
+
+            std::size_t bits = 0;
+            while ((std::size_t{1} << bits) < n)
+                ++bits;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                std::size_t r = 0;
+                for (std::size_t b = 0; b < bits; ++b)
+                    r |= ((i >> b) & 1) << (bits - 1 - b);
+                m_reverse[i] = static_cast<std::uint32_t>(r);
+            }
+        }
+
+        auto
+        size() const noexcept
+            -> std::size_t
+        { return m_n; }
+
+        auto
+        block() const noexcept
+            -> std::size_t
+        { return m_block; }
+
+        ///{@   complex dual signals, in place
+        // X[k] = sum x[j] e^(-2 pi i jk / n)
+        auto
+        forward(std::span<dual<complex_type>> x)
+            -> void
+        { complex_transform(x, false); }
+
+        // x[j] = 1/n sum X[k] e^(2 pi i jk / n)
+        auto
+        inverse(std::span<dual<complex_type>> x)
+            -> void
+        { complex_transform(x, true); }
+        ///@}   complex dual signals, in place
+
+        ///{@   real dual signals
+        // The n/2 + 1 bins k = 0 .. n/2 of the spectrum of a real dual signal,
+        // the others being their conjugates.
+        auto
+        forward(std::span<const dual<T>> x, std::span<dual<complex_type>> spectrum)
+            -> void
+        {
+            if (x.size() != m_n || spectrum.size() != m_n / 2 + 1)
+                throw std::invalid_argument("dnn: fft of a real signal takes n points and gives n/2 + 1 bins");
+
+            for (std::size_t i = 0; i < m_n; ++i)
+            {
+                m_re[i] = x[i].re();
+                m_im[i] = x[i].d();
+            }
+            run<1>();
+
+            const T half{0.5};
+            for (std::size_t k = 0; k <= m_n / 2; ++k)
+            {
+                const std::size_t j = m_reverse[k], l = m_reverse[(m_n - k) & (m_n - 1)];
+                const T ar = m_re[j], ai = m_im[j], br = m_re[l], bi = m_im[l];
+                spectrum[k] = dual<complex_type>{complex_type{half * (ar + br), half * (ai - bi)},
+                                                 complex_type{half * (ai + bi), half * (br - ar)}};
+            }
+        }
+
+        // The real dual signal with the half spectrum k = 0 .. n/2; the
+        // imaginary parts of bins 0 and n/2 are ignored, as they must be 0.
+        auto
+        inverse(std::span<const dual<complex_type>> spectrum, std::span<dual<T>> x)
+            -> void
+        {
+            if (x.size() != m_n || spectrum.size() != m_n / 2 + 1)
+                throw std::invalid_argument("dnn: inverse fft to a real signal takes n/2 + 1 bins and gives n points");
+
+            // Z = R + i D over the full spectrum, with R[n-k] = conj R[k] and
+            // likewise for D, conjugated for a forward transform
+            for (std::size_t k = 0; k < m_n; ++k)
+            {
+                const bool upper = k > m_n / 2;
+                const auto& s = spectrum[upper ? m_n - k : k];
+                const T ri = (k == 0 || 2 * k == m_n) ? T{} : upper ? -s.re().imag() : s.re().imag();
+                const T di = (k == 0 || 2 * k == m_n) ? T{} : upper ? -s.d().imag() : s.d().imag();
+                m_re[k] = s.re().real() - di;
+                m_im[k] = -(ri + s.d().real());
+            }
+            run<1>();
+
+            const T scale = T{1} / static_cast<T>(m_n);
+            for (std::size_t i = 0; i < m_n; ++i)
+            {
+                const std::size_t j = m_reverse[i];
+                x[i] = dual<T>{m_re[j] * scale, -m_im[j] * scale};
+            }
+        }
+        ///@}   real dual signals
+
+    private:
+
+        auto
+        complex_transform(std::span<dual<complex_type>> x, bool inverse)
+            -> void
+        {
+            if (x.size() != m_n)
+                throw std::invalid_argument("dnn: fft called with a signal of the wrong length");
+
+            // the inverse is the forward transform of the conjugate, conjugated
+            const T sign = inverse ? T{-1} : T{1};
+            for (std::size_t i = 0; i < m_n; ++i)
+            {
+                m_re[i] = x[i].re().real();
+                m_im[i] = sign * x[i].re().imag();
+                m_dre[i] = x[i].d().real();
+                m_dim[i] = sign * x[i].d().imag();
+            }
+            run<2>();
+
+            const T scale = inverse ? T{1} / static_cast<T>(m_n) : T{1};
+            for (std::size_t i = 0; i < m_n; ++i)
+            {
+                const std::size_t j = m_reverse[i];
+                x[i] = dual<complex_type>{complex_type{m_re[j] * scale, sign * m_im[j] * scale},
+                                          complex_type{m_dre[j] * scale, sign * m_dim[j] * scale}};
+            }
+        }
+
+        // The butterflies of one stage with half span h over [begin, end), on
+        // one plane or on both sharing the twiddles. Output is bit reversed.
+        template<std::size_t planes>
+        auto
+        stage(std::size_t begin, std::size_t end, std::size_t h)
+            -> void
+        {
+            const T* wr = m_twiddle_re.data() + (h - 1);
+            const T* wi = m_twiddle_im.data() + (h - 1);
+            for (std::size_t s = begin; s < end; s += 2 * h)
+            {
+                T* ar = m_re.data() + s;
+                T* ai = m_im.data() + s;
+                for (std::size_t j = 0; j < h; ++j)
+                {
+                    const T ur = ar[j], ui = ai[j], vr = ar[j + h], vi = ai[j + h];
+                    const T tr = ur - vr, ti = ui - vi;
+                    ar[j] = ur + vr;
+                    ai[j] = ui + vi;
+                    ar[j + h] = tr * wr[j] - ti * wi[j];
+                    ai[j + h] = tr * wi[j] + ti * wr[j];
+                }
+                if constexpr (planes == 2)
+                {
+                    T* br = m_dre.data() + s;
+                    T* bi = m_dim.data() + s;
+                    for (std::size_t j = 0; j < h; ++j)
+                    {
+                        const T ur = br[j], ui = bi[j], vr = br[j + h], vi = bi[j + h];
+                        const T tr = ur - vr, ti = ui - vi;
+                        br[j] = ur + vr;
+                        bi[j] = ui + vi;
+                        br[j + h] = tr * wr[j] - ti * wi[j];
+                        bi[j + h] = tr * wi[j] + ti * wr[j];
+                    }
+                }
+            }
+        }
+
+        template<std::size_t planes>
+        auto
+        run()
+            -> void
+        {
+            std::size_t h = m_n / 2;
+            for (; h >= 1 && 2 * h > m_block; h /= 2)
+                stage<planes>(0, m_n, h);
+            for (std::size_t base = 0; base < m_n; base += m_block)
+                for (std::size_t g = h; g >= 1; g /= 2)
+                    stage<planes>(base, base + m_block, g);
+        }
+
+    private:
+
+        std::size_t m_n;
+        std::size_t m_block;
+        std::vector<T> m_twiddle_re;
+        std::vector<T> m_twiddle_im;
+        std::vector<std::uint32_t> m_reverse;
+        std::vector<T> m_re, m_im, m_dre, m_dim;
+    };
+
+    ///{@   one-off transforms
+    // Convenience wrappers that build a plan for a single call.
+    template<typename T>
+    auto
+    fft(std::span<const dual<std::complex<T>>> x)
+        -> std::vector<dual<std::complex<T>>>
+    {
+        std::vector<dual<std::complex<T>>> out(x.begin(), x.end());
+        fft_plan<T>{x.size()}.forward(out);
+        return out;
+    }
+
+    template<typename T>
+    auto
+    fft(std::span<const dual<T>> x)
+        -> std::vector<dual<std::complex<T>>>
+    {
+        std::vector<dual<std::complex<T>>> out(x.size() / 2 + 1);
+        fft_plan<T>{x.size()}.forward(x, out);
+        return out;
+    }
+    ///@}   one-off transforms
+
+}  /// namespace dnn
+
+#endif  /// DUAL_FFT
@@ -0,0 +1,392 @@
+#ifndef DUAL_FILE
+#   define DUAL_FILE
+
+#include <dual_numbers.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dnn
+{
+    // Binary files of dual numbers that can be mapped straight into memory.
+    //
+    // A file is a 64 byte header followed by the data, which starts at a 64
+    // byte aligned offset. The data is either AoS, the dual objects as they
+    // sit in memory, or SoA, one plane of real parts followed by one plane per
+    // tangent, each plane padded to a multiple of 64 bytes. Values are stored
+    // in the writer's byte order, which the header records; a reader on a
+    // machine of the other order rejects the file rather than copy it.
+    //
+    // I/O and format errors are reported with exceptions, there is nothing a
+    // caller could do with a partially mapped file.
+
+    enum class dual_layout : std::uint8_t
+    {
+        aos = 0,
+        soa = 1
+    };
+
+    enum class dual_element : std::uint8_t
+    {
+        f32  = 1,
+        f64  = 2,
+        f80  = 3,   // x87 long double, stored in its 16 byte in-memory form
+        f128 = 4    // IEEE quad long double
+    };
+
+    struct dual_file_header
+    {
+        static constexpr char          magic_value[8] = {'D', 'N', 'N', 'D', 'U', 'A', 'L', '\0'};
+        static constexpr std::uint16_t current_version = 1;
+        static constexpr std::uint64_t alignment = 64;
+
+        char          magic[8];
+        std::uint16_t version;
+        dual_element  element;
+        dual_layout   layout;
+        std::uint8_t  big_endian;
+        std::uint8_t  element_size;
+        std::uint16_t tangents;
+        std::uint64_t count;
+        std::uint64_t data_offset;
+        std::uint64_t plane_stride;     // bytes between SoA planes, 0 for AoS
+        std::uint8_t  reserved[24];
+    };
+    static_assert(sizeof(dual_file_header) == dual_file_header::alignment);
+    static_assert(std::is_trivially_copyable_v<dual_file_header>);
+
+    namespace file_detail
+    {
+        template<typename base_real_type>
+        constexpr auto
+        element_of() noexcept
+            -> dual_element
+        {
+            if constexpr (std::is_same_v<base_real_type, float>)
+                return dual_element::f32;
+            else if constexpr (std::is_same_v<base_real_type, double>)
+                return dual_element::f64;
+            else if constexpr (std::is_same_v<base_real_type, long double> && std::numeric_limits<long double>::digits == 64)
+                return dual_element::f80;
+            else if constexpr (std::is_same_v<base_real_type, long double> && std::numeric_limits<long double>::digits == 113)
+                return dual_element::f128;
+            else
+                static_assert(sizeof(base_real_type) == 0, "dual files hold float, double or long double");
+        }
+
+        constexpr auto
+        round_up(std::uint64_t n) noexcept
+            -> std::uint64_t
+        {
+            return (n + dual_file_header::alignment - 1) / dual_file_header::alignment * dual_file_header::alignment;
+        }
+
+        template<typename base_real_type>
+        auto
+        make_header(std::uint64_t count, dual_layout layout) noexcept
+            -> dual_file_header
+        {
+            dual_file_header h{};
+            std::memcpy(h.magic, dual_file_header::magic_value, sizeof h.magic);
+            h.version      = dual_file_header::current_version;
+            h.element      = element_of<base_real_type>();
+            h.layout       = layout;
+            h.big_endian   = std::endian::native == std::endian::big;
+            h.element_size = sizeof(base_real_type);
+            h.tangents     = 1;
+            h.count        = count;
+            h.data_offset  = sizeof(dual_file_header);
+            h.plane_stride = layout == dual_layout::soa ? round_up(count * sizeof(base_real_type)) : 0;
+            return h;
+        }
+
+        inline auto
+        write_bytes(std::ofstream& out, const void* p, std::size_t n, const std::string& path)
+            -> void
+        {
+            out.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+            if (!out)
+                throw std::runtime_error("dnn: failed writing " + path);
+        }
+
+        inline auto
+        pad(std::ofstream& out, std::uint64_t written, const std::string& path)
+            -> void
+        {
+            static constexpr char zeros[dual_file_header::alignment] = {};
+            write_bytes(out, zeros, round_up(written) - written, path);
+        }
+
+        // flushes the buffered tail, where a full disk shows up
+        inline auto
+        close(std::ofstream& out, const std::string& path)
+            -> void
+        {
+            out.close();
+            if (!out)
+                throw std::runtime_error("dnn: failed writing " + path);
+        }
+    }  /// namespace file_detail
+
+    ///{@   writers
+    // Writes x to path in the given layout, replacing any existing file.
+    template<typename base_real_type>
+    auto
+    write_duals(const std::string& path, std::span<const dual<base_real_type>> x, dual_layout layout = dual_layout::aos)
+        -> void
+    {
+        static_assert(sizeof(dual<base_real_type>) == 2 * sizeof(base_real_type));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("dnn: cannot open " + path + " for writing");
+
+        const auto h = file_detail::make_header<base_real_type>(x.size(), layout);
+        file_detail::write_bytes(out, &h, sizeof h, path);
+
+        if (layout == dual_layout::aos)
+            file_detail::write_bytes(out, x.data(), x.size_bytes(), path);
+        else
+        {
+            // SoA, staged through a small buffer per plane
+            constexpr std::size_t chunk = 4096;
+            base_real_type buffer[chunk];
+            for (int plane = 0; plane < 2; ++plane)
+            {
+                for (std::size_t i = 0; i < x.size(); i += chunk)
+                {
+                    const std::size_t n = std::min(chunk, x.size() - i);
+                    for (std::size_t j = 0; j < n; ++j)
+                        buffer[j] = plane == 0 ? x[i + j].re() : x[i + j].d();
+                    file_detail::write_bytes(out, buffer, n * sizeof(base_real_type), path);
+                }
+                file_detail::pad(out, x.size() * sizeof(base_real_type), path);
+            }
+        }
+        file_detail::close(out, path);
+    }
+
+    // Writes separate real and tangent planes of equal length as an SoA file.
+    template<typename base_real_type>
+    auto
+    write_duals(const std::string& path, std::span<const base_real_type> re, std::span<const base_real_type> d)
+        -> void
+    {
+        if (re.size() != d.size())
+            throw std::invalid_argument("dnn: real and tangent planes differ in length");
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("dnn: cannot open " + path + " for writing");
+
+        const auto h = file_detail::make_header<base_real_type>(re.size(), dual_layout::soa);
+        file_detail::write_bytes(out, &h, sizeof h, path);
+        file_detail::write_bytes(out, re.data(), re.size_bytes(), path);
+        file_detail::pad(out, re.size_bytes(), path);
+        file_detail::write_bytes(out, d.data(), d.size_bytes(), path);
+        file_detail::pad(out, d.size_bytes(), path);
+        file_detail::close(out, path);
+    }
+    ///@}   writers
+
+    ///{@   readers
+    // A read-only mapping of a dual file. The spans it hands out point into the
+    // mapping and stay valid as long as the object lives; opening is O(1) in the
+    // size of the file, pages are read by the kernel as they are touched.
+    template<typename T>
+    class mapped_duals
+    {
+    public:
+
+        using base_real_type = T;
+
+    public:
+
+        explicit
+        mapped_duals(const std::string& path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                throw std::system_error(errno, std::generic_category(), "dnn: cannot open " + path);
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0)
+            {
+                const int e = errno;
+                ::close(fd);
+                throw std::system_error(e, std::generic_category(), "dnn: cannot stat " + path);
+            }
+            m_size = static_cast<std::size_t>(st.st_size);
+            if (m_size < sizeof(dual_file_header))
+            {
+                ::close(fd);
+                throw std::runtime_error("dnn: " + path + " is too short for a dual file");
+            }
+
+            m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            const int e = errno;
+            ::close(fd);
+            if (m_data == MAP_FAILED)
+            {
+                m_data = nullptr;
+                throw std::system_error(e, std::generic_category(), "dnn: cannot map " + path);
+            }
+
+            std::memcpy(&m_header, m_data, sizeof m_header);
+            try
+            {
+                validate(path);
+            }
+            catch (...)
+            {
+                unmap();
+                throw;
+            }
+        }
+
+        mapped_duals(const mapped_duals&) = delete;
+        auto operator= (const mapped_duals&) -> mapped_duals& = delete;
+
+        mapped_duals(mapped_duals&& other) noexcept
+            : m_data{ std::exchange(other.m_data, nullptr) }
+            , m_size{ std::exchange(other.m_size, 0) }
+            , m_header{ other.m_header }
+        { }
+
+        auto
+        operator= (mapped_duals&& other) noexcept
+            -> mapped_duals&
+        {
+            if (this != &other)
+            {
+                unmap();
+                m_data = std::exchange(other.m_data, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+                m_header = other.m_header;
+            }
+            return *this;
+        }
+
+        ~mapped_duals()
+        { unmap(); }
+
+        auto
+        header() const noexcept
+            -> const dual_file_header&
+        { return m_header; }
+
+        auto
+        layout() const noexcept
+            -> dual_layout
+        { return m_header.layout; }
+
+        auto
+        size() const noexcept
+            -> std::size_t
+        { return m_header.count; }
+
+        // the duals of an AoS file
+        auto
+        duals() const
+            -> std::span<const dual<base_real_type>>
+        {
+            if (m_header.layout != dual_layout::aos)
+                throw std::logic_error("dnn: dual file is not in AoS layout");
+            // the file was written from dual objects of this exact type
+            return {reinterpret_cast<const dual<base_real_type>*>(bytes() + m_header.data_offset), size()};
+        }
+
+        // the real plane of an SoA file
+        auto
+        re() const
+            -> std::span<const base_real_type>
+        { return plane(0); }
+
+        // the tangent plane of an SoA file
+        auto
+        d() const
+            -> std::span<const base_real_type>
+        { return plane(1); }
+
+    private:
+
+        auto
+        bytes() const noexcept
+            -> const unsigned char*
+        { return static_cast<const unsigned char*>(m_data); }
+
+        auto
+        plane(std::size_t k) const
+            -> std::span<const base_real_type>
+        {
+            if (m_header.layout != dual_layout::soa)
+                throw std::logic_error("dnn: dual file is not in SoA layout");
+            return {reinterpret_cast<const base_real_type*>(bytes() + m_header.data_offset + k * m_header.plane_stride), size()};
+        }
+
+        auto
+        validate(const std::string& path) const
+            -> void
+        {
+            const auto& h = m_header;
+            if (std::memcmp(h.magic, dual_file_header::magic_value, sizeof h.magic) != 0)
+                throw std::runtime_error("dnn: " + path + " is not a dual file");
+            if (h.version != dual_file_header::current_version)
+                throw std::runtime_error("dnn: " + path + " has unsupported version " + std::to_string(h.version));
+            if (h.big_endian != (std::endian::native == std::endian::big))
+                throw std::runtime_error("dnn: " + path + " was written with the other byte order");
+            if (h.element != file_detail::element_of<base_real_type>() || h.element_size != sizeof(base_real_type))
+                throw std::runtime_error("dnn: " + path + " holds a different element type");
+            if (h.tangents != 1)
+                throw std::runtime_error("dnn: " + path + " holds " + std::to_string(h.tangents) + " tangents per element");
+            if (h.data_offset % alignof(dual<base_real_type>) != 0)
+                throw std::runtime_error("dnn: " + path + " has misaligned data");
+
+            // sizes come from the file, so they are compared by division, which
+            // cannot wrap around
+            const bool soa = h.layout == dual_layout::soa;
+            if ((h.layout != dual_layout::aos && !soa)
+             || (soa && (h.count > h.plane_stride / sizeof(base_real_type) || h.plane_stride % alignof(base_real_type) != 0)))
+                throw std::runtime_error("dnn: " + path + " has an invalid layout");
+            if (h.data_offset > m_size)
+                throw std::runtime_error("dnn: " + path + " is truncated");
+            const std::uint64_t room = m_size - h.data_offset;
+            if (soa ? h.plane_stride > room / 2 : h.count > room / sizeof(dual<base_real_type>))
+                throw std::runtime_error("dnn: " + path + " is truncated");
+        }
+
+        auto
+        unmap() noexcept
+            -> void
+        {
+            if (m_data)
+                ::munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+
+        void* m_data = nullptr;
+        std::size_t m_size = 0;
+        dual_file_header m_header{};
+    };
+    ///@}   readers
+
+}  /// namespace dnn
+
+#endif  /// DUAL_FILE
@@ -0,0 +1,178 @@
+#ifndef DUAL_FORMAT
+#   define DUAL_FORMAT
+
+#include <dual_numbers.hxx>
+
+#include <charconv>
+#include <cstddef>
+#include <span>
+#include <system_error>
+
+namespace dnn
+{
+    // Text formatting and parsing of dual numbers on top of std::to_chars and
+    // std::from_chars: locale independent, no allocation, shortest output that
+    // reads back to the same value. Everything writes into or reads from a
+    // caller supplied character range and reports errors the way <charconv>
+    // does, through an std::errc in the result.
+    //
+    // Two notations are understood:
+    //      eps     "1.5 + -2_eps", what operator<< prints
+    //      csv     "1.5,-2"
+    // The parser also accepts "1.5 - 2_eps" and any blanks around the separators.
+
+    enum class dual_notation
+    {
+        eps,
+        csv
+    };
+
+    // result of the bulk parser, count is the number of duals stored
+    struct dual_parse_result
+    {
+        const char* ptr;
+        std::errc ec;
+        std::size_t count;
+    };
+
+    namespace format_detail
+    {
+        constexpr auto
+        skip_blanks(const char* first, const char* last) noexcept
+            -> const char*
+        {
+            while (first != last && (*first == ' ' || *first == '\t'))
+                ++first;
+            return first;
+        }
+
+        constexpr auto
+        copy(char* first, char* last, const char* s, std::size_t n) noexcept
+            -> std::to_chars_result
+        {
+            if (static_cast<std::size_t>(last - first) < n)
+                return {last, std::errc::value_too_large};
+            for (std::size_t i = 0; i < n; ++i)
+                first[i] = s[i];
+            return {first + n, std::errc{}};
+        }
+    }  /// namespace format_detail
+
+    ///{@   formatting
+    template<typename base_real_type>
+    auto
+    to_chars(char* first, char* last, const dual<base_real_type>& v, dual_notation notation = dual_notation::eps) noexcept
+        -> std::to_chars_result
+    {
+        auto r = std::to_chars(first, last, v.re());
+        if (r.ec != std::errc{})
+            return r;
+
+        r = notation == dual_notation::csv ? format_detail::copy(r.ptr, last, ",", 1)
+                                           : format_detail::copy(r.ptr, last, " + ", 3);
+        if (r.ec != std::errc{})
+            return r;
+
+        r = std::to_chars(r.ptr, last, v.d());
+        if (r.ec != std::errc{} || notation == dual_notation::csv)
+            return r;
+
+        return format_detail::copy(r.ptr, last, "_eps", 4);
+    }
+
+    // Formats every element of x followed by separator. On error ptr is last and
+    // the range holds the elements that fit completely.
+    template<typename base_real_type>
+    auto
+    to_chars(char* first, char* last, std::span<const dual<base_real_type>> x,
+             dual_notation notation = dual_notation::eps, char separator = '\n') noexcept
+        -> std::to_chars_result
+    {
+        for (const auto& v : x)
+        {
+            auto r = to_chars(first, last, v, notation);
+            if (r.ec == std::errc{})
+                r = format_detail::copy(r.ptr, last, &separator, 1);
+            if (r.ec != std::errc{})
+                return {last, r.ec};
+            first = r.ptr;
+        }
+        return {first, std::errc{}};
+    }
+    ///@}   formatting
+
+    ///{@   parsing
+    // Parses one dual in either notation, leading blanks are skipped.
+    template<typename base_real_type>
+    auto
+    from_chars(const char* first, const char* last, dual<base_real_type>& v) noexcept
+        -> std::from_chars_result
+    {
+        using format_detail::skip_blanks;
+
+        base_real_type re{};
+        base_real_type d{};
+
+        auto r = std::from_chars(skip_blanks(first, last), last, re);
+        if (r.ec != std::errc{})
+            return r;
+
+        const char* p = skip_blanks(r.ptr, last);
+        if (p == last)
+            return {p, std::errc::invalid_argument};
+
+        if (*p == ',')
+        {
+            r = std::from_chars(skip_blanks(p + 1, last), last, d);
+            if (r.ec != std::errc{})
+                return r;
+            v = dual<base_real_type>{re, d};
+            return r;
+        }
+
+        if (*p != '+' && *p != '-')
+            return {p, std::errc::invalid_argument};
+        const bool negate = *p == '-';
+
+        r = std::from_chars(skip_blanks(p + 1, last), last, d);
+        if (r.ec != std::errc{})
+            return r;
+
+        constexpr char suffix[] = "_eps";
+        p = r.ptr;
+        for (std::size_t i = 0; i + 1 < sizeof suffix; ++i, ++p)
+            if (p == last || *p != suffix[i])
+                return {p, std::errc::invalid_argument};
+
+        v = dual<base_real_type>{re, negate ? -d : d};
+        return {p, std::errc{}};
+    }
+
+    // Parses duals separated by whitespace or ';' into out, until either the
+    // text or out is exhausted. Stops at the first malformed entry with ptr
+    // pointing at it.
+    template<typename base_real_type>
+    auto
+    from_chars(const char* first, const char* last, std::span<dual<base_real_type>> out) noexcept
+        -> dual_parse_result
+    {
+        std::size_t n = 0;
+        for (; n < out.size(); ++n)
+        {
+            while (first != last && (*first == ' ' || *first == '\t' || *first == '\n' || *first == '\r' || *first == ';'))
+                ++first;
+            if (first == last)
+                break;
+
+            const auto r = from_chars(first, last, out[n]);
+            if (r.ec != std::errc{})
+                return {r.ptr, r.ec, n};
+            first = r.ptr;
+        }
+        return {first, std::errc{}, n};
+    }
+    ///@}   parsing
+
+}  /// namespace dnn
+
+#endif  /// DUAL_FORMAT
@@ -0,0 +1,380 @@
+#ifndef DUAL_HESSIAN
+#   define DUAL_HESSIAN
+
+#include <dual_numbers.hxx>
+#include <dual_multi.hxx>
+#include <dual_reverse.hxx>
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dnn
+{
+    // Hessian-vector products, forward over reverse.
+    //
+    // An hdual<T, K> is recorded on a tape like a taped<T>, but its value is
+    // an mdual<T, K> carrying the derivatives along K directions v_1 ... v_K,
+    // and so is every partial it pushes: the derivative of the operation
+    // evaluated at that mdual, which holds the second derivatives of the
+    // operation along the directions next to the first. The reverse sweep
+    // then runs in mdual arithmetic, and the adjoint of input i comes out as
+    // df/dx_i with tangents (H v_k)_i.
+    //
+    // hvp therefore gives f, its gradient and K products H v_k from one
+    // recording and one reverse sweep, each operation costing about K + 1
+    // times its scalar self; no column of H is ever formed.
+
+    template<typename T, std::size_t K>
+    class hdual
+    {
+    public:
+
+        using base_real_type = T;
+        using value_type = mdual<T, K>;
+        using tape_type = tape<value_type>;
+        using index_type = typename tape_type::index_type;
+
+    public:
+
+        // a constant
+        hdual(const base_real_type& v = base_real_type{}) noexcept
+            : m_value{ v }
+        { }
+
+        explicit
+        hdual(const value_type& v) noexcept
+            : m_value{ v }
+        { }
+
+        // input i of a recording on t, its tangents the components of the directions
+        static auto
+        variable(tape_type& t, const value_type& v)
+            -> hdual
+        { return hdual{v, t.push({})}; }
+
+        auto
+        value() const noexcept
+            -> const value_type&
+        { return m_value; }
+
+        auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_value.re(); }
+
+        auto
+        index() const noexcept
+            -> index_type
+        { return m_index; }
+
+        // value v depending on a with partial da, and on b with partial db
+        static auto
+        apply(const value_type& v, const hdual& a, const value_type& da)
+            -> hdual
+        {
+            if (a.m_index == 0)
+                return hdual{v};
+            return hdual{v, tape_type::current().push({{a.m_index, da}})};
+        }
+
+        static auto
+        apply(const value_type& v, const hdual& a, const value_type& da, const hdual& b, const value_type& db)
+            -> hdual
+        {
+            if (a.m_index == 0 && b.m_index == 0)
+                return hdual{v};
+            return hdual{v, tape_type::current().push({{a.m_index, da}, {b.m_index, db}})};
+        }
+
+        ///{@  hdual compound assignment
+        auto operator+= (const hdual& v) -> hdual& { return *this = *this + v; }
+        auto operator-= (const hdual& v) -> hdual& { return *this = *this - v; }
+        auto operator*= (const hdual& v) -> hdual& { return *this = *this * v; }
+        auto operator/= (const hdual& v) -> hdual& { return *this = *this / v; }
+        ///@}  hdual compound assignment
+
+        ///{@  hdual arithmetic
+        friend auto
+        operator+ (const hdual& u)
+            -> hdual
+        { return u; }
+
+        friend auto
+        operator- (const hdual& u)
+            -> hdual
+        { return apply(-u.m_value, u, value_type{base_real_type{-1}}); }
+
+        friend auto
+        operator+ (const hdual& u, const hdual& v)
+            -> hdual
+        { return apply(u.m_value + v.m_value, u, value_type{base_real_type{1}}, v, value_type{base_real_type{1}}); }
+
+        friend auto
+        operator- (const hdual& u, const hdual& v)
+            -> hdual
+        { return apply(u.m_value - v.m_value, u, value_type{base_real_type{1}}, v, value_type{base_real_type{-1}}); }
+
+        friend auto
+        operator* (const hdual& u, const hdual& v)
+            -> hdual
+        { return apply(u.m_value * v.m_value, u, v.m_value, v, u.m_value); }
+
+        friend auto
+        operator/ (const hdual& u, const hdual& v)
+            -> hdual
+        {
+            const value_type inv = base_real_type{1} / v.m_value;
+            const value_type q = u.m_value * inv;
+            return apply(q, u, inv, v, -q * inv);
+        }
+        ///@}  hdual arithmetic
+
+        ///{@   hdual comparison operators, on the real part
+        friend auto operator== (const hdual& u, const hdual& v) noexcept -> bool { return u.re() == v.re(); }
+        friend auto operator<=> (const hdual& u, const hdual& v) noexcept { return u.re() <=> v.re(); }
+        ///@}   hdual comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const hdual& v)
+            -> std::ostream&
+        { return os << v.m_value << " @" << v.m_index; }
+        ///@}   ostream
+
+    private:
+
+        hdual(const value_type& v, index_type index) noexcept
+            : m_value{ v }
+            , m_index{ index }
+        { }
+
+        value_type m_value;
+        index_type m_index = 0;
+    };
+
+    ///{@   elementary functions of hduals, each partial evaluated at the mdual value
+    template<typename T, std::size_t K>
+    auto
+    sqrt(const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> s = dnn::sqrt(x.value());
+        return hdual<T, K>::apply(s, x, T{0.5} / s);
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    exp(const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> e = dnn::exp(x.value());
+        return hdual<T, K>::apply(e, x, e);
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    log(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::log(x.value()), x, T{1} / x.value()); }
+
+    template<typename T, std::size_t K>
+    auto
+    sin(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::sin(x.value()), x, dnn::cos(x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    cos(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::cos(x.value()), x, -dnn::sin(x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    tan(const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> t = dnn::tan(x.value());
+        return hdual<T, K>::apply(t, x, T{1} + t * t);
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    atan(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::atan(x.value()), x, T{1} / (T{1} + x.value() * x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    asin(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::asin(x.value()), x, T{1} / dnn::sqrt(T{1} - x.value() * x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    acos(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::acos(x.value()), x, T{-1} / dnn::sqrt(T{1} - x.value() * x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    atan2(const hdual<T, K>& y, const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> r2 = x.value() * x.value() + y.value() * y.value();
+        return hdual<T, K>::apply(dnn::atan2(y.value(), x.value()), y, x.value() / r2, x, -y.value() / r2);
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    hypot(const hdual<T, K>& x, const hdual<T, K>& y)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> h = dnn::hypot(x.value(), y.value());
+        return hdual<T, K>::apply(h, x, x.value() / h, y, y.value() / h);
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    sinh(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::sinh(x.value()), x, dnn::cosh(x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    cosh(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::cosh(x.value()), x, dnn::sinh(x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    tanh(const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> t = dnn::tanh(x.value());
+        return hdual<T, K>::apply(t, x, T{1} - t * t);
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    log1p(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::log1p(x.value()), x, T{1} / (T{1} + x.value())); }
+
+    template<typename T, std::size_t K>
+    auto
+    expm1(const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> m = dnn::expm1(x.value());
+        return hdual<T, K>::apply(m, x, m + T{1});
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    cbrt(const hdual<T, K>& x)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> c = dnn::cbrt(x.value());
+        return hdual<T, K>::apply(c, x, T{1} / (T{3} * c * c));
+    }
+
+    // the second derivative is zero away from the kink
+    template<typename T, std::size_t K>
+    auto
+    abs(const hdual<T, K>& x)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::abs(x.value()), x, mdual<T, K>{static_cast<T>((T{} < x.re()) - (x.re() < T{}))}); }
+
+    template<typename T, std::size_t K>
+    auto
+    pow(const hdual<T, K>& x, const std::type_identity_t<T>& n)
+        -> hdual<T, K>
+    { return hdual<T, K>::apply(dnn::pow(x.value(), n), x, n * dnn::pow(x.value(), n - T{1})); }
+
+    template<typename T, std::size_t K>
+    auto
+    pow(const std::type_identity_t<T>& x, const hdual<T, K>& n)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> p = dnn::pow(x, n.value());
+        return hdual<T, K>::apply(p, n, p * std::log(x));
+    }
+
+    template<typename T, std::size_t K>
+    auto
+    pow(const hdual<T, K>& x, const hdual<T, K>& n)
+        -> hdual<T, K>
+    {
+        const mdual<T, K> p = dnn::pow(x.value(), n.value());
+        return hdual<T, K>::apply(p, x, n.value() * dnn::pow(x.value(), n.value() - mdual<T, K>{T{1}}), n, p * dnn::log(x.value()));
+    }
+    ///@}   elementary functions of hduals
+
+    template<typename T, std::size_t K>
+    struct hvp_result
+    {
+        T value;
+        std::vector<T> gradient;
+        // hv[k] is H v_k
+        std::array<std::vector<T>, K> hv;
+    };
+
+    // f, taking a const std::vector<hdual<T, K>>& and returning hdual<T, K>,
+    // its gradient and its Hessian times each of the K directions v, at x.
+    template<typename T, std::size_t K, typename function_type>
+    auto
+    hvp(function_type&& f, std::span<const std::type_identity_t<T>> x, const std::array<std::span<const std::type_identity_t<T>>, K>& v)
+        -> hvp_result<T, K>
+    {
+        for (const auto& direction : v)
+            if (direction.size() != x.size())
+                throw std::invalid_argument("dnn: hvp needs directions as long as x");
+
+        using value_type = mdual<T, K>;
+        thread_local tape<value_type> t;
+        t.clear();
+        typename tape<value_type>::recording active{t};
+
+        std::vector<hdual<T, K>> inputs;
+        inputs.reserve(x.size());
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            typename value_type::tangent_type d;
+            for (std::size_t k = 0; k < K; ++k)
+                d[k] = v[k][i];
+            inputs.push_back(hdual<T, K>::variable(t, value_type{x[i], d}));
+        }
+        const hdual<T, K> y = f(static_cast<const std::vector<hdual<T, K>>&>(inputs));
+
+        t.seed(y.index(), value_type{T{1}});
+        t.reverse();
+
+        hvp_result<T, K> r{y.re(), std::vector<T>(x.size()), {}};
+        for (auto& h : r.hv)
+            h.resize(x.size());
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            const value_type a = t.adjoint(inputs[i].index());
+            r.gradient[i] = a.re();
+            for (std::size_t k = 0; k < K; ++k)
+                r.hv[k][i] = a.d(k);
+        }
+        return r;
+    }
+
+    // a single direction
+    template<typename T, typename function_type>
+    auto
+    hvp(function_type&& f, std::span<const std::type_identity_t<T>> x, std::span<const std::type_identity_t<T>> v)
+        -> hvp_result<T, 1>
+    { return hvp<T, 1>(std::forward<function_type>(f), x, std::array<std::span<const T>, 1>{v}); }
+
+}  /// namespace dnn
+
+#endif  /// DUAL_HESSIAN
@@ -0,0 +1,661 @@
+#ifndef DUAL_LAZY
+#   define DUAL_LAZY
+
+#include <dual_numbers.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace dnn
+{
+    // Duals whose tangent is computed only when it is read.
+    //
+    // A lazy_dual carries its real part and the index of a node on a per-thread
+    // tape. Every operation computes the value as usual and appends a node with
+    // the operation and its argument values, nothing derivative related. d()
+    // collects the nodes the requested one depends on, computes their local
+    // partials and chains them forward in tape order, and caches the result, so
+    // reading the tangents of a few outputs costs only their share of the graph
+    // and reading none costs nothing beyond the tape.
+    //
+    // Constants and values that do not depend on a seed carry no node, and x + c
+    // or c + x reuse the node of x, so constant folding happens on the fly.
+    //
+    // The tape belongs to the thread that created the values, a lazy_dual must
+    // not be read on another thread. It grows until it is rewound, either by a
+    // lazy_scope or by lazy_tape::clear(); values recorded after the rewind
+    // point are invalid from then on.
+
+    enum class lazy_op : std::uint8_t
+    {
+        seed,
+        add, sub, mul, div, neg,
+        sqrt, sin, cos, tan, exp, log, pow,
+        acos, asin, atan, hypot,
+        sinh, cosh, tanh, atan2,
+        log1p, expm1, cbrt, abs
+    };
+
+    template<typename T>
+    class lazy_tape
+    {
+    public:
+
+        using base_real_type = T;
+        using index_type = std::uint32_t;
+
+        static constexpr index_type none = std::numeric_limits<index_type>::max();
+
+        // An operation with its argument values. A constant argument has index
+        // none and its value in the value slot; a seed keeps its tangent in a_value.
+        struct node
+        {
+            base_real_type a_value;
+            base_real_type b_value;
+            base_real_type value;
+            index_type a;
+            index_type b;
+            lazy_op op;
+        };
+
+    public:
+
+        // the tape of the calling thread
+        static auto
+        local() noexcept
+            -> lazy_tape&
+        {
+            thread_local lazy_tape tape;
+            return tape;
+        }
+
+        auto
+        record(lazy_op op, index_type a, const base_real_type& a_value,
+               index_type b, const base_real_type& b_value, const base_real_type& value)
+            -> index_type
+        {
+            m_nodes.push_back(node{a_value, b_value, value, a, b, op});
+            return static_cast<index_type>(m_nodes.size() - 1);
+        }
+
+        // The tangent of node k, replaying only its ancestors that have not been
+        // replayed before.
+        auto
+        tangent(index_type k)
+            -> base_real_type
+        {
+            if (m_state.size() < m_nodes.size())
+            {
+                m_state.resize(m_nodes.size(), unknown);
+                m_tangents.resize(m_nodes.size());
+            }
+            if (m_state[k] == done)
+                return m_tangents[k];
+
+            // gather the ancestors still to do; arguments always precede their
+            // node, so ascending index order is a valid evaluation order
+            m_work.clear();
+            m_work.push_back(k);
+            m_state[k] = queued;
+            for (std::size_t i = 0; i < m_work.size(); ++i)
+            {
+                const node& n = m_nodes[m_work[i]];
+                for (const index_type arg : {n.a, n.b})
+                {
+                    if (arg != none && m_state[arg] == unknown)
+                    {
+                        m_state[arg] = queued;
+                        m_work.push_back(arg);
+                    }
+                }
+            }
+            std::sort(m_work.begin(), m_work.end());
+
+            for (const index_type i : m_work)
+            {
+                const node& n = m_nodes[i];
+                base_real_type t{};
+                if (n.op == lazy_op::seed)
+                    t = n.a_value;
+                else
+                {
+                    if (n.a != none)
+                        t += partial_a(n) * m_tangents[n.a];
+                    if (n.b != none)
+                        t += partial_b(n) * m_tangents[n.b];
+                }
+                m_tangents[i] = t;
+                m_state[i] = done;
+            }
+            m_replayed += m_work.size();
+            return m_tangents[k];
+        }
+
+        auto
+        size() const noexcept
+            -> std::size_t
+        { return m_nodes.size(); }
+
+        // number of node tangents computed since the tape was created
+        auto
+        replayed() const noexcept
+            -> std::size_t
+        { return m_replayed; }
+
+        // drops the nodes from n on
+        auto
+        rewind(std::size_t n)
+            -> void
+        {
+            if (n >= m_nodes.size())
+                return;
+            m_nodes.resize(n);
+            if (m_state.size() > n)
+            {
+                m_state.resize(n);
+                m_tangents.resize(n);
+            }
+        }
+
+        auto
+        clear()
+            -> void
+        { rewind(0); }
+
+    private:
+
+        lazy_tape() = default;
+
+        enum : std::uint8_t { unknown, queued, done };
+
+        // d value / d a
+        static auto
+        partial_a(const node& n) noexcept
+            -> base_real_type
+        {
+            const base_real_type one{1};
+            const base_real_type& x = n.a_value;
+            const base_real_type& r = n.value;
+            switch (n.op)
+            {
+            case lazy_op::add:   return one;
+            case lazy_op::sub:   return one;
+            case lazy_op::mul:   return n.b_value;
+            case lazy_op::div:   return one / n.b_value;
+            case lazy_op::neg:   return -one;
+            case lazy_op::sqrt:  return one / (base_real_type{2} * r);
+            case lazy_op::sin:   return std::cos(x);
+            case lazy_op::cos:   return -std::sin(x);
+            case lazy_op::tan:   return one + r * r;
+            case lazy_op::exp:   return r;
+            case lazy_op::log:   return one / x;
+            case lazy_op::pow:   return n.b_value * std::pow(x, n.b_value - one);
+            case lazy_op::acos:  return -one / std::sqrt((one - x) * (one + x));
+            case lazy_op::asin:  return one / std::sqrt((one - x) * (one + x));
+            case lazy_op::atan:  return one / (one + x * x);
+            case lazy_op::hypot: return x / r;
+            case lazy_op::sinh:  return std::cosh(x);
+            case lazy_op::cosh:  return std::sinh(x);
+            case lazy_op::tanh:  { const base_real_type c = std::cosh(x); return one / (c * c); }
+            case lazy_op::atan2: return detail::atan2_tangent(x, n.b_value, one, base_real_type{});
+            case lazy_op::log1p: return one / (one + x);
+            case lazy_op::expm1: return std::exp(x);
+            case lazy_op::cbrt:  return one / (base_real_type{3} * r * r);
+            case lazy_op::abs:   return static_cast<base_real_type>((base_real_type{} < x) - (x < base_real_type{}));
+            default:             return base_real_type{};
+            }
+        }
+
+        // d value / d b, for the binary operations
+        static auto
+        partial_b(const node& n) noexcept
+            -> base_real_type
+        {
+            const base_real_type one{1};
+            switch (n.op)
+            {
+            case lazy_op::add:   return one;
+            case lazy_op::sub:   return -one;
+            case lazy_op::mul:   return n.a_value;
+            case lazy_op::div:   return -n.value / n.b_value;
+            case lazy_op::pow:   return n.value * std::log(n.a_value);
+            case lazy_op::hypot: return n.b_value / n.value;
+            case lazy_op::atan2: return detail::atan2_tangent(n.a_value, n.b_value, base_real_type{}, one);
+            default:             return base_real_type{};
+            }
+        }
+
+        std::vector<node> m_nodes;
+        std::vector<base_real_type> m_tangents;     // only grown once a tangent is read
+        std::vector<std::uint8_t> m_state;
+        std::vector<index_type> m_work;
+        std::size_t m_replayed = 0;
+    };
+
+    // Rewinds the calling thread's tape to where it was on construction.
+    template<typename T>
+    class lazy_scope
+    {
+    public:
+
+        lazy_scope() noexcept
+            : m_mark{ lazy_tape<T>::local().size() }
+        { }
+
+        lazy_scope(const lazy_scope&) = delete;
+        auto operator= (const lazy_scope&) -> lazy_scope& = delete;
+
+        ~lazy_scope()
+        { lazy_tape<T>::local().rewind(m_mark); }
+
+    private:
+
+        std::size_t m_mark;
+    };
+
+    template<typename T>
+    class lazy_dual
+    {
+    public:
+
+        using base_real_type = T;
+        using tape_type = lazy_tape<T>;
+        using index_type = typename tape_type::index_type;
+
+        static_assert(std::is_floating_point_v<base_real_type>, "lazy duals are over floating point types");
+
+    public:
+
+        // a nonzero d seeds a new input
+        explicit
+        lazy_dual(const base_real_type& re = base_real_type{}, const base_real_type& d = base_real_type{})
+            : m_re{ re }
+            , m_node{ d == base_real_type{} ? tape_type::none
+                                            : tape_type::local().record(lazy_op::seed, tape_type::none, d, tape_type::none, base_real_type{}, re) }
+        { }
+
+        lazy_dual(const lazy_dual&) noexcept = default;
+        lazy_dual(lazy_dual&&) noexcept      = default;
+
+        auto operator= (const lazy_dual&) noexcept -> lazy_dual&   = default;
+        auto operator= (lazy_dual&&) noexcept -> lazy_dual&        = default;
+
+        auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_re; }
+
+        // materialises the tangent
+        auto
+        d() const
+            -> base_real_type
+        { return m_node == tape_type::none ? base_real_type{} : tape_type::local().tangent(m_node); }
+
+        auto
+        node() const noexcept
+            -> index_type
+        { return m_node; }
+
+        // true if the value depends on a seed
+        auto
+        active() const noexcept
+            -> bool
+        { return m_node != tape_type::none; }
+
+        auto
+        eager() const
+            -> dual<base_real_type>
+        { return dual<base_real_type>{m_re, d()}; }
+
+        // Records op on the arguments unless neither is active, then the
+        // result is a constant.
+        static auto
+        apply(lazy_op op, const lazy_dual& a, const lazy_dual& b, const base_real_type& value)
+            -> lazy_dual
+        {
+            if (!a.active() && !b.active())
+                return lazy_dual{value};
+            return lazy_dual{value, tape_type::local().record(op, a.m_node, a.m_re, b.m_node, b.m_re, value), node_tag{}};
+        }
+
+        static auto
+        apply(lazy_op op, const lazy_dual& a, const base_real_type& value)
+            -> lazy_dual
+        {
+            if (!a.active())
+                return lazy_dual{value};
+            return lazy_dual{value, tape_type::local().record(op, a.m_node, a.m_re, tape_type::none, base_real_type{}, value), node_tag{}};
+        }
+
+        ///{@  lazy dual unary arithmetic
+        auto
+        operator+= (const lazy_dual& v)
+            -> lazy_dual&
+        { return *this = *this + v; }
+
+        auto
+        operator-= (const lazy_dual& v)
+            -> lazy_dual&
+        { return *this = *this - v; }
+
+        auto
+        operator*= (const lazy_dual& v)
+            -> lazy_dual&
+        { return *this = *this * v; }
+
+        auto
+        operator/= (const lazy_dual& v)
+            -> lazy_dual&
+        { return *this = *this / v; }
+
+        auto
+        operator+= (const base_real_type& v)
+            -> lazy_dual&
+        { return *this = *this + v; }
+
+        auto
+        operator-= (const base_real_type& v)
+            -> lazy_dual&
+        { return *this = *this - v; }
+
+        auto
+        operator*= (const base_real_type& v)
+            -> lazy_dual&
+        { return *this = *this * v; }
+
+        auto
+        operator/= (const base_real_type& v)
+            -> lazy_dual&
+        { return *this = *this / v; }
+        ///@}  lazy dual unary arithmetic
+
+        ///{@  lazy dual arithmetic
+        // defined as friends so that plain numbers convert to base_real_type
+        friend auto
+        operator+ (const lazy_dual& u)
+            -> lazy_dual
+        { return u; }
+
+        friend auto
+        operator- (const lazy_dual& u)
+            -> lazy_dual
+        { return apply(lazy_op::neg, u, -u.m_re); }
+
+        friend auto
+        operator+ (const lazy_dual& u, const lazy_dual& v)
+            -> lazy_dual
+        {
+            if (!v.active())
+                return lazy_dual{u.m_re + v.m_re, u.m_node, node_tag{}};
+            if (!u.active())
+                return lazy_dual{u.m_re + v.m_re, v.m_node, node_tag{}};
+            return apply(lazy_op::add, u, v, u.m_re + v.m_re);
+        }
+
+        friend auto
+        operator- (const lazy_dual& u, const lazy_dual& v)
+            -> lazy_dual
+        {
+            if (!v.active())
+                return lazy_dual{u.m_re - v.m_re, u.m_node, node_tag{}};
+            return apply(lazy_op::sub, u, v, u.m_re - v.m_re);
+        }
+
+        friend auto
+        operator* (const lazy_dual& u, const lazy_dual& v)
+            -> lazy_dual
+        { return apply(lazy_op::mul, u, v, u.m_re * v.m_re); }
+
+        friend auto
+        operator/ (const lazy_dual& u, const lazy_dual& v)
+            -> lazy_dual
+        { return apply(lazy_op::div, u, v, u.m_re / v.m_re); }
+
+        friend auto
+        operator+ (const lazy_dual& u, const base_real_type& v)
+            -> lazy_dual
+        { return lazy_dual{u.m_re + v, u.m_node, node_tag{}}; }
+
+        friend auto
+        operator+ (const base_real_type& u, const lazy_dual& v)
+            -> lazy_dual
+        { return lazy_dual{u + v.m_re, v.m_node, node_tag{}}; }
+
+        friend auto
+        operator- (const lazy_dual& u, const base_real_type& v)
+            -> lazy_dual
+        { return lazy_dual{u.m_re - v, u.m_node, node_tag{}}; }
+
+        friend auto
+        operator- (const base_real_type& u, const lazy_dual& v)
+            -> lazy_dual
+        { return apply(lazy_op::neg, v, u - v.m_re); }
+
+        friend auto
+        operator* (const lazy_dual& u, const base_real_type& v)
+            -> lazy_dual
+        { return apply(lazy_op::mul, u, lazy_dual{v}, u.m_re * v); }
+
+        friend auto
+        operator* (const base_real_type& u, const lazy_dual& v)
+            -> lazy_dual
+        { return apply(lazy_op::mul, lazy_dual{u}, v, u * v.m_re); }
+
+        friend auto
+        operator/ (const lazy_dual& u, const base_real_type& v)
+            -> lazy_dual
+        { return apply(lazy_op::div, u, lazy_dual{v}, u.m_re / v); }
+
+        friend auto
+        operator/ (const base_real_type& u, const lazy_dual& v)
+            -> lazy_dual
+        { return apply(lazy_op::div, lazy_dual{u}, v, u / v.m_re); }
+        ///@}  lazy dual arithmetic
+
+        ///{@   lazy dual comparison operators
+        // on the real part, like dual
+        friend auto
+        operator== (const lazy_dual& u, const lazy_dual& v) noexcept
+            -> bool
+        { return u.m_re == v.m_re; }
+
+        friend auto
+        operator<=> (const lazy_dual& u, const lazy_dual& v) noexcept
+        { return u.m_re <=> v.m_re; }
+
+        friend auto
+        operator== (const lazy_dual& u, const base_real_type& v) noexcept
+            -> bool
+        { return u.m_re == v; }
+
+        friend auto
+        operator<=> (const lazy_dual& u, const base_real_type& v) noexcept
+        { return u.m_re <=> v; }
+        ///@}   lazy dual comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const lazy_dual& v)
+            -> std::ostream&
+        {
+            os << v.m_re << " + " << v.d() << "_eps";
+            return os;
+        }
+        ///@}   ostream
+
+    private:
+
+        struct node_tag { };
+
+        lazy_dual(const base_real_type& re, index_type node, node_tag) noexcept
+            : m_re{ re }
+            , m_node{ node }
+        { }
+
+        base_real_type m_re;
+        index_type m_node;
+    };
+
+    ///{@   elementary functions of lazy duals
+    // Only the values are computed here, the partials when a tangent is read.
+    template<typename T>
+    auto
+    sqrt(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::sqrt, x, std::sqrt(x.re())); }
+
+    template<typename T>
+    auto
+    sin(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::sin, x, std::sin(x.re())); }
+
+    template<typename T>
+    auto
+    cos(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::cos, x, std::cos(x.re())); }
+
+    template<typename T>
+    auto
+    tan(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::tan, x, std::tan(x.re())); }
+
+    template<typename T>
+    auto
+    exp(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::exp, x, std::exp(x.re())); }
+
+    template<typename T>
+    auto
+    log(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::log, x, std::log(x.re())); }
+
+    template<typename T>
+    auto
+    pow(const lazy_dual<T>& x, const lazy_dual<T>& n)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::pow, x, n, std::pow(x.re(), n.re())); }
+
+    template<typename T>
+    auto
+    pow(const lazy_dual<T>& x, const std::type_identity_t<T>& n)
+        -> lazy_dual<T>
+    { return pow(x, lazy_dual<T>{n}); }
+
+    template<typename T>
+    auto
+    pow(const std::type_identity_t<T>& x, const lazy_dual<T>& n)
+        -> lazy_dual<T>
+    { return pow(lazy_dual<T>{x}, n); }
+
+    template<typename T>
+    auto
+    acos(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::acos, x, std::acos(x.re())); }
+
+    template<typename T>
+    auto
+    asin(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::asin, x, std::asin(x.re())); }
+
+    template<typename T>
+    auto
+    atan(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::atan, x, std::atan(x.re())); }
+
+    template<typename T>
+    auto
+    hypot(const lazy_dual<T>& x, const lazy_dual<T>& y)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::hypot, x, y, std::hypot(x.re(), y.re())); }
+
+    template<typename T>
+    auto
+    hypot(const lazy_dual<T>& x, const std::type_identity_t<T>& y)
+        -> lazy_dual<T>
+    { return hypot(x, lazy_dual<T>{y}); }
+
+    template<typename T>
+    auto
+    hypot(const std::type_identity_t<T>& x, const lazy_dual<T>& y)
+        -> lazy_dual<T>
+    { return hypot(lazy_dual<T>{x}, y); }
+
+    template<typename T>
+    auto
+    sinh(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::sinh, x, std::sinh(x.re())); }
+
+    template<typename T>
+    auto
+    cosh(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::cosh, x, std::cosh(x.re())); }
+
+    template<typename T>
+    auto
+    tanh(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::tanh, x, std::tanh(x.re())); }
+
+    template<typename T>
+    auto
+    atan2(const lazy_dual<T>& y, const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::atan2, y, x, std::atan2(y.re(), x.re())); }
+
+    template<typename T>
+    auto
+    atan2(const lazy_dual<T>& y, const std::type_identity_t<T>& x)
+        -> lazy_dual<T>
+    { return atan2(y, lazy_dual<T>{x}); }
+
+    template<typename T>
+    auto
+    atan2(const std::type_identity_t<T>& y, const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return atan2(lazy_dual<T>{y}, x); }
+
+    template<typename T>
+    auto
+    log1p(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::log1p, x, std::log1p(x.re())); }
+
+    template<typename T>
+    auto
+    expm1(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::expm1, x, std::expm1(x.re())); }
+
+    template<typename T>
+    auto
+    cbrt(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::cbrt, x, std::cbrt(x.re())); }
+
+    template<typename T>
+    auto
+    abs(const lazy_dual<T>& x)
+        -> lazy_dual<T>
+    { return lazy_dual<T>::apply(lazy_op::abs, x, std::abs(x.re())); }
+    ///@}   elementary functions of lazy duals
+
+}  /// namespace dnn
+
+#endif  /// DUAL_LAZY
@@ -0,0 +1,275 @@
+#ifndef DUAL_LINALG
+#   define DUAL_LINALG
+
+#include <dual_numbers.hxx>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace dnn
+{
+    // Dense kernels for matrices and vectors of dual numbers.
+    //
+    // All matrices are row-major arrays of dual<T> with a leading dimension,
+    // in the same spirit as BLAS. A product of dual matrices
+    //
+    //      C = (Ar + Ad eps) (Br + Bd eps) = Ar Br + (Ar Bd + Ad Br) eps
+    //
+    // is three real products. Instead of going through dual::operator* per
+    // element we split the operands into real and tangent planes once, while
+    // packing, and let the micro kernel compute all three products from the
+    // same loads of Ar and Br.
+
+    namespace linalg_detail
+    {
+        // register tile of the micro kernel, MR rows of A times NR columns of B
+        inline constexpr std::size_t mr = 4;
+        inline constexpr std::size_t nr = 8;
+
+        // cache blocks, sized so a packed A block stays in L2 and
+        // a packed sliver of B stays in L1 (counted in dual elements)
+        inline constexpr std::size_t mc = 64;
+        inline constexpr std::size_t kc = 128;
+        inline constexpr std::size_t nc = 1024;
+
+        // Packs the mc x kc block of A starting at a into slivers of mr rows.
+        // Each sliver is stored k-major, real and tangent planes separately,
+        // rows past the edge of A are zero padded.
+        template<typename base_real_type>
+        auto
+        pack_a(std::size_t m, std::size_t k, const dual<base_real_type>* a, std::size_t lda,
+               base_real_type* a_re, base_real_type* a_d) noexcept
+            -> void
+        {
+            for (std::size_t i0 = 0; i0 < m; i0 += mr)
+            {
+                const std::size_t rows = std::min(mr, m - i0);
+                for (std::size_t p = 0; p < k; ++p)
+                {
+                    for (std::size_t i = 0; i < mr; ++i)
+                    {
+                        if (i < rows)
+                        {
+                            const auto& v = a[(i0 + i) * lda + p];
+                            a_re[i] = v.re();
+                            a_d[i]  = v.d();
+                        }
+                        else
+                        {
+                            a_re[i] = base_real_type{};
+                            a_d[i]  = base_real_type{};
+                        }
+                    }
+                    a_re += mr;
+                    a_d  += mr;
+                }
+            }
+        }
+
+        // Packs the kc x nc panel of B starting at b into slivers of nr columns,
+        // stored k-major with real and tangent planes separately.
+        template<typename base_real_type>
+        auto
+        pack_b(std::size_t k, std::size_t n, const dual<base_real_type>* b, std::size_t ldb,
+               base_real_type* b_re, base_real_type* b_d) noexcept
+            -> void
+        {
+            for (std::size_t j0 = 0; j0 < n; j0 += nr)
+            {
+                const std::size_t cols = std::min(nr, n - j0);
+                for (std::size_t p = 0; p < k; ++p)
+                {
+                    const dual<base_real_type>* row = b + p * ldb + j0;
+                    for (std::size_t j = 0; j < nr; ++j)
+                    {
+                        if (j < cols)
+                        {
+                            b_re[j] = row[j].re();
+                            b_d[j]  = row[j].d();
+                        }
+                        else
+                        {
+                            b_re[j] = base_real_type{};
+                            b_d[j]  = base_real_type{};
+                        }
+                    }
+                    b_re += nr;
+                    b_d  += nr;
+                }
+            }
+        }
+
+        // Computes an mr x nr tile of C from one sliver of packed A and one of packed B.
+        // Every loaded a_re is used for both Ar Br and Ar Bd, every loaded b_re for both
+        // Ar Br and Ad Br. When accumulate is false the tile overwrites C.
+        template<typename base_real_type>
+        auto
+        micro_kernel(std::size_t k,
+                     const base_real_type* a_re, const base_real_type* a_d,
+                     const base_real_type* b_re, const base_real_type* b_d,
+                     dual<base_real_type>* c, std::size_t ldc,
+                     std::size_t rows, std::size_t cols, bool accumulate) noexcept
+            -> void
+        {
+            base_real_type c_re[mr][nr] = {};
+            base_real_type c_d[mr][nr]  = {};
+
+            for (std::size_t p = 0; p < k; ++p)
+            {
+                for (std::size_t i = 0; i < mr; ++i)
+                {
+                    const base_real_type ar = a_re[i];
+                    const base_real_type ad = a_d[i];
+                    for (std::size_t j = 0; j < nr; ++j)
+                    {
+                        c_re[i][j] += ar * b_re[j];
+                        c_d[i][j]  += ar * b_d[j] + ad * b_re[j];
+                    }
+                }
+                a_re += mr;
+                a_d  += mr;
+                b_re += nr;
+                b_d  += nr;
+            }
+
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                dual<base_real_type>* row = c + i * ldc;
+                for (std::size_t j = 0; j < cols; ++j)
+                {
+                    if (accumulate)
+                    {
+                        row[j].re() += c_re[i][j];
+                        row[j].d()  += c_d[i][j];
+                    }
+                    else
+                    {
+                        row[j].re() = c_re[i][j];
+                        row[j].d()  = c_d[i][j];
+                    }
+                }
+            }
+        }
+    }  /// namespace linalg_detail
+
+    ///{@   matrix kernels
+    // C (m x n) = A (m x k) * B (k x n), overwriting C.
+    template<typename base_real_type>
+    auto
+    gemm(std::size_t m, std::size_t n, std::size_t k,
+         const dual<base_real_type>* a, std::size_t lda,
+         const dual<base_real_type>* b, std::size_t ldb,
+         dual<base_real_type>* c, std::size_t ldc)
+        -> void
+    {
+        using namespace linalg_detail;
+
+        if (k == 0)
+        {
+            for (std::size_t i = 0; i < m; ++i)
+                std::fill_n(c + i * ldc, n, dual<base_real_type>{});
+            return;
+        }
+
+        // packed buffers are rounded up to whole slivers
+        std::vector<base_real_type> a_re(mc * kc), a_d(mc * kc);
+        std::vector<base_real_type> b_re(kc * (nc + nr)), b_d(kc * (nc + nr));
+
+        for (std::size_t jc = 0; jc < n; jc += nc)
+        {
+            const std::size_t nb = std::min(nc, n - jc);
+            for (std::size_t pc = 0; pc < k; pc += kc)
+            {
+                const std::size_t kb = std::min(kc, k - pc);
+                pack_b(kb, nb, b + pc * ldb + jc, ldb, b_re.data(), b_d.data());
+
+                for (std::size_t ic = 0; ic < m; ic += mc)
+                {
+                    const std::size_t mb = std::min(mc, m - ic);
+                    pack_a(mb, kb, a + ic * lda + pc, lda, a_re.data(), a_d.data());
+
+                    for (std::size_t jr = 0; jr < nb; jr += nr)
+                    {
+                        for (std::size_t ir = 0; ir < mb; ir += mr)
+                        {
+                            micro_kernel(kb,
+                                         a_re.data() + ir * kb, a_d.data() + ir * kb,
+                                         b_re.data() + jr * kb, b_d.data() + jr * kb,
+                                         c + (ic + ir) * ldc + jc + jr, ldc,
+                                         std::min(mr, mb - ir), std::min(nr, nb - jr),
+                                         pc != 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    ///@}   matrix kernels
+
+    ///{@   vector kernels
+    // y (m) = A (m x n) * x (n), overwriting y.
+    // Four rows are processed together so each load of x feeds four rows of A.
+    template<typename base_real_type>
+    auto
+    gemv(std::size_t m, std::size_t n,
+         const dual<base_real_type>* a, std::size_t lda,
+         const dual<base_real_type>* x,
+         dual<base_real_type>* y) noexcept
+        -> void
+    {
+        constexpr std::size_t rows = 4;
+
+        std::size_t i = 0;
+        for (; i + rows <= m; i += rows)
+        {
+            base_real_type y_re[rows] = {};
+            base_real_type y_d[rows]  = {};
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                const base_real_type xr = x[j].re();
+                const base_real_type xd = x[j].d();
+                for (std::size_t r = 0; r < rows; ++r)
+                {
+                    const auto& v = a[(i + r) * lda + j];
+                    y_re[r] += v.re() * xr;
+                    y_d[r]  += v.re() * xd + v.d() * xr;
+                }
+            }
+            for (std::size_t r = 0; r < rows; ++r)
+                y[i + r] = dual<base_real_type>{y_re[r], y_d[r]};
+        }
+        for (; i < m; ++i)
+        {
+            base_real_type y_re{};
+            base_real_type y_d{};
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                const auto& v = a[i * lda + j];
+                y_re += v.re() * x[j].re();
+                y_d  += v.re() * x[j].d() + v.d() * x[j].re();
+            }
+            y[i] = dual<base_real_type>{y_re, y_d};
+        }
+    }
+
+    // y (n) += alpha * x (n)
+    template<typename base_real_type>
+    auto
+    axpy(std::size_t n, const dual<base_real_type>& alpha,
+         const dual<base_real_type>* x, dual<base_real_type>* y) noexcept
+        -> void
+    {
+        const base_real_type ar = alpha.re();
+        const base_real_type ad = alpha.d();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            y[i].d()  += ar * x[i].d() + ad * x[i].re();
+            y[i].re() += ar * x[i].re();
+        }
+    }
+    ///@}   vector kernels
+
+}  /// namespace dnn
+
+#endif  /// DUAL_LINALG
@@ -0,0 +1,230 @@
+#ifndef DUAL_MONTECARLO
+#   define DUAL_MONTECARLO
+
+#include <dual_multi.hxx>
+#include <dual_reduce.hxx>
+#include <dual_sweep.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace dnn
+{
+    // Pathwise Monte-Carlo sensitivities of Black-Scholes paths.
+    //
+    // The spot, volatility and rate are the three inputs of an mdual<T, 3>, so
+    // a single simulation carries the price together with its pathwise delta,
+    // vega and rho; bumping and repricing costs a simulation per Greek, or
+    // two for central differences. The estimators are unbiased for payoffs
+    // that are Lipschitz in the path, such as calls, puts and Asian options,
+    // but not for digitals, whose pathwise derivative is 0 almost everywhere.
+    //
+    // Paths are simulated in log space, S(t) = S0 exp((r - s^2/2) t + s W(t)),
+    // at steps equally spaced monitoring dates. The Brownian increments come
+    // from Philox4x32-10, a counter-based generator: the normals of path p at
+    // step k are a pure function of (seed, p, k), so results do not depend on
+    // the order paths are run in, nor on the number of threads.
+    //
+    // Paths are run in batches of `lanes` in lockstep, the Brownian motions
+    // of a batch being advanced as plain arrays; each block of paths sums the
+    // discounted payoffs, their tangents and their squares with Neumaier
+    // compensated sums (dual_reduce.hxx), and the blocks, a fixed number of
+    // them whatever the pool size, are combined in a fixed order.
+
+    ///{@   counter-based random numbers
+    // Philox4x32 with 10 rounds (Salmon et al., SC11), as in Random123.
+    inline constexpr auto
+    philox4x32(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key) noexcept
+        -> std::array<std::uint32_t, 4>
+    {
+        for (int round = 0; round < 10; ++round)
+        {
+            const std::uint64_t a = std::uint64_t{0xD2511F53} * counter[0];
+            const std::uint64_t b = std::uint64_t{0xCD9E8D57} * counter[2];
+            counter = {static_cast<std::uint32_t>(b >> 32) ^ counter[1] ^ key[0], static_cast<std::uint32_t>(b),
+                       static_cast<std::uint32_t>(a >> 32) ^ counter[3] ^ key[1], static_cast<std::uint32_t>(a)};
+            key[0] += 0x9E3779B9;
+            key[1] += 0xBB67AE85;
+        }
+        return counter;
+    }
+
+    // Two independent standard normals, the Box-Muller transform of the two
+    // uniforms in (0, 1) made of the 53 high bits of each half of the block.
+    template<typename T>
+    auto
+    normal_pair(std::uint64_t seed, std::uint64_t stream, std::uint64_t index) noexcept
+        -> std::array<T, 2>
+    {
+        const auto r = philox4x32({static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32),
+                                   static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32)},
+                                  {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)});
+        constexpr double unit = 0x1p-53;
+        const double u = (static_cast<double>(((std::uint64_t{r[0]} << 32) | r[1]) >> 11) + 0.5) * unit;
+        const double v = (static_cast<double>(((std::uint64_t{r[2]} << 32) | r[3]) >> 11) + 0.5) * unit;
+        const double radius = std::sqrt(-2.0 * std::log(u));
+        const double angle = 2.0 * std::numbers::pi * v;
+        return {static_cast<T>(radius * std::cos(angle)), static_cast<T>(radius * std::sin(angle))};
+    }
+    ///@}   counter-based random numbers
+
+    // A Black-Scholes market and the simulation run on it.
+    template<typename T>
+    struct monte_carlo_setup
+    {
+        T spot{};
+        T volatility{};
+        T rate{};
+        T maturity{};
+        // monitoring dates, maturity / steps apart
+        std::size_t steps = 1;
+        std::size_t paths = 0;
+        std::uint64_t seed = 0;
+    };
+
+    // The discounted expected payoff, its pathwise sensitivities to the spot,
+    // volatility and rate, and the standard error of each estimate.
+    template<typename T>
+    struct greeks_result
+    {
+        T price{};
+        T delta{};
+        T vega{};
+        T rho{};
+        std::array<T, 4> standard_error{};
+        std::size_t paths = 0;
+    };
+
+    namespace montecarlo_detail
+    {
+        inline constexpr std::size_t lanes = 8;
+
+        // sums of the discounted payoff and its three tangents, and of their squares
+        template<typename T>
+        struct block_sums
+        {
+            using accumulator = reduce_detail::accumulator<T, true>;
+
+            std::array<accumulator, 4> sum{};
+            std::array<accumulator, 4> squares{};
+
+            auto
+            add(const mdual<T, 3>& v) noexcept
+                -> void
+            {
+                for (std::size_t k = 0; k < 4; ++k)
+                {
+                    const T x = k == 0 ? v.re() : v.d(k - 1);
+                    sum[k].add(x);
+                    squares[k].add_product(x, x);
+                }
+            }
+
+            auto
+            merge(const block_sums& other) noexcept
+                -> void
+            {
+                for (std::size_t k = 0; k < 4; ++k)
+                {
+                    sum[k].merge(other.sum[k]);
+                    squares[k].merge(other.squares[k]);
+                }
+            }
+        };
+    }  /// namespace montecarlo_detail
+
+    // Prices payoff over setup.paths paths and returns the price with its
+    // delta, vega and rho. payoff takes the path as a
+    // std::span<const mdual<T, 3>> of the spot at each monitoring date and
+    // returns the undiscounted payoff as mdual<T, 3>.
+    template<typename T, typename payoff_type>
+    auto
+    monte_carlo_greeks(const monte_carlo_setup<T>& setup, payoff_type payoff, sweep_pool& pool = sweep_pool::shared())
+        -> greeks_result<T>
+    {
+        using number = mdual<T, 3>;
+        using montecarlo_detail::lanes;
+
+        if (setup.paths == 0 || setup.steps == 0)
+            throw std::invalid_argument("dnn: monte_carlo_greeks needs at least one path and one step");
+
+        const std::size_t steps = setup.steps;
+        const T dt = setup.maturity / static_cast<T>(steps);
+        const T root_dt = std::sqrt(dt);
+
+        const number spot = number::variable(setup.spot, 0);
+        const number volatility = number::variable(setup.volatility, 1);
+        const number rate = number::variable(setup.rate, 2);
+        const number log_spot = log(spot);
+        const number drift = rate - T{0.5} * volatility * volatility;
+        const number discount = exp(-rate * setup.maturity);
+
+        // as in parallel_gradient, enough blocks to balance any pool size
+        constexpr std::size_t most_blocks = 256;
+        const std::size_t batches = (setup.paths + lanes - 1) / lanes;
+        const std::size_t blocks = std::max<std::size_t>(1, std::min(batches, most_blocks));
+
+        std::vector<montecarlo_detail::block_sums<T>> partial(blocks);
+        pool.run(blocks, [&](std::size_t begin, std::size_t end)
+        {
+            std::vector<number> path(lanes * steps);
+            for (std::size_t b = begin; b < end; ++b)
+            {
+                montecarlo_detail::block_sums<T> sums;
+                for (std::size_t batch = batches * b / blocks; batch < batches * (b + 1) / blocks; ++batch)
+                {
+                    const std::size_t first = batch * lanes;
+                    const std::size_t count = std::min(lanes, setup.paths - first);
+
+                    std::array<T, lanes> w{};
+                    std::array<std::array<T, 2>, lanes> z{};
+                    for (std::size_t k = 0; k < steps; ++k)
+                    {
+                        if (k % 2 == 0)
+                            for (std::size_t l = 0; l < count; ++l)
+                                z[l] = normal_pair<T>(setup.seed, first + l, k / 2);
+                        for (std::size_t l = 0; l < lanes; ++l)
+                            w[l] += root_dt * z[l][k % 2];
+
+                        const T t = dt * static_cast<T>(k + 1);
+                        const number mean = log_spot + drift * t;
+                        for (std::size_t l = 0; l < count; ++l)
+                            path[l * steps + k] = exp(mean + volatility * w[l]);
+                    }
+                    for (std::size_t l = 0; l < count; ++l)
+                        sums.add(discount * payoff(std::span<const number>{path.data() + l * steps, steps}));
+                }
+                partial[b] = sums;
+            }
+        });
+
+        for (std::size_t b = 1; b < blocks; ++b)
+            partial[0].merge(partial[b]);
+
+        greeks_result<T> r;
+        r.paths = setup.paths;
+        const T n = static_cast<T>(setup.paths);
+        std::array<T, 4> mean;
+        for (std::size_t k = 0; k < 4; ++k)
+        {
+            mean[k] = partial[0].sum[k].result() / n;
+            const T variance = std::max(T{}, partial[0].squares[k].result() / n - mean[k] * mean[k]);
+            r.standard_error[k] = setup.paths > 1 ? std::sqrt(variance / (n - T{1})) : T{};
+        }
+        r.price = mean[0];
+        r.delta = mean[1];
+        r.vega = mean[2];
+        r.rho = mean[3];
+        return r;
+    }
+
+}  /// namespace dnn
+
+#endif  /// DUAL_MONTECARLO
@@ -0,0 +1,442 @@
+#ifndef DUAL_MULTI
+#   define DUAL_MULTI
+
+#include <dual_numbers.hxx>
+
+#include <array>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+
+namespace dnn
+{
+    // Duals with N tangents, the directional derivatives along N seeds carried
+    // through one evaluation. mdual<T, N>::variable(x, i) is input i, with
+    // tangent e_i, so after evaluating f the tangents of the result are its
+    // gradient, or a row of the Jacobian for a vector valued f.
+    //
+    // The tangent loops have a fixed trip count and vectorise; every operation
+    // is one value computation plus one scaled sum over the tangents.
+
+    template<typename T, std::size_t N>
+    class mdual
+    {
+    public:
+
+        using base_real_type = T;
+        using tangent_type = std::array<T, N>;
+
+        static constexpr std::size_t width = N;
+
+    public:
+
+        explicit constexpr
+        mdual(const base_real_type& re = base_real_type{}, const tangent_type& d = tangent_type{}) noexcept
+            : m_re{ re }
+            , m_d{ d }
+        { }
+
+        // input i of N
+        static constexpr auto
+        variable(const base_real_type& re, std::size_t i) noexcept
+            -> mdual
+        {
+            mdual x{re};
+            x.m_d[i] = base_real_type{1};
+            return x;
+        }
+
+        constexpr auto
+        re() noexcept
+            -> base_real_type&
+        { return m_re; }
+
+        constexpr auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_re; }
+
+        constexpr auto
+        d() noexcept
+            -> tangent_type&
+        { return m_d; }
+
+        constexpr auto
+        d() const noexcept
+            -> const tangent_type&
+        { return m_d; }
+
+        constexpr auto
+        d(std::size_t i) const noexcept
+            -> const base_real_type&
+        { return m_d[i]; }
+
+        // value a and tangents scaled by s, a + s d
+        constexpr auto
+        chain(const base_real_type& a, const base_real_type& s) const noexcept
+            -> mdual
+        {
+            mdual r{a};
+            for (std::size_t i = 0; i < N; ++i)
+                r.m_d[i] = s * m_d[i];
+            return r;
+        }
+
+        // value a and tangents su du + sv dv
+        static constexpr auto
+        chain(const base_real_type& a, const base_real_type& su, const mdual& u, const base_real_type& sv, const mdual& v) noexcept
+            -> mdual
+        {
+            mdual r{a};
+            for (std::size_t i = 0; i < N; ++i)
+                r.m_d[i] = su * u.m_d[i] + sv * v.m_d[i];
+            return r;
+        }
+
+        ///{@  multi-tangent dual unary arithmetic
+        constexpr auto
+        operator+= (const mdual& v) noexcept
+            -> mdual&
+        {
+            m_re += v.m_re;
+            for (std::size_t i = 0; i < N; ++i)
+                m_d[i] += v.m_d[i];
+            return *this;
+        }
+
+        constexpr auto
+        operator-= (const mdual& v) noexcept
+            -> mdual&
+        {
+            m_re -= v.m_re;
+            for (std::size_t i = 0; i < N; ++i)
+                m_d[i] -= v.m_d[i];
+            return *this;
+        }
+
+        constexpr auto
+        operator*= (const mdual& v) noexcept
+            -> mdual&
+        { return *this = *this * v; }
+
+        constexpr auto
+        operator/= (const mdual& v) noexcept
+            -> mdual&
+        { return *this = *this / v; }
+
+        constexpr auto
+        operator+= (const base_real_type& v) noexcept
+            -> mdual&
+        {
+            m_re += v;
+            return *this;
+        }
+
+        constexpr auto
+        operator-= (const base_real_type& v) noexcept
+            -> mdual&
+        {
+            m_re -= v;
+            return *this;
+        }
+
+        constexpr auto
+        operator*= (const base_real_type& v) noexcept
+            -> mdual&
+        {
+            m_re *= v;
+            for (std::size_t i = 0; i < N; ++i)
+                m_d[i] *= v;
+            return *this;
+        }
+
+        constexpr auto
+        operator/= (const base_real_type& v) noexcept
+            -> mdual&
+        { return *this *= base_real_type{1} / v; }
+        ///@}  multi-tangent dual unary arithmetic
+
+        ///{@  multi-tangent dual arithmetic
+        // defined as friends so that plain numbers convert to base_real_type
+        friend constexpr auto
+        operator+ (const mdual& u) noexcept
+            -> mdual
+        { return u; }
+
+        friend constexpr auto
+        operator- (const mdual& u) noexcept
+            -> mdual
+        { return u.chain(-u.m_re, base_real_type{-1}); }
+
+        friend constexpr auto
+        operator+ (mdual u, const mdual& v) noexcept
+            -> mdual
+        { return u += v; }
+
+        friend constexpr auto
+        operator- (mdual u, const mdual& v) noexcept
+            -> mdual
+        { return u -= v; }
+
+        friend constexpr auto
+        operator* (const mdual& u, const mdual& v) noexcept
+            -> mdual
+        { return chain(u.m_re * v.m_re, v.m_re, u, u.m_re, v); }
+
+        friend constexpr auto
+        operator/ (const mdual& u, const mdual& v) noexcept
+            -> mdual
+        {
+            const base_real_type inv = base_real_type{1} / v.m_re;
+            const base_real_type q = u.m_re * inv;
+            return chain(q, inv, u, -q * inv, v);
+        }
+
+        friend constexpr auto
+        operator+ (mdual u, const base_real_type& v) noexcept
+            -> mdual
+        { return u += v; }
+
+        friend constexpr auto
+        operator+ (const base_real_type& u, mdual v) noexcept
+            -> mdual
+        { return v += u; }
+
+        friend constexpr auto
+        operator- (mdual u, const base_real_type& v) noexcept
+            -> mdual
+        { return u -= v; }
+
+        friend constexpr auto
+        operator- (const base_real_type& u, const mdual& v) noexcept
+            -> mdual
+        { return v.chain(u - v.m_re, base_real_type{-1}); }
+
+        friend constexpr auto
+        operator* (mdual u, const base_real_type& v) noexcept
+            -> mdual
+        { return u *= v; }
+
+        friend constexpr auto
+        operator* (const base_real_type& u, mdual v) noexcept
+            -> mdual
+        { return v *= u; }
+
+        friend constexpr auto
+        operator/ (mdual u, const base_real_type& v) noexcept
+            -> mdual
+        { return u /= v; }
+
+        friend constexpr auto
+        operator/ (const base_real_type& u, const mdual& v) noexcept
+            -> mdual
+        {
+            const base_real_type q = u / v.m_re;
+            return v.chain(q, -q / v.m_re);
+        }
+        ///@}  multi-tangent dual arithmetic
+
+        ///{@   multi-tangent dual comparison operators
+        // on the real part, like dual
+        friend constexpr auto
+        operator== (const mdual& u, const mdual& v) noexcept
+            -> bool
+        { return u.m_re == v.m_re; }
+
+        friend constexpr auto
+        operator<=> (const mdual& u, const mdual& v) noexcept
+        { return u.m_re <=> v.m_re; }
+
+        friend constexpr auto
+        operator== (const mdual& u, const base_real_type& v) noexcept
+            -> bool
+        { return u.m_re == v; }
+
+        friend constexpr auto
+        operator<=> (const mdual& u, const base_real_type& v) noexcept
+        { return u.m_re <=> v; }
+        ///@}   multi-tangent dual comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const mdual& v)
+            -> std::ostream&
+        {
+            os << v.m_re << " + [";
+            for (std::size_t i = 0; i < N; ++i)
+                os << (i ? ", " : "") << v.m_d[i];
+            os << "]_eps";
+            return os;
+        }
+        ///@}   ostream
+
+    private:
+
+        base_real_type m_re;
+        tangent_type m_d;
+    };
+
+    ///{@   elementary functions of multi-tangent duals
+    template<typename T, std::size_t N>
+    constexpr auto
+    sqrt(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    {
+        const T s = std::sqrt(x.re());
+        return x.chain(s, T{1} / (T{2} * s));
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    exp(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    {
+        const T e = std::exp(x.re());
+        return x.chain(e, e);
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    log(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::log(x.re()), T{1} / x.re()); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    sin(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::sin(x.re()), std::cos(x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    cos(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::cos(x.re()), -std::sin(x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    tan(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    {
+        const T t = std::tan(x.re());
+        return x.chain(t, T{1} + t * t);
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    atan(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::atan(x.re()), T{1} / (T{1} + x.re() * x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    asin(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::asin(x.re()), T{1} / std::sqrt(T{1} - x.re() * x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    acos(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::acos(x.re()), T{-1} / std::sqrt(T{1} - x.re() * x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    atan2(const mdual<T, N>& y, const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    {
+        const T r2 = x.re() * x.re() + y.re() * y.re();
+        return mdual<T, N>::chain(std::atan2(y.re(), x.re()), x.re() / r2, y, -y.re() / r2, x);
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    hypot(const mdual<T, N>& x, const mdual<T, N>& y) noexcept
+        -> mdual<T, N>
+    {
+        const T h = std::hypot(x.re(), y.re());
+        return mdual<T, N>::chain(h, x.re() / h, x, y.re() / h, y);
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    sinh(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::sinh(x.re()), std::cosh(x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    cosh(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::cosh(x.re()), std::sinh(x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    tanh(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    {
+        const T c = std::cosh(x.re());
+        return x.chain(std::tanh(x.re()), T{1} / (c * c));
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    log1p(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::log1p(x.re()), T{1} / (T{1} + x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    expm1(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::expm1(x.re()), std::exp(x.re())); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    cbrt(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    {
+        const T c = std::cbrt(x.re());
+        return x.chain(c, T{1} / (T{3} * c * c));
+    }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    abs(const mdual<T, N>& x) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::abs(x.re()), static_cast<T>((T{} < x.re()) - (x.re() < T{}))); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    pow(const mdual<T, N>& x, const std::type_identity_t<T>& n) noexcept
+        -> mdual<T, N>
+    { return x.chain(std::pow(x.re(), n), n * std::pow(x.re(), n - T{1})); }
+
+    template<typename T, std::size_t N>
+    constexpr auto
+    pow(const std::type_identity_t<T>& x, const mdual<T, N>& n) noexcept
+        -> mdual<T, N>
+    {
+        const T p = std::pow(x, n.re());
+        return n.chain(p, p * std::log(x));
+    }
+
+    // the log term only when the exponent carries tangents, as for dual
+    template<typename T, std::size_t N>
+    constexpr auto
+    pow(const mdual<T, N>& x, const mdual<T, N>& n) noexcept
+        -> mdual<T, N>
+    {
+        const T p = std::pow(x.re(), n.re());
+        bool active = false;
+        for (std::size_t i = 0; i < N; ++i)
+            active |= n.d(i) != T{};
+        return mdual<T, N>::chain(p, n.re() * std::pow(x.re(), n.re() - T{1}), x, active ? p * std::log(x.re()) : T{}, n);
+    }
+    ///@}   elementary functions of multi-tangent duals
+
+}  /// namespace dnn
+
+#endif  /// DUAL_MULTI
@@ -1,12 +1,93 @@
 #ifndef DUAL_NUMBER
 #   define DUAL_NUMBER
 
+#include <dual_cmath.hxx>
+
 #include <cmath>
+#include <complex>
 #include <iostream>
+#include <limits>
+#include <type_traits>
+#include <utility>
 
 namespace dnn
 {
-    
+    template<typename T>
+    class dual;
+
+    template<typename T>
+    struct is_dual : std::false_type { };
+
+    template<typename T>
+    struct is_dual<dual<T>> : std::true_type { };
+
+    // scalars are everything that is not a dual number, the scalar overloads
+    // below are constrained on this so that they never compete with the dual ones
+    template<typename T>
+    concept scalar = !is_dual<std::remove_cvref_t<T>>::value;
+
+    template<typename T>
+    struct is_complex : std::false_type { };
+
+    template<typename T>
+    struct is_complex<std::complex<T>> : std::true_type { };
+
+    namespace complex_detail
+    {
+        // The complex products of dual multiplication and division, and the
+        // reciprocal of the latter, in plain real arithmetic. The std::complex
+        // operators call __muldc3 and __divdc3, which recover infinities from
+        // NaN results as in C Annex G and cost more than the rest of a dual
+        // operation. Finite operands give the same results to rounding;
+        // infinite ones are not recovered.
+        template<typename T>
+        constexpr auto
+        multiply(const std::complex<T>& a, const std::complex<T>& b) noexcept
+            -> std::complex<T>
+        { return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()}; }
+
+        // a * b, by multiply when both are the same std::complex
+        template<typename A, typename B>
+        constexpr auto
+        product(const A& a, const B& b) noexcept
+        {
+            if constexpr (is_complex<A>::value && std::is_same_v<A, B>)
+                return multiply(a, b);
+            else
+                return a * b;
+        }
+
+        // conj(z) / |z|^2 while |z|^2 is a normal number; otherwise, near the
+        // ends of the range, Smith's algorithm, which scales by the larger part
+        // and never forms |z|^2
+        template<typename T>
+        constexpr auto
+        reciprocal(const std::complex<T>& z) noexcept
+            -> std::complex<T>
+        {
+            const T n = z.real() * z.real() + z.imag() * z.imag();
+            if (n >= std::numeric_limits<T>::min() && n <= std::numeric_limits<T>::max()) [[likely]]
+            {
+                const T inv = T{1} / n;
+                return {z.real() * inv, -z.imag() * inv};
+            }
+            if (std::abs(z.real()) >= std::abs(z.imag()))
+            {
+                const T r = z.imag() / z.real();
+                const T inv = T{1} / (z.real() + z.imag() * r);
+                return {inv, -r * inv};
+            }
+            const T r = z.real() / z.imag();
+            const T inv = T{1} / (z.real() * r + z.imag());
+            return {r * inv, -inv};
+        }
+    }  /// namespace complex_detail
+
+    // Over std::complex a dual number carries a complex derivative, which is
+    // the derivative of a holomorphic function; the ordered comparisons, sgn and
+    // abs are left to base types that have a < and are unavailable otherwise.
+    template<typename T>
+    concept ordered = requires(const T& a, const T& b) { a < b; };
 
     template<typename T>
     class dual
@@ -26,10 +107,13 @@ namespace dnn
         constexpr dual(const dual&) noexcept   = default;
         constexpr dual(dual&&) noexcept        = default;
 
+        constexpr auto operator= (const dual&) noexcept -> dual&    = default;
+        constexpr auto operator= (dual&&) noexcept -> dual&         = default;
+
         template<typename other_real_type>
         constexpr dual(const dual<other_real_type>& dn) noexcept
-            : m_re{ base_real_type{ dn.re() } }
-            , m_d{ base_real_type{ dn.d() } }
+            : m_re{ static_cast<base_real_type>(dn.re()) }
+            , m_d{ static_cast<base_real_type>(dn.d()) }
         { }
 
         constexpr auto
@@ -62,13 +146,19 @@ namespace dnn
             -> const base_real_type&
         { return m_d; }
 
+        // the modulus of the real part, |z| as a complex number over std::complex
         constexpr auto
-        norm() noexcept
+        norm() const noexcept
             -> base_real_type
-        { return ((base_real_type{} < m_re) - (base_real_type{} > m_re)) * m_re; }
+        {
+            if constexpr (is_complex<base_real_type>::value)
+                return base_real_type{std::abs(m_re)};
+            else
+                return ((base_real_type{} < m_re) - (base_real_type{} > m_re)) * m_re;
+        }
 
         constexpr auto
-        conj() noexcept
+        conj() const noexcept
             -> dual<base_real_type>
         { 
             return dual<base_real_type>{m_re, -m_d}; 
@@ -95,8 +185,8 @@ namespace dnn
         operator*= (const base_real_type& v) noexcept
             -> dual&
         {
-            m_re *= v;
-            m_d *= v;
+            m_re = complex_detail::product(m_re, v);
+            m_d = complex_detail::product(m_d, v);
             return *this;
         }
 
@@ -134,8 +224,9 @@ namespace dnn
         operator*= (const dual<other_real_type>& dn) noexcept
             -> dual<base_real_type>&
         {
-            m_d = m_d*dn.re() + m_re*dn.d();
-            m_re *= dn.re();
+            using complex_detail::product;
+            m_d = product(m_d, dn.re()) + product(m_re, dn.d());
+            m_re = product(m_re, dn.re());
             return *this;
         }
 
@@ -144,75 +235,109 @@ namespace dnn
         operator/= (const dual<other_real_type>& dn) noexcept
             -> dual<base_real_type>&
         {
-            m_d = (m_d*dn.re() - m_re*dn.d())/(dn.re() * dn.re());
-            m_re /= dn.re();
+            if constexpr (is_complex<base_real_type>::value && std::is_same_v<base_real_type, other_real_type>)
+            {
+                // one reciprocal, the rest multiplies
+                using complex_detail::multiply;
+                const base_real_type inv = complex_detail::reciprocal(dn.re());
+                m_re = multiply(m_re, inv);
+                m_d = multiply(m_d - multiply(m_re, dn.d()), inv);
+            }
+            else
+            {
+                m_d = (m_d*dn.re() - m_re*dn.d())/(dn.re() * dn.re());
+                m_re /= dn.re();
+            }
             return *this;
         }
         ///@}  dual number unary arithmetic
 
         ///{@  dual number arithmetic
-        template<typename other_real_type>
         constexpr auto
-        operator+ (const dual<other_real_type>& v)
+        operator+ () const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re + v.re(), m_d + v.d()};
+            return *this;
         }
 
-        template<typename other_real_type>
         constexpr auto
-        operator- (const dual<other_real_type>& v)
+        operator- () const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re - v.re(), m_d - v.d()};
+            return dual(-m_re, -m_d);
         }
 
         template<typename other_real_type>
         constexpr auto
-        operator* (const dual<other_real_type>& v)
+        operator+ (const dual<other_real_type>& v) const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re * v.re(), m_d * v.re() + m_re * v.d()};
+            return dual(m_re + v.re(), m_d + v.d());
         }
 
         template<typename other_real_type>
         constexpr auto
-        operator/ (const dual<other_real_type>& v)
+        operator- (const dual<other_real_type>& v) const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re / v.re(), (m_d * m_re - m_re * v.d()) / (v.re() * v.re())};
+            return dual(m_re - v.re(), m_d - v.d());
         }
 
         template<typename other_real_type>
         constexpr auto
-        operator+ (const other_real_type& v)
+        operator* (const dual<other_real_type>& v) const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re + v, m_d};
+            using complex_detail::product;
+            return dual(product(m_re, v.re()), product(m_d, v.re()) + product(m_re, v.d()));
         }
 
         template<typename other_real_type>
         constexpr auto
-        operator- (const other_real_type& v)
+        operator/ (const dual<other_real_type>& v) const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re - v, m_d};
+            if constexpr (is_complex<base_real_type>::value && std::is_same_v<base_real_type, other_real_type>)
+            {
+                using complex_detail::multiply;
+                const base_real_type inv = complex_detail::reciprocal(v.re());
+                const base_real_type re = multiply(m_re, inv);
+                return dual(re, multiply(m_d - multiply(re, v.d()), inv));
+            }
+            else
+                return dual(m_re / v.re(), (m_d * v.re() - m_re * v.d()) / (v.re() * v.re()));
         }
 
-        template<typename other_real_type>
+        template<scalar other_real_type>
         constexpr auto
-        operator* (const other_real_type& v)
+        operator+ (const other_real_type& v) const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re * v, m_d * v};
+            return dual(m_re + v, m_d);
         }
 
-        template<typename other_real_type>
+        template<scalar other_real_type>
+        constexpr auto
+        operator- (const other_real_type& v) const noexcept
+            -> dual<base_real_type>
+        {
+            return dual(m_re - v, m_d);
+        }
+
+        template<scalar other_real_type>
         constexpr auto
-        operator/ (const other_real_type& v)
+        operator* (const other_real_type& v) const noexcept
             -> dual<base_real_type>
         {
-            return dual{m_re / v, m_d / v};
+            return dual(complex_detail::product(m_re, v), complex_detail::product(m_d, v));
+        }
+
+        template<scalar other_real_type>
+        constexpr auto
+        operator/ (const other_real_type& v) const noexcept
+            -> dual<base_real_type>
+        {
+            return dual(m_re / v, m_d / v);
         }
         ///@}  dual number arithmetic
 
@@ -229,98 +354,106 @@ namespace dnn
         // and H'(x) = delta(x) as a distributional derivative.
         
         ///{@   dual number comparison operators
-        template<typename other_real_type>
+        template<scalar other_real_type>
         constexpr auto
-        operator==(const other_real_type& v)
-            -> const bool
+        operator==(const other_real_type& v) const noexcept
+            -> bool
         {
             return m_re == v;
         }
 
-        template<typename other_real_type>
+        template<scalar other_real_type>
         constexpr auto
-        operator!=(const other_real_type& v)
-            -> const bool
+        operator!=(const other_real_type& v) const noexcept
+            -> bool
         {
             return m_re != v;
         }
         
-        template<typename other_real_type>
+        template<scalar other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator<(const other_real_type& v)
-            -> const bool
+        operator<(const other_real_type& v) const noexcept
+            -> bool
         {
             return m_re < v;
         }
 
-        template<typename other_real_type>
+        template<scalar other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator>(const other_real_type& v)
-            -> const bool
+        operator>(const other_real_type& v) const noexcept
+            -> bool
         {
             return m_re > v;
         }
 
-        template<typename other_real_type>
+        template<scalar other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator<=(const other_real_type& v)
-            -> const bool
+        operator<=(const other_real_type& v) const noexcept
+            -> bool
         {
             return m_re <= v;
         }
 
-        template<typename other_real_type>
+        template<scalar other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator>=(const other_real_type& v)
-            -> const bool
+        operator>=(const other_real_type& v) const noexcept
+            -> bool
         {
             return m_re >= v;
         }
 
         template<typename other_real_type>
         constexpr auto
-        operator==(const dual<other_real_type>& v)
-            -> const bool
+        operator==(const dual<other_real_type>& v) const noexcept
+            -> bool
         {
             return m_re == v.re();
         }
 
         template<typename other_real_type>
         constexpr auto
-        operator!=(const dual<other_real_type>& v)
-            -> const bool
+        operator!=(const dual<other_real_type>& v) const noexcept
+            -> bool
         {
             return m_re != v.re();
         }
         
         template<typename other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator<(const dual<other_real_type>& v)
-            -> const bool
+        operator<(const dual<other_real_type>& v) const noexcept
+            -> bool
         {
             return m_re < v.re();
         }
 
         template<typename other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator>(const dual<other_real_type>& v)
-            -> const bool
+        operator>(const dual<other_real_type>& v) const noexcept
+            -> bool
         {
             return m_re > v.re();
         }
 
         template<typename other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator<=(const dual<other_real_type>& v)
-            -> const bool
+        operator<=(const dual<other_real_type>& v) const noexcept
+            -> bool
         {
             return m_re <= v.re();
         }
 
         template<typename other_real_type>
+            requires ordered<base_real_type>
         constexpr auto
-        operator>=(const dual<other_real_type>& v)
-            -> const bool
+        operator>=(const dual<other_real_type>& v) const noexcept
+            -> bool
         {
             return m_re >= v.re();
         }
@@ -341,237 +474,487 @@ namespace dnn
         base_real_type m_re;
         base_real_type m_d;
     };
+
+    // the real and derivative parts are contiguous, so a dual<std::complex<double>>
+    // is four doubles in the order re.real, re.imag, d.real, d.imag
+    static_assert(sizeof(dual<double>) == 2 * sizeof(double));
+    static_assert(sizeof(dual<std::complex<double>>) == 4 * sizeof(double));
     ///@{  scalar arithmetic
     
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
     constexpr auto
-    operator+ (const base_real_type& u, const dual<other_real_type>& v)
+    operator+ (const base_real_type& u, const dual<other_real_type>& v) noexcept
         -> dual<other_real_type>
     {
-        return dual{u + v.re(), v.d()};
+        return dual<other_real_type>(u + v.re(), v.d());
     }
     
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
     constexpr auto
-    operator- (const base_real_type& u, const dual<other_real_type>& v)
+    operator- (const base_real_type& u, const dual<other_real_type>& v) noexcept
         -> dual<other_real_type>
     {
-        return dual{u - v.re(), -v.d()};
+        return dual<other_real_type>(u - v.re(), -v.d());
     }
     
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
     constexpr auto
-    operator* (const base_real_type& u, const dual<other_real_type>& v)
+    operator* (const base_real_type& u, const dual<other_real_type>& v) noexcept
         -> dual<other_real_type>
     {
-        return dual{u * v.re(), u * v.d()};
+        return dual<other_real_type>(complex_detail::product(u, v.re()), complex_detail::product(u, v.d()));
     }
     
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
     constexpr auto
-    operator/ (const base_real_type& u, const dual<other_real_type>& v)
+    operator/ (const base_real_type& u, const dual<other_real_type>& v) noexcept
         -> dual<other_real_type>
     {
-        return dual{u / v.re(), - u * v.d()/(v.re()*v.re())};
+        if constexpr (is_complex<other_real_type>::value)
+        {
+            using complex_detail::multiply;
+            const other_real_type inv = complex_detail::reciprocal(v.re());
+            const other_real_type re = complex_detail::product(u, inv);
+            return dual<other_real_type>(re, -multiply(multiply(re, v.d()), inv));
+        }
+        else
+            return dual<other_real_type>(u / v.re(), - u * v.d()/(v.re()*v.re()));
     }
     
     ///{@   elementary functions with at least one dual number
-    
+    // Results are dual over the type the std:: function returns for the real
+    // part, so that a dual<int> argument gives a dual<double> like std::sqrt(int)
+    // gives a double, and a dual<float> stays a dual<float>.
+
+    // The log(u) term of the exponent's partial is only formed when the exponent
+    // carries a tangent, otherwise a negative base with a constant integer
+    // exponent would turn the whole tangent into 0 * NaN.
     template<typename base_real_type, typename other_real_type>
     constexpr auto 
     pow(const dual<base_real_type>& u, const dual<other_real_type>& n) 
     {
-        return dual{std::pow(u.re(), n.re()), n.re() * std::pow(u.re(), n.re()-1) * u.d() + std::log(u.re()) * std::pow(u.re(), n.re()) * n.d()}; 
+        using real_type = decltype(std::pow(u.re(), n.re()));
+        const real_type p = cmath::pow(u.re(), n.re());
+        real_type d = static_cast<real_type>(n.re()) * cmath::pow(u.re(), n.re() - other_real_type{1}) * u.d();
+        if (n.d() != other_real_type{})
+            d += cmath::log(u.re()) * p * n.d();
+        return dual<real_type>{p, d}; 
     }
 
     template<typename base_real_type, typename other_real_type>
     constexpr auto 
     pow(const dual<base_real_type>& u, const other_real_type& n) 
     { 
-        return dual{std::pow(u.re(), n), n * std::pow(u.re(), n-1) * u.d()}; 
+        using real_type = decltype(std::pow(u.re(), n));
+        return dual<real_type>{cmath::pow(u.re(), n), static_cast<real_type>(n) * cmath::pow(u.re(), n - other_real_type{1}) * u.d()}; 
     }
 
     template<typename base_real_type, typename other_real_type>
     constexpr auto 
     pow(const base_real_type& u, const dual<other_real_type>& n) 
     { 
-        return dual{std::pow(u, n.re()), std::log(u) * std::pow(u, n.re()) * n.d()}; 
+        using real_type = decltype(std::pow(u, n.re()));
+        const real_type p = cmath::pow(u, n.re());
+        return dual<real_type>{p, cmath::log(u) * p * n.d()}; 
     }
     
     template<typename base_real_type>
     constexpr auto 
     sqrt(const dual<base_real_type>& dn) 
     { 
-        return dual{std::sqrt(dn.re()), 0.5 * std::pow(dn.re(), -0.5) * dn.d()}; 
+        using real_type = decltype(std::sqrt(dn.re()));
+        const real_type s = cmath::sqrt(dn.re());
+        return dual<real_type>{s, dn.d() / (real_type{2} * s)}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     cos(const dual<base_real_type>& dn) 
     { 
-        return dual{std::cos(dn.re()), -std::sin(dn.re()) * dn.d()}; 
+        using real_type = decltype(std::cos(dn.re()));
+        return dual<real_type>{cmath::cos(dn.re()), -cmath::sin(dn.re()) * dn.d()}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     sin(const dual<base_real_type>& dn) 
     { 
-        return dual{std::sin(dn.re()), std::cos(dn.re()) * dn.d()}; 
+        using real_type = decltype(std::sin(dn.re()));
+        return dual<real_type>{cmath::sin(dn.re()), cmath::cos(dn.re()) * dn.d()}; 
     }
 
+    // tan' = 1 + tan^2, from the value
     template<typename base_real_type>
     constexpr auto 
     tan(const dual<base_real_type>& dn) 
     { 
-        return dual{std::tan(dn.re()), dn.d()/(std::cos(dn.re())*std::cos(dn.re()))}; 
+        using real_type = decltype(std::tan(dn.re()));
+        const real_type t = cmath::tan(dn.re());
+        return dual<real_type>{t, (real_type{1} + t * t) * dn.d()}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     exp(const dual<base_real_type>& dn) 
     { 
-        return dual{std::exp(dn.re()), std::exp(dn.re()) * dn.d()}; 
+        using real_type = decltype(std::exp(dn.re()));
+        const real_type e = cmath::exp(dn.re());
+        return dual<real_type>{e, e * dn.d()}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     acos(const dual<base_real_type>& dn) 
     { 
-        return dual{std::acos(dn.re()), -dn.d()/std::sqrt(1-dn.re()*dn.re()) }; 
+        using real_type = decltype(std::acos(dn.re()));
+        const real_type x = dn.re();
+        return dual<real_type>{cmath::acos(x), -dn.d() / cmath::sqrt((real_type{1} - x) * (real_type{1} + x))}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     asin(const dual<base_real_type>& dn) 
     { 
-        return dual{std::asin(dn.re()), dn.d()/std::sqrt(1-dn.re()*dn.re()) }; 
+        using real_type = decltype(std::asin(dn.re()));
+        const real_type x = dn.re();
+        return dual<real_type>{cmath::asin(x), dn.d() / cmath::sqrt((real_type{1} - x) * (real_type{1} + x))}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     atan(const dual<base_real_type>& dn) 
     { 
-        return dual{std::atan(dn.re()), 1.0*dn.d()/(1+dn.re()*dn.re()) }; 
+        using real_type = decltype(std::atan(dn.re()));
+        const real_type x = dn.re();
+        return dual<real_type>{cmath::atan(x), dn.d() / (real_type{1} + x * x)}; 
     }
 
     template<typename base_real_type>
     constexpr auto 
     log(const dual<base_real_type>& dn) 
     { 
-        return dual{std::log(dn.re()), 1.0*dn.d()/dn.re()}; 
+        using real_type = decltype(std::log(dn.re()));
+        const real_type x = dn.re();
+        return dual<real_type>{cmath::log(x), dn.d() / x}; 
     }
 
     template<typename base_real_type, typename other_real_type>
     constexpr auto 
     hypot(const dual<base_real_type>& u, const dual<other_real_type>& v) 
     { 
-        return dual{std::hypot(u.re(), v.re()), (u.re() * u.d() + v.re() * v.d())/std::hypot(u.re(), v.re())}; 
+        using real_type = decltype(std::hypot(u.re(), v.re()));
+        const real_type h = cmath::hypot(u.re(), v.re());
+        return dual<real_type>{h, (u.re() / h) * u.d() + (v.re() / h) * v.d()}; 
     }
 
     template<typename base_real_type, typename other_real_type>
     constexpr auto 
     hypot(const dual<base_real_type>& u, const other_real_type& v) 
     { 
-        return dual{std::hypot(u.re(), v), (u.re() * u.d())/std::hypot(u.re(), v)}; 
+        using real_type = decltype(std::hypot(u.re(), v));
+        const real_type h = cmath::hypot(u.re(), v);
+        return dual<real_type>{h, (u.re() / h) * u.d()}; 
     }
 
     template<typename base_real_type, typename other_real_type>
     constexpr auto
     hypot(const base_real_type& u, const dual<other_real_type>& v) 
     { 
-        return dual{std::hypot(u, v.re()), (v.re() * v.d())/std::hypot(u, v.re())}; 
+        using real_type = decltype(std::hypot(u, v.re()));
+        const real_type h = cmath::hypot(u, v.re());
+        return dual<real_type>{h, (v.re() / h) * v.d()}; 
+    }
+
+    // sinh and cosh from a single expm1, which stays accurate near 0:
+    // sinh(x) = m (m + 2) / (2 (m + 1)) and cosh(x) = sinh(x) + 1/(m + 1) with m = e^|x| - 1.
+    // Evaluated at |x| since m + 1 cancels for negative x; sinh is odd and cosh even.
+    // m (m + 2) overflows at half the range of sinh, so once e^-2|x| is below half
+    // an ulp both are e^|x| / 2, taken as h (h / 2) with h = e^(|x|/2).
+    // Each is the derivative of the other, so a dual sinh needs the cosh anyway.
+    // Over std::complex there is no expm1 and no sign to restore, both come from std.
+    template<typename base_real_type>
+    constexpr auto
+    sinhcosh(const dual<base_real_type>& dn)
+        -> std::pair<dual<base_real_type>, dual<base_real_type>>
+    {
+        if constexpr (is_complex<base_real_type>::value)
+        {
+            const base_real_type s = cmath::sinh(dn.re());
+            const base_real_type c = cmath::cosh(dn.re());
+            return {dual<base_real_type>{s, c * dn.d()}, dual<base_real_type>{c, s * dn.d()}};
+        }
+        else
+        {
+            constexpr base_real_type large = (std::numeric_limits<base_real_type>::digits + 2) * base_real_type{0.34657359027997264};
+            const base_real_type x = cmath::abs(dn.re());
+            base_real_type a, c;
+            if (x > large)
+            {
+                const base_real_type h = cmath::exp(base_real_type{0.5} * x);
+                a = h * (base_real_type{0.5} * h);
+                c = a;
+            }
+            else
+            {
+                const base_real_type m = cmath::expm1(x);
+                const base_real_type inv = base_real_type{1} / (m + base_real_type{1});
+                a = base_real_type{0.5} * m * (m + base_real_type{2}) * inv;
+                c = a + inv;
+            }
+            const base_real_type s = cmath::copysign(a, dn.re());
+            return {dual<base_real_type>{s, c * dn.d()}, dual<base_real_type>{c, s * dn.d()}};
+        }
+    }
+
+    template<typename base_real_type>
+    constexpr auto 
+    sinh(const dual<base_real_type>& dn) 
+    { 
+        return sinhcosh(dn).first; 
+    }
+
+    template<typename base_real_type>
+    constexpr auto 
+    cosh(const dual<base_real_type>& dn) 
+    { 
+        return sinhcosh(dn).second; 
+    }
+
+    // tanh(x) = m / (m + 2) with m = e^2|x| - 1, cheaper than std::tanh and as accurate
+    // near 0; past the cutover of sinhcosh, (digits + 2) ln2 / 2, 1 - tanh is below a
+    // quarter ulp of 1, so tanh rounds to 1, where the quotient would become inf/inf.
+    // tanh is odd, the sign is restored last. tanh' = 1 - tanh^2 = 4 (m + 1) / (m + 2)^2,
+    // written so it neither cancels as tanh -> 1 nor overflows before going to 0.
+    // Over std::complex tanh comes from std and tanh' = 1 - tanh^2 from the value.
+    template<typename base_real_type>
+    constexpr auto 
+    tanh(const dual<base_real_type>& dn) 
+    { 
+        if constexpr (is_complex<base_real_type>::value)
+        {
+            const base_real_type t = cmath::tanh(dn.re());
+            return dual<base_real_type>{t, (base_real_type{1} - t * t) * dn.d()};
+        }
+        else
+        {
+            constexpr base_real_type large = (std::numeric_limits<base_real_type>::digits + 2) * base_real_type{0.34657359027997264};
+            const base_real_type x = cmath::abs(dn.re());
+            const base_real_type m = cmath::expm1(base_real_type{2} * x);
+            const base_real_type t = cmath::copysign(x > large ? base_real_type{1} : m / (m + base_real_type{2}), dn.re());
+            const base_real_type q = x > large ? base_real_type{1} : (m + base_real_type{2}) / (m + base_real_type{1});
+            const base_real_type sech2 = base_real_type{4} / ((m + base_real_type{2}) * q);
+            return dual<base_real_type>{t, sech2 * dn.d()}; 
+        }
+    }
+
+    // The partials of atan2(y, x) are x/r^2 and -y/r^2 with r = hypot(x, y). Both
+    // components are scaled by max(|x|, |y|) first, which shares the scaled r^2
+    // between them and keeps it from overflowing without paying for std::hypot.
+    namespace detail
+    {
+        template<typename real_type>
+        constexpr auto
+        atan2_tangent(const real_type& y, const real_type& x, const real_type& dy, const real_type& dx)
+            -> real_type
+        {
+            const real_type s = cmath::fmax(cmath::abs(x), cmath::abs(y));
+            if (s == real_type{})
+                return real_type{};
+            const real_type xs = x / s;
+            const real_type ys = y / s;
+            return (xs * dy - ys * dx) / (s * (xs * xs + ys * ys));
+        }
+    }  /// namespace detail
+
+    template<typename base_real_type, typename other_real_type>
+    constexpr auto 
+    atan2(const dual<base_real_type>& y, const dual<other_real_type>& x) 
+    { 
+        using real_type = decltype(std::atan2(y.re(), x.re()));
+        return dual<real_type>{cmath::atan2(y.re(), x.re()), detail::atan2_tangent<real_type>(y.re(), x.re(), y.d(), x.d())}; 
+    }
+
+    template<typename base_real_type, typename other_real_type>
+    constexpr auto 
+    atan2(const dual<base_real_type>& y, const other_real_type& x) 
+    { 
+        using real_type = decltype(std::atan2(y.re(), x));
+        return dual<real_type>{cmath::atan2(y.re(), x), detail::atan2_tangent<real_type>(y.re(), x, y.d(), real_type{})}; 
+    }
+
+    template<typename base_real_type, typename other_real_type>
+    constexpr auto 
+    atan2(const base_real_type& y, const dual<other_real_type>& x) 
+    { 
+        using real_type = decltype(std::atan2(y, x.re()));
+        return dual<real_type>{cmath::atan2(y, x.re()), detail::atan2_tangent<real_type>(y, x.re(), real_type{}, x.d())}; 
+    }
+
+    template<typename base_real_type>
+    constexpr auto 
+    log1p(const dual<base_real_type>& dn) 
+    { 
+        return dual<base_real_type>{cmath::log1p(dn.re()), dn.d() / (base_real_type{1} + dn.re())}; 
+    }
+
+    // expm1' = e^x = expm1 + 1, from the value
+    template<typename base_real_type>
+    constexpr auto 
+    expm1(const dual<base_real_type>& dn) 
+    { 
+        // m + 1 = e^x cancels once m approaches -1, below -ln 2 e^x is computed directly
+        const base_real_type m = cmath::expm1(dn.re());
+        const base_real_type e = dn.re() < base_real_type{-0.6931471805599453} ? cmath::exp(dn.re()) : m + base_real_type{1};
+        return dual<base_real_type>{m, e * dn.d()}; 
+    }
+
+    // cbrt' = 1 / (3 cbrt^2), from the value
+    template<typename base_real_type>
+    constexpr auto 
+    cbrt(const dual<base_real_type>& dn) 
+    { 
+        const base_real_type c = cmath::cbrt(dn.re());
+        return dual<base_real_type>{c, dn.d() / (base_real_type{3} * c * c)}; 
     }
     ///@}   elementary functions with at least one dual number
 
     ///{@   elementary functions on scalars
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, scalar other_real_type>
     constexpr auto 
     pow(const base_real_type& u, const other_real_type& n) 
     {
-        return std::pow(u, n); 
+        return cmath::pow(u, n); 
     }
     
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     sqrt(const base_real_type& u) 
     { 
-        return std::sqrt(u); 
+        return cmath::sqrt(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     cos(const base_real_type& u) 
     { 
-        return std::cos(u); 
+        return cmath::cos(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     sin(const base_real_type& u) 
     { 
-        return std::sin(u); 
+        return cmath::sin(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     tan(const base_real_type& u) 
     { 
-        return std::tan(u); 
+        return cmath::tan(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     exp(const base_real_type& u)
     { 
-        return std::exp(u); 
+        return cmath::exp(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     acos(const base_real_type& u)
     { 
-        return std::acos(u); 
+        return cmath::acos(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     asin(const base_real_type& u) 
     { 
-        return std::asin(u); 
+        return cmath::asin(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     atan(const base_real_type& u) 
     { 
-        return std::atan(u); 
+        return cmath::atan(u); 
     }
 
-    template<typename base_real_type>
+    template<scalar base_real_type>
     constexpr auto 
     log(const base_real_type& u) 
     { 
-        return std::log(u); 
+        return cmath::log(u); 
     }
 
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, scalar other_real_type>
     constexpr auto 
     hypot(const base_real_type& u, const other_real_type& v) 
     { 
-        return std::hypot(u,v); 
+        return cmath::hypot(u,v); 
+    }
+    template<scalar base_real_type>
+    constexpr auto 
+    sinh(const base_real_type& u) 
+    { 
+        return cmath::sinh(u); 
+    }
+
+    template<scalar base_real_type>
+    constexpr auto 
+    cosh(const base_real_type& u) 
+    { 
+        return cmath::cosh(u); 
+    }
+
+    template<scalar base_real_type>
+    constexpr auto 
+    tanh(const base_real_type& u) 
+    { 
+        return cmath::tanh(u); 
+    }
+
+    template<scalar base_real_type, scalar other_real_type>
+    constexpr auto 
+    atan2(const base_real_type& y, const other_real_type& x) 
+    { 
+        return cmath::atan2(y, x); 
+    }
+
+    template<scalar base_real_type>
+    constexpr auto 
+    log1p(const base_real_type& u) 
+    { 
+        return cmath::log1p(u); 
+    }
+
+    template<scalar base_real_type>
+    constexpr auto 
+    expm1(const base_real_type& u) 
+    { 
+        return cmath::expm1(u); 
+    }
+
+    template<scalar base_real_type>
+    constexpr auto 
+    cbrt(const base_real_type& u) 
+    { 
+        return cmath::cbrt(u); 
     }
     ///@}   elementary functions on scalars
 
     ///{@   elemenntary functions (general)
-    template<typename ordered_type>
+    template<ordered ordered_type>
     constexpr auto
     sgn(const ordered_type& u)
         -> int
     {
-        return (ordered_type{} < u) - (ordered_type{} > u.re());
+        return (ordered_type{} < u) - (u < ordered_type{});
     }
 
-    template<typename ordered_type>
+    template<ordered ordered_type>
     constexpr auto
     abs(const ordered_type& u)
         -> ordered_type
@@ -579,53 +962,67 @@ namespace dnn
         return sgn(u) * u;
     }
 
+    // z / |z|, and 0 at 0; abs of a complex number is std::abs, found by ADL
+    template<typename T>
+    auto
+    sgn(const std::complex<T>& z)
+        -> std::complex<T>
+    {
+        const T r = std::abs(z);
+        return r == T{} ? std::complex<T>{} : z / r;
+    }
+
     ///@}   elementary functions (general)
 
     ///{@   scalar comparison operators
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
     constexpr auto
-    operator==(const base_real_type& u, const dual<other_real_type>& v)
-        -> const bool
+    operator==(const base_real_type& u, const dual<other_real_type>& v) noexcept
+        -> bool
     {
         return u == v.re();
     }
 
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
     constexpr auto
-    operator!=(const base_real_type& u, const dual<other_real_type>& v)
-        -> const bool
+    operator!=(const base_real_type& u, const dual<other_real_type>& v) noexcept
+        -> bool
     {
         return u != v.re();
     }
 
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
+        requires ordered<other_real_type>
     constexpr auto
-    operator<(const base_real_type& u, const dual<other_real_type>& v)
-        -> const bool
+    operator<(const base_real_type& u, const dual<other_real_type>& v) noexcept
+        -> bool
     {
         return u < v.re();
     }
 
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
+        requires ordered<other_real_type>
     constexpr auto
-    operator>(const base_real_type& u, const dual<other_real_type>& v)
-        -> const bool
+    operator>(const base_real_type& u, const dual<other_real_type>& v) noexcept
+        -> bool
     {
         return u > v.re();
     }
 
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
+        requires ordered<other_real_type>
     constexpr auto
-    operator<=(const base_real_type& u, const dual<other_real_type>& v)
-        -> const bool
+    operator<=(const base_real_type& u, const dual<other_real_type>& v) noexcept
+        -> bool
     {
         return u <= v.re();
     }
 
-    template<typename base_real_type, typename other_real_type>
+    template<scalar base_real_type, typename other_real_type>
+        requires ordered<other_real_type>
     constexpr auto
-    operator>=(const base_real_type& u, const dual<other_real_type>& v)
-        -> const bool
+    operator>=(const base_real_type& u, const dual<other_real_type>& v) noexcept
+        -> bool
     {
         return u >= v.re();
     }
@@ -642,7 +1039,7 @@ namespace dnn
     template<typename base_real_type, typename other_real_type>
     constexpr auto
     equiv(dual<base_real_type> u, dual<other_real_type> v)
-        -> const bool
+        -> bool
     {
         return ( (u.re() == v.re()) && (u.d() == v.d()));
     }
@@ -650,7 +1047,7 @@ namespace dnn
     template<typename base_real_type, typename other_real_type>
     constexpr auto
     equiv(base_real_type u, dual<other_real_type> v)
-        -> const bool
+        -> bool
     {
         return ( (u == v.re()) && (base_real_type{} == v.d()));
     }
@@ -658,7 +1055,7 @@ namespace dnn
     template<typename base_real_type, typename other_real_type>
     constexpr auto
     equiv(dual<base_real_type> u, other_real_type v)
-        -> const bool
+        -> bool
     {
         return ( (u.re() == v) && (u.d() == other_real_type{}));
     }
@@ -666,7 +1063,7 @@ namespace dnn
     template<typename base_real_type, typename other_real_type>
     constexpr auto
     equiv(base_real_type u, other_real_type v)
-        -> const bool
+        -> bool
     {
         return (u == v);
     }
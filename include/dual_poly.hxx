@@ -0,0 +1,251 @@
+#ifndef DUAL_POLY
+#   define DUAL_POLY
+
+#include <dual_numbers.hxx>
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+namespace dnn
+{
+    // Polynomial and Chebyshev series evaluation at dual points.
+    //
+    // A polynomial p evaluated at x = xr + xd eps is p(xr) + p'(xr) xd eps, so
+    // instead of running the recurrences in dual arithmetic we run them on the
+    // real part only and carry p' alongside. A Horner step through the generic
+    // operators, p = p*x + c, costs 3 multiplies and 2 adds and builds a
+    // temporary dual; the fused step below costs 2 multiplies and 2 adds
+    // (p' = p'*xr + p, p = p*xr + c) on scalars, plus one final multiply by xd.
+    //
+    // Coefficients are ordered by increasing degree, c[0] + c[1] x + ...
+
+    namespace poly_detail
+    {
+        // points per block in the batch kernels, the lanes the compiler vectorises
+        inline constexpr std::size_t block = 8;
+    }  /// namespace poly_detail
+
+    ///{@   polynomials
+    // p(x) by Horner's rule
+    template<typename base_real_type>
+    constexpr auto
+    horner(std::span<const base_real_type> c, const dual<base_real_type>& x) noexcept
+        -> dual<base_real_type>
+    {
+        if (c.empty())
+            return dual<base_real_type>{};
+
+        const base_real_type xr = x.re();
+        base_real_type p = c.back();
+        base_real_type dp{};
+        for (std::size_t k = c.size() - 1; k-- > 0; )
+        {
+            dp = dp * xr + p;
+            p  = p * xr + c[k];
+        }
+        return dual<base_real_type>{p, dp * x.d()};
+    }
+
+    // p(x) by Horner's rule with dual coefficients, e.g. when the coefficients
+    // are model parameters being differentiated. The tangent is
+    // sum c[k].d() x^k + p'(x) x.d(), one more chain of 1 multiply and 1 add.
+    template<typename base_real_type>
+    constexpr auto
+    horner(std::span<const dual<base_real_type>> c, const dual<base_real_type>& x) noexcept
+        -> dual<base_real_type>
+    {
+        if (c.empty())
+            return dual<base_real_type>{};
+
+        const base_real_type xr = x.re();
+        base_real_type p  = c.back().re();
+        base_real_type pc = c.back().d();
+        base_real_type dp{};
+        for (std::size_t k = c.size() - 1; k-- > 0; )
+        {
+            dp = dp * xr + p;
+            p  = p * xr + c[k].re();
+            pc = pc * xr + c[k].d();
+        }
+        return dual<base_real_type>{p, pc + dp * x.d()};
+    }
+
+    // p(x) by Estrin's scheme. Pairs of terms are combined into a polynomial in
+    // x^2, pairs of those into one in x^4 and so on, which shortens the
+    // dependency chain from N to log2(N) steps for a single point. Value and
+    // derivative are combined together at every level:
+    //      (a + b X)' = a' + b' X + b X'
+    template<typename base_real_type, std::size_t N>
+    constexpr auto
+    estrin(const std::array<base_real_type, N>& c, const dual<base_real_type>& x) noexcept
+        -> dual<base_real_type>
+    {
+        if constexpr (N == 0)
+        {
+            return dual<base_real_type>{};
+        }
+        else
+        {
+            std::array<base_real_type, N> v = c;
+            std::array<base_real_type, N> d{};
+
+            base_real_type X  = x.re();
+            base_real_type dX = base_real_type{1};
+            std::size_t n = N;
+            while (n > 1)
+            {
+                const std::size_t half = n / 2;
+                for (std::size_t i = 0; i < half; ++i)
+                {
+                    const base_real_type a  = v[2 * i];
+                    const base_real_type b  = v[2 * i + 1];
+                    const base_real_type da = d[2 * i];
+                    const base_real_type db = d[2 * i + 1];
+                    v[i] = a + b * X;
+                    d[i] = da + db * X + b * dX;
+                }
+                if (n % 2)
+                {
+                    v[half] = v[n - 1];
+                    d[half] = d[n - 1];
+                }
+                n = half + n % 2;
+                dX = base_real_type{2} * X * dX;
+                X  = X * X;
+            }
+            return dual<base_real_type>{v[0], d[0] * x.d()};
+        }
+    }
+
+    // y[i] = p(x[i]) by Horner's rule, for many points at once. Points are
+    // processed in blocks whose value and derivative accumulators are updated
+    // in lock step, which the compiler turns into vector instructions. For
+    // batches Estrin's scheme buys nothing, the block already provides the
+    // independent work.
+    template<typename base_real_type>
+    constexpr auto
+    horner(std::span<const base_real_type> c, std::span<const dual<base_real_type>> x,
+           std::span<dual<base_real_type>> y) noexcept
+        -> void
+    {
+        using poly_detail::block;
+
+        const std::size_t n = x.size() < y.size() ? x.size() : y.size();
+        std::size_t i = 0;
+        if (!c.empty())
+        {
+            for (; i + block <= n; i += block)
+            {
+                base_real_type xr[block], p[block], dp[block];
+                for (std::size_t l = 0; l < block; ++l)
+                {
+                    xr[l] = x[i + l].re();
+                    p[l]  = c.back();
+                    dp[l] = base_real_type{};
+                }
+                for (std::size_t k = c.size() - 1; k-- > 0; )
+                {
+                    const base_real_type ck = c[k];
+                    for (std::size_t l = 0; l < block; ++l)
+                    {
+                        dp[l] = dp[l] * xr[l] + p[l];
+                        p[l]  = p[l] * xr[l] + ck;
+                    }
+                }
+                for (std::size_t l = 0; l < block; ++l)
+                {
+                    y[i + l].re() = p[l];
+                    y[i + l].d()  = dp[l] * x[i + l].d();
+                }
+            }
+        }
+        for (; i < n; ++i)
+            y[i] = horner(c, x[i]);
+    }
+    ///@}   polynomials
+
+    ///{@   Chebyshev series
+    // f(x) = sum c[k] T_k(t) with t = (2x - lo - hi)/(hi - lo) mapping [lo, hi]
+    // onto [-1, 1], by Clenshaw's recurrence
+    //      b_k = c_k + 2t b_{k+1} - b_{k+2},       f = c_0 + t b_1 - b_2
+    // differentiated alongside
+    //      b'_k = 2 b_{k+1} + 2t b'_{k+1} - b'_{k+2},   f' = b_1 + t b'_1 - b'_2
+    template<typename base_real_type>
+    constexpr auto
+    clenshaw(std::span<const base_real_type> c, const dual<base_real_type>& x,
+             const base_real_type& lo = base_real_type{-1}, const base_real_type& hi = base_real_type{1}) noexcept
+        -> dual<base_real_type>
+    {
+        if (c.empty())
+            return dual<base_real_type>{};
+
+        const base_real_type scale = base_real_type{2} / (hi - lo);
+        const base_real_type t  = (x.re() - lo) * scale - base_real_type{1};
+        const base_real_type t2 = base_real_type{2} * t;
+
+        base_real_type b1{}, b2{}, db1{}, db2{};
+        for (std::size_t k = c.size() - 1; k > 0; --k)
+        {
+            const base_real_type b  = c[k] + t2 * b1 - b2;
+            const base_real_type db = base_real_type{2} * b1 + t2 * db1 - db2;
+            b2 = b1;
+            b1 = b;
+            db2 = db1;
+            db1 = db;
+        }
+        const base_real_type f  = c[0] + t * b1 - b2;
+        const base_real_type df = b1 + t * db1 - db2;
+        return dual<base_real_type>{f, df * scale * x.d()};
+    }
+
+    // y[i] = f(x[i]) for many points at once, blocked like the batch horner.
+    template<typename base_real_type>
+    constexpr auto
+    clenshaw(std::span<const base_real_type> c, std::span<const dual<base_real_type>> x,
+             std::span<dual<base_real_type>> y,
+             const base_real_type& lo = base_real_type{-1}, const base_real_type& hi = base_real_type{1}) noexcept
+        -> void
+    {
+        using poly_detail::block;
+
+        const std::size_t n = x.size() < y.size() ? x.size() : y.size();
+        const base_real_type scale = base_real_type{2} / (hi - lo);
+        std::size_t i = 0;
+        if (!c.empty())
+        {
+            for (; i + block <= n; i += block)
+            {
+                base_real_type t[block], b1[block] = {}, b2[block] = {}, db1[block] = {}, db2[block] = {};
+                for (std::size_t l = 0; l < block; ++l)
+                    t[l] = (x[i + l].re() - lo) * scale - base_real_type{1};
+
+                for (std::size_t k = c.size() - 1; k > 0; --k)
+                {
+                    const base_real_type ck = c[k];
+                    for (std::size_t l = 0; l < block; ++l)
+                    {
+                        const base_real_type t2 = base_real_type{2} * t[l];
+                        const base_real_type b  = ck + t2 * b1[l] - b2[l];
+                        const base_real_type db = base_real_type{2} * b1[l] + t2 * db1[l] - db2[l];
+                        b2[l] = b1[l];
+                        b1[l] = b;
+                        db2[l] = db1[l];
+                        db1[l] = db;
+                    }
+                }
+                for (std::size_t l = 0; l < block; ++l)
+                {
+                    y[i + l].re() = c[0] + t[l] * b1[l] - b2[l];
+                    y[i + l].d()  = (b1[l] + t[l] * db1[l] - db2[l]) * scale * x[i + l].d();
+                }
+            }
+        }
+        for (; i < n; ++i)
+            y[i] = clenshaw(c, x[i], lo, hi);
+    }
+    ///@}   Chebyshev series
+
+}  /// namespace dnn
+
+#endif  /// DUAL_POLY
@@ -0,0 +1,250 @@
+#ifndef DUAL_REDUCE
+#   define DUAL_REDUCE
+
+#include <dual_numbers.hxx>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+
+namespace dnn
+{
+    // Reductions over ranges of dual numbers.
+    //
+    // A plain std::accumulate is one long dependency chain per component. The
+    // fast and compensated modes keep `lanes` independent partial sums for the
+    // real and the tangent part, which breaks the chain and lays the partials
+    // out so the compiler can keep them in vector registers. Lanes are always
+    // combined in the same fixed order, so results do not depend on anything
+    // but the input. The ordered mode adds strictly left to right and matches
+    // std::accumulate bit for bit.
+
+    enum class reduction
+    {
+        fast,           // independent lanes, plain addition
+        compensated,    // independent lanes, Neumaier compensated addition
+        ordered         // single left to right chain
+    };
+
+    namespace reduce_detail
+    {
+        inline constexpr std::size_t lanes = 8;
+
+        // Rounding error of the product a*b = p. Uses fma when the target has a
+        // fast one and Dekker's splitting otherwise, a library fma call would
+        // be slower than the whole compensated sum.
+        template<typename base_real_type>
+        constexpr auto
+        product_error(const base_real_type& a, const base_real_type& b, const base_real_type& p) noexcept
+            -> base_real_type
+        {
+#if defined(FP_FAST_FMA)
+            return std::fma(a, b, -p);
+#else
+            constexpr base_real_type split = base_real_type(1ull << ((std::numeric_limits<base_real_type>::digits + 1) / 2)) + 1;
+            const base_real_type ca = split * a;
+            const base_real_type ah = ca - (ca - a);
+            const base_real_type al = a - ah;
+            const base_real_type cb = split * b;
+            const base_real_type bh = cb - (cb - b);
+            const base_real_type bl = b - bh;
+            return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+        }
+
+        template<typename base_real_type, bool compensate>
+        struct accumulator
+        {
+            base_real_type sum{};
+            base_real_type c{};
+
+            constexpr auto
+            add(const base_real_type& v) noexcept
+                -> void
+            {
+                if constexpr (compensate)
+                {
+                    const base_real_type t = sum + v;
+                    if (std::abs(v) <= std::abs(sum))
+                        c += (sum - t) + v;
+                    else
+                        c += (v - t) + sum;
+                    sum = t;
+                }
+                else
+                {
+                    sum += v;
+                }
+            }
+
+            // adds the product a*b, with its rounding error when compensating
+            constexpr auto
+            add_product(const base_real_type& a, const base_real_type& b) noexcept
+                -> void
+            {
+                if constexpr (compensate)
+                {
+                    const base_real_type p = a * b;
+                    c += product_error(a, b, p);
+                    add(p);
+                }
+                else
+                {
+                    sum += a * b;
+                }
+            }
+
+            constexpr auto
+            merge(const accumulator& other) noexcept
+                -> void
+            {
+                add(other.sum);
+                c += other.c;
+            }
+
+            constexpr auto
+            result() const noexcept
+                -> base_real_type
+            { return sum + c; }
+        };
+
+        // Runs term(i, re, d) for every i < n, which adds the contribution of
+        // element i to the accumulators re and d, and returns the combined sums.
+        template<std::size_t width, bool compensate, typename base_real_type, typename term_type>
+        constexpr auto
+        reduce(std::size_t n, term_type&& term) noexcept
+            -> dual<base_real_type>
+        {
+            using acc = accumulator<base_real_type, compensate>;
+
+            acc re[width] = {};
+            acc d[width]  = {};
+
+            std::size_t i = 0;
+            for (; i + width <= n; i += width)
+                for (std::size_t l = 0; l < width; ++l)
+                    term(i + l, re[l], d[l]);
+            for (std::size_t l = 0; i < n; ++i, ++l)
+                term(i, re[l], d[l]);
+
+            for (std::size_t l = 1; l < width; ++l)
+            {
+                re[0].merge(re[l]);
+                d[0].merge(d[l]);
+            }
+            return dual<base_real_type>{re[0].result(), d[0].result()};
+        }
+
+        template<typename base_real_type, typename term_type>
+        constexpr auto
+        dispatch(reduction mode, std::size_t n, term_type&& term) noexcept
+            -> dual<base_real_type>
+        {
+            switch (mode)
+            {
+            case reduction::compensated:
+                return reduce<lanes, true, base_real_type>(n, term);
+            case reduction::ordered:
+                return reduce<1, false, base_real_type>(n, term);
+            case reduction::fast:
+            default:
+                return reduce<lanes, false, base_real_type>(n, term);
+            }
+        }
+    }  /// namespace reduce_detail
+
+    ///{@   reductions
+    // sum of x
+    template<typename base_real_type>
+    constexpr auto
+    sum(std::span<const dual<base_real_type>> x, reduction mode = reduction::fast) noexcept
+        -> dual<base_real_type>
+    {
+        return reduce_detail::dispatch<base_real_type>(mode, x.size(),
+            [x](std::size_t i, auto& re, auto& d)
+            {
+                re.add(x[i].re());
+                d.add(x[i].d());
+            });
+    }
+
+    // sum of x[i]*y[i], with tangent sum of x.re*y.d + x.d*y.re
+    template<typename base_real_type>
+    constexpr auto
+    dot(std::span<const dual<base_real_type>> x, std::span<const dual<base_real_type>> y,
+        reduction mode = reduction::fast) noexcept
+        -> dual<base_real_type>
+    {
+        return reduce_detail::dispatch<base_real_type>(mode, x.size() < y.size() ? x.size() : y.size(),
+            [x, y](std::size_t i, auto& re, auto& d)
+            {
+                re.add_product(x[i].re(), y[i].re());
+                d.add_product(x[i].re(), y[i].d());
+                d.add_product(x[i].d(), y[i].re());
+            });
+    }
+
+    // sum of x[i]*x[i], with tangent 2 sum of x.re*x.d
+    template<typename base_real_type>
+    constexpr auto
+    squared_norm(std::span<const dual<base_real_type>> x, reduction mode = reduction::fast) noexcept
+        -> dual<base_real_type>
+    {
+        auto s = reduce_detail::dispatch<base_real_type>(mode, x.size(),
+            [x](std::size_t i, auto& re, auto& d)
+            {
+                re.add_product(x[i].re(), x[i].re());
+                d.add_product(x[i].re(), x[i].d());
+            });
+        s.d() *= base_real_type{2};
+        return s;
+    }
+
+    // Euclidean norm of x, scaled by the largest |x.re| like hypot so that it
+    // neither overflows nor underflows. The tangent is sum of x.re*x.d / norm;
+    // at x.re = 0 the norm is not differentiable and we return the one sided
+    // directional derivative, which is the norm of the tangents.
+    template<typename base_real_type>
+    constexpr auto
+    norm(std::span<const dual<base_real_type>> x, reduction mode = reduction::fast) noexcept
+        -> dual<base_real_type>
+    {
+        base_real_type scale{};
+        for (const auto& v : x)
+            scale = std::fmax(scale, std::abs(v.re()));
+
+        if (scale == base_real_type{})
+        {
+            base_real_type d_scale{};
+            for (const auto& v : x)
+                d_scale = std::fmax(d_scale, std::abs(v.d()));
+            if (d_scale == base_real_type{})
+                return dual<base_real_type>{};
+
+            const auto inv = base_real_type{1} / d_scale;
+            auto s = reduce_detail::dispatch<base_real_type>(mode, x.size(),
+                [x, inv](std::size_t i, auto& re, auto&)
+                {
+                    const base_real_type t = x[i].d() * inv;
+                    re.add_product(t, t);
+                });
+            return dual<base_real_type>{base_real_type{}, d_scale * std::sqrt(s.re())};
+        }
+
+        const auto inv = base_real_type{1} / scale;
+        auto s = reduce_detail::dispatch<base_real_type>(mode, x.size(),
+            [x, inv](std::size_t i, auto& re, auto& d)
+            {
+                const base_real_type t = x[i].re() * inv;
+                re.add_product(t, t);
+                d.add_product(t, x[i].d());
+            });
+        const base_real_type r = std::sqrt(s.re());
+        return dual<base_real_type>{scale * r, s.d() / r};
+    }
+    ///@}   reductions
+
+}  /// namespace dnn
+
+#endif  /// DUAL_REDUCE
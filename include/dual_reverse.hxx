@@ -0,0 +1,829 @@
+#ifndef DUAL_REVERSE
+#   define DUAL_REVERSE
+
+#include <dual_numbers.hxx>
+#include <dual_multi.hxx>
+#include <dual_sweep.hxx>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dnn
+{
+    // Reverse mode: gradients of scalar functions of many inputs.
+    //
+    // While a tape<T> is recording on a thread, every operation on taped<T>
+    // values appends a statement to it: the index of the result and, for each
+    // argument, its index and the partial derivative of the result with
+    // respect to it. The partials of the elementary functions come from
+    // evaluating the dual<T> function with a unit tangent, so they are those
+    // of dual_numbers.hxx. reverse() then walks the statements backwards from
+    // the seeded adjoints, adding partial * adjoint to every argument.
+    //
+    // Index 0 stands for constants, which are never recorded; taped values
+    // made from plain numbers mix freely with recorded ones.
+    //
+    // preaccumulate records a kernel of few inputs and many intermediates as
+    // a single statement: the kernel runs in forward mode over mdual<T, N>,
+    // one tangent per input, and only its value and its N partials go on the
+    // tape, in place of a statement for every intermediate.
+    //
+    // checkpointed_gradient differentiates a time-stepping loop of any length
+    // in the memory of K states and one step's tape. It stores states at the
+    // points of the binomial schedule of revolve (Griewank and Walther,
+    // ACM TOMS 26, 2000), records one step at a time while going backwards and
+    // runs the steps in between again from the nearest stored state. With K
+    // states, n steps take t + 1 forward evaluations each at most, t being the
+    // smallest with binomial(K - 1 + t, t) >= n, against the n tapes a plain
+    // reverse sweep keeps.
+    //
+    // parallel_gradient differentiates a sum over independent shards on a
+    // sweep_pool. Each thread records its shards on a tape of its own, which
+    // keeps its memory from shard to shard, so after warm up recording never
+    // allocates. The shards are split into a fixed number of contiguous blocks
+    // whatever the thread count; the adjoints of the parameters are summed
+    // into a buffer per block, which only the thread running the block
+    // writes, and the buffers are added in a fixed binary tree. The result is
+    // then the same bit for bit however the pool schedules the blocks and
+    // however many threads it has; nothing is locked while recording or
+    // sweeping. The blocks run in waves of a power of two at least the pool
+    // size, each wave reusing the same buffers: its sum, a complete subtree,
+    // is folded into a binary counter of wave sums, which finishes the tree
+    // in the same shape. Memory is then bounded by the pool, not the blocks.
+
+    template<typename T>
+    class taped;
+
+    template<typename T>
+    class tape
+    {
+    public:
+
+        using base_real_type = T;
+        using index_type = std::uint32_t;
+
+        // an argument of a statement
+        struct argument
+        {
+            index_type index;
+            base_real_type partial;
+        };
+
+        // makes a tape the calling thread's recording for its lifetime,
+        // restoring the previous one after
+        class recording
+        {
+        public:
+
+            explicit
+            recording(tape& t) noexcept
+                : m_previous{ std::exchange(active(), &t) }
+            { }
+
+            recording(const recording&) = delete;
+            auto operator= (const recording&) -> recording& = delete;
+
+            ~recording()
+            { active() = m_previous; }
+
+        private:
+
+            tape* m_previous;
+        };
+
+    public:
+
+        tape() = default;
+
+        // the tape recording on the calling thread, if any
+        static auto
+        active() noexcept
+            -> tape*&
+        {
+            thread_local tape* current = nullptr;
+            return current;
+        }
+
+        static auto
+        current()
+            -> tape&
+        {
+            tape* t = active();
+            if (!t)
+                throw std::logic_error("dnn: taped value used while no tape is recording");
+            return *t;
+        }
+
+        // a new independent variable
+        auto
+        variable(const base_real_type& v)
+            -> taped<T>
+        { return taped<T>{v, push({})}; }
+
+        // a statement with the given arguments, returning the index of its result
+        auto
+        push(std::initializer_list<argument> arguments)
+            -> index_type
+        {
+            for (const argument& a : arguments)
+                if (a.index != 0)
+                    m_arguments.push_back(a);
+            if (m_ends.size() == std::numeric_limits<index_type>::max())
+                throw std::length_error("dnn: tape is full");
+            m_ends.push_back(static_cast<index_type>(m_arguments.size()));
+            return static_cast<index_type>(m_ends.size() - 1);
+        }
+
+        auto
+        push(std::span<const argument> arguments)
+            -> index_type
+        {
+            for (const argument& a : arguments)
+                if (a.index != 0)
+                    m_arguments.push_back(a);
+            if (m_ends.size() == std::numeric_limits<index_type>::max())
+                throw std::length_error("dnn: tape is full");
+            m_ends.push_back(static_cast<index_type>(m_arguments.size()));
+            return static_cast<index_type>(m_ends.size() - 1);
+        }
+
+        // adds w to the adjoint of y
+        auto
+        seed(const taped<T>& y, const base_real_type& w = base_real_type{1})
+            -> void
+        { seed(y.index(), w); }
+
+        auto
+        seed(index_type y, const base_real_type& w = base_real_type{1})
+            -> void
+        {
+            if (m_adjoints.size() != m_ends.size())
+                m_adjoints.assign(m_ends.size(), base_real_type{});
+            if (y != 0)
+                m_adjoints[y] += w;
+        }
+
+        // Propagates the seeded adjoints to every recorded value.
+        auto
+        reverse()
+            -> void
+        {
+            if (m_adjoints.size() != m_ends.size())
+                m_adjoints.assign(m_ends.size(), base_real_type{});
+
+            base_real_type* const adjoint = m_adjoints.data();
+            const argument* const arguments = m_arguments.data();
+            for (std::size_t k = m_ends.size() - 1; k > 0; --k)
+            {
+                const base_real_type a = adjoint[k];
+                // adjoints carrying tangents compare on their real part only
+                if constexpr (std::is_arithmetic_v<base_real_type>)
+                    if (a == base_real_type{})
+                        continue;
+                for (index_type j = m_ends[k - 1]; j < m_ends[k]; ++j)
+                    adjoint[arguments[j].index] += arguments[j].partial * a;
+            }
+        }
+
+        // the adjoint of x after reverse(), 0 for constants
+        auto
+        adjoint(const taped<T>& x) const noexcept
+            -> base_real_type
+        { return adjoint(x.index()); }
+
+        auto
+        adjoint(index_type x) const noexcept
+            -> base_real_type
+        { return x != 0 && x < m_adjoints.size() ? m_adjoints[x] : base_real_type{}; }
+
+        // forgets the statements and adjoints, keeping the memory
+        auto
+        clear() noexcept
+            -> void
+        {
+            m_ends.resize(1);
+            m_arguments.clear();
+            m_adjoints.clear();
+        }
+
+        auto
+        size() const noexcept
+            -> std::size_t
+        { return m_ends.size() - 1; }
+
+        // the memory held, in bytes
+        auto
+        bytes() const noexcept
+            -> std::size_t
+        {
+            return m_ends.capacity() * sizeof(index_type) + m_arguments.capacity() * sizeof(argument)
+                 + m_adjoints.capacity() * sizeof(base_real_type);
+        }
+
+    private:
+
+        // statement k has the arguments [m_ends[k - 1], m_ends[k]); 0 is the constants
+        std::vector<index_type> m_ends{0};
+        std::vector<argument> m_arguments;
+        std::vector<base_real_type> m_adjoints;
+    };
+
+    // A value being recorded: its value and its index on the recording tape.
+    template<typename T>
+    class taped
+    {
+    public:
+
+        using base_real_type = T;
+        using index_type = typename tape<T>::index_type;
+
+    public:
+
+        // a constant
+        taped(const base_real_type& v = base_real_type{}) noexcept
+            : m_value{ v }
+        { }
+
+        auto
+        value() const noexcept
+            -> const base_real_type&
+        { return m_value; }
+
+        auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_value; }
+
+        auto
+        index() const noexcept
+            -> index_type
+        { return m_index; }
+
+        // value v depending on a with partial da, and on b with partial db
+        static auto
+        apply(const base_real_type& v, const taped& a, const base_real_type& da)
+            -> taped
+        {
+            if (a.m_index == 0)
+                return taped{v};
+            return taped{v, tape<T>::current().push({{a.m_index, da}})};
+        }
+
+        static auto
+        apply(const base_real_type& v, const taped& a, const base_real_type& da, const taped& b, const base_real_type& db)
+            -> taped
+        {
+            if (a.m_index == 0 && b.m_index == 0)
+                return taped{v};
+            return taped{v, tape<T>::current().push({{a.m_index, da}, {b.m_index, db}})};
+        }
+
+        // value v depending on arguments with the given partials
+        static auto
+        apply(const base_real_type& v, std::span<const typename tape<T>::argument> arguments)
+            -> taped
+        {
+            for (const auto& a : arguments)
+                if (a.index != 0)
+                    return taped{v, tape<T>::current().push(arguments)};
+            return taped{v};
+        }
+
+        // f applied through dual<T>, the partials being its tangents at unit seeds
+        template<typename function_type>
+        static auto
+        through_dual(function_type&& f, const taped& a)
+            -> taped
+        {
+            if (a.m_index == 0)
+                return taped{f(dual<T>{a.m_value}).re()};
+            const dual<T> r = f(dual<T>{a.m_value, base_real_type{1}});
+            return taped{r.re(), tape<T>::current().push({{a.m_index, r.d()}})};
+        }
+
+        template<typename function_type>
+        static auto
+        through_dual(function_type&& f, const taped& a, const taped& b)
+            -> taped
+        {
+            const dual<T> ra = f(dual<T>{a.m_value, base_real_type{1}}, dual<T>{b.m_value});
+            if (a.m_index == 0 && b.m_index == 0)
+                return taped{ra.re()};
+            const dual<T> rb = f(dual<T>{a.m_value}, dual<T>{b.m_value, base_real_type{1}});
+            return taped{ra.re(), tape<T>::current().push({{a.m_index, ra.d()}, {b.m_index, rb.d()}})};
+        }
+
+        ///{@  taped compound assignment
+        auto operator+= (const taped& v) -> taped& { return *this = *this + v; }
+        auto operator-= (const taped& v) -> taped& { return *this = *this - v; }
+        auto operator*= (const taped& v) -> taped& { return *this = *this * v; }
+        auto operator/= (const taped& v) -> taped& { return *this = *this / v; }
+        ///@}  taped compound assignment
+
+        ///{@  taped arithmetic
+        // defined as friends so that plain numbers convert to constants
+        friend auto
+        operator+ (const taped& u)
+            -> taped
+        { return u; }
+
+        friend auto
+        operator- (const taped& u)
+            -> taped
+        { return apply(-u.m_value, u, base_real_type{-1}); }
+
+        friend auto
+        operator+ (const taped& u, const taped& v)
+            -> taped
+        { return apply(u.m_value + v.m_value, u, base_real_type{1}, v, base_real_type{1}); }
+
+        friend auto
+        operator- (const taped& u, const taped& v)
+            -> taped
+        { return apply(u.m_value - v.m_value, u, base_real_type{1}, v, base_real_type{-1}); }
+
+        friend auto
+        operator* (const taped& u, const taped& v)
+            -> taped
+        { return apply(u.m_value * v.m_value, u, v.m_value, v, u.m_value); }
+
+        friend auto
+        operator/ (const taped& u, const taped& v)
+            -> taped
+        {
+            const base_real_type q = u.m_value / v.m_value;
+            return apply(q, u, base_real_type{1} / v.m_value, v, -q / v.m_value);
+        }
+        ///@}  taped arithmetic
+
+        ///{@   taped comparison operators, on the values
+        friend auto operator== (const taped& u, const taped& v) noexcept -> bool { return u.m_value == v.m_value; }
+        friend auto operator<=> (const taped& u, const taped& v) noexcept { return u.m_value <=> v.m_value; }
+        ///@}   taped comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const taped& v)
+            -> std::ostream&
+        { return os << v.m_value << " @" << v.m_index; }
+        ///@}   ostream
+
+    private:
+
+        friend class tape<T>;
+
+        taped(const base_real_type& v, index_type index) noexcept
+            : m_value{ v }
+            , m_index{ index }
+        { }
+
+        base_real_type m_value;
+        index_type m_index = 0;
+    };
+
+    ///{@   elementary functions of taped values
+    template<typename T>
+    auto sqrt(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::sqrt(u); }, x); }
+
+    template<typename T>
+    auto sin(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::sin(u); }, x); }
+
+    template<typename T>
+    auto cos(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::cos(u); }, x); }
+
+    template<typename T>
+    auto tan(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::tan(u); }, x); }
+
+    template<typename T>
+    auto exp(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::exp(u); }, x); }
+
+    template<typename T>
+    auto log(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::log(u); }, x); }
+
+    template<typename T>
+    auto acos(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::acos(u); }, x); }
+
+    template<typename T>
+    auto asin(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::asin(u); }, x); }
+
+    template<typename T>
+    auto atan(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::atan(u); }, x); }
+
+    template<typename T>
+    auto sinh(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::sinh(u); }, x); }
+
+    template<typename T>
+    auto cosh(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::cosh(u); }, x); }
+
+    template<typename T>
+    auto tanh(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::tanh(u); }, x); }
+
+    template<typename T>
+    auto log1p(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::log1p(u); }, x); }
+
+    template<typename T>
+    auto expm1(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::expm1(u); }, x); }
+
+    template<typename T>
+    auto cbrt(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::cbrt(u); }, x); }
+
+    template<typename T>
+    auto abs(const taped<T>& x) -> taped<T> { return taped<T>::through_dual([](const dual<T>& u) { return dnn::abs(u); }, x); }
+
+    template<typename T>
+    auto
+    pow(const taped<T>& x, const taped<T>& n)
+        -> taped<T>
+    { return taped<T>::through_dual([](const dual<T>& u, const dual<T>& v) { return dnn::pow(u, v); }, x, n); }
+
+    template<typename T>
+    auto
+    pow(const taped<T>& x, const std::type_identity_t<T>& n)
+        -> taped<T>
+    { return taped<T>::through_dual([&](const dual<T>& u) { return dnn::pow(u, n); }, x); }
+
+    template<typename T>
+    auto
+    pow(const std::type_identity_t<T>& x, const taped<T>& n)
+        -> taped<T>
+    { return taped<T>::through_dual([&](const dual<T>& v) { return dnn::pow(x, v); }, n); }
+
+    template<typename T>
+    auto
+    hypot(const taped<T>& x, const taped<T>& y)
+        -> taped<T>
+    { return taped<T>::through_dual([](const dual<T>& u, const dual<T>& v) { return dnn::hypot(u, v); }, x, y); }
+
+    template<typename T>
+    auto
+    atan2(const taped<T>& y, const taped<T>& x)
+        -> taped<T>
+    { return taped<T>::through_dual([](const dual<T>& v, const dual<T>& u) { return dnn::atan2(v, u); }, y, x); }
+    ///@}   elementary functions of taped values
+
+    // f, taking a const std::array<mdual<T, N>, N>& and returning mdual<T, N>
+    // or std::array<mdual<T, N>, M>, at x, recorded as one statement per result.
+    template<typename T, std::size_t N, typename function_type>
+    auto
+    preaccumulate(function_type&& f, const std::array<taped<T>, N>& x)
+    {
+        using input_type = std::array<mdual<T, N>, N>;
+        using result_type = std::invoke_result_t<function_type&, const input_type&>;
+
+        input_type v;
+        for (std::size_t k = 0; k < N; ++k)
+            v[k] = mdual<T, N>::variable(x[k].value(), k);
+        const result_type y = f(static_cast<const input_type&>(v));
+
+        auto record = [&](const mdual<T, N>& r)
+        {
+            std::array<typename tape<T>::argument, N> arguments;
+            for (std::size_t k = 0; k < N; ++k)
+                arguments[k] = {x[k].index(), r.d(k)};
+            return taped<T>::apply(r.re(), arguments);
+        };
+        if constexpr (std::is_same_v<result_type, mdual<T, N>>)
+            return record(y);
+        else
+        {
+            std::array<taped<T>, std::tuple_size_v<result_type>> r;
+            for (std::size_t m = 0; m < r.size(); ++m)
+                r[m] = record(y[m]);
+            return r;
+        }
+    }
+
+    template<typename T>
+    struct reverse_result
+    {
+        T value;
+        std::vector<T> gradient;
+    };
+
+    // f, taking a const std::vector<taped<T>>& and returning a taped<T>, and
+    // its gradient at x, recorded on a tape of the calling thread's own.
+    template<typename T, typename function_type>
+    auto
+    gradient(function_type&& f, std::span<const std::type_identity_t<T>> x)
+        -> reverse_result<T>
+    {
+        thread_local tape<T> t;
+        t.clear();
+        typename tape<T>::recording active{t};
+
+        std::vector<taped<T>> inputs;
+        inputs.reserve(x.size());
+        for (const T& v : x)
+            inputs.push_back(t.variable(v));
+        const taped<T> y = f(static_cast<const std::vector<taped<T>>&>(inputs));
+
+        t.seed(y);
+        t.reverse();
+        reverse_result<T> r{y.value(), std::vector<T>(x.size())};
+        for (std::size_t i = 0; i < x.size(); ++i)
+            r.gradient[i] = t.adjoint(inputs[i]);
+        return r;
+    }
+
+    // The sum over shards s < shards of f(parameters, s), f taking a
+    // const std::vector<taped<T>>& and a std::size_t and returning taped<T>,
+    // and its gradient with respect to the parameters, the shards being
+    // evaluated in parallel on pool.
+    template<typename T, typename function_type>
+    auto
+    parallel_gradient(function_type&& f, std::span<const std::type_identity_t<T>> parameters, std::size_t shards,
+                      sweep_pool& pool = sweep_pool::shared())
+        -> reverse_result<T>
+    {
+        // enough blocks to balance any pool size in use, the tree over them
+        // fixing the order of the sums
+        constexpr std::size_t most_blocks = 256;
+        const std::size_t blocks = std::max<std::size_t>(1, std::min(shards, most_blocks));
+        const std::size_t wave = std::min(std::bit_ceil(pool.size()), std::bit_ceil(blocks));
+        const std::size_t width = parameters.size();
+
+        // a buffer per block of a wave, its value and then the adjoints, and
+        // one per level of the counter, level l holding the sum of 2^l waves
+        std::vector<std::vector<T>> partial(wave, std::vector<T>(width + 1));
+        std::vector<std::vector<T>> level(static_cast<std::size_t>(std::bit_width((blocks + wave - 1) / wave)), std::vector<T>(width + 1));
+        std::vector<bool> occupied(level.size(), false);
+
+        for (std::size_t first = 0; first < blocks; first += wave)
+        {
+            const std::size_t count = std::min(wave, blocks - first);
+            pool.run(count, [&](std::size_t begin, std::size_t end)
+            {
+                thread_local tape<T> t;
+                thread_local std::vector<taped<T>> inputs;
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    const std::size_t b = first + i;
+                    std::vector<T>& sum = partial[i];
+                    std::fill(sum.begin(), sum.end(), T{});
+                    for (std::size_t s = shards * b / blocks; s < shards * (b + 1) / blocks; ++s)
+                    {
+                        t.clear();
+                        typename tape<T>::recording active{t};
+                        inputs.clear();
+                        for (const T& v : parameters)
+                            inputs.push_back(t.variable(v));
+
+                        const taped<T> y = f(static_cast<const std::vector<taped<T>>&>(inputs), s);
+                        t.seed(y);
+                        t.reverse();
+                        sum[0] += y.value();
+                        for (std::size_t k = 0; k < width; ++k)
+                            sum[k + 1] += t.adjoint(inputs[k]);
+                    }
+                }
+            });
+
+            // the wave's subtree, buffer i taking i + stride for stride = 1, 2,
+            // 4, ..., then the carries of the counter, earlier sums on the left;
+            // in parallel over the entries
+            std::size_t carries = 0;
+            while (occupied[carries])
+                ++carries;
+            pool.run(width + 1, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t stride = 1; stride < count; stride *= 2)
+                    for (std::size_t i = 0; i + stride < count; i += 2 * stride)
+                        for (std::size_t k = begin; k < end; ++k)
+                            partial[i][k] += partial[i + stride][k];
+                for (std::size_t k = begin; k < end; ++k)
+                {
+                    T sum = partial[0][k];
+                    for (std::size_t l = 0; l < carries; ++l)
+                        sum = level[l][k] + sum;
+                    level[carries][k] = sum;
+                }
+            });
+            for (std::size_t l = 0; l < carries; ++l)
+                occupied[l] = false;
+            occupied[carries] = true;
+        }
+
+        // the levels left from the last, partial, run of waves, smaller first
+        std::vector<T> sum(width + 1, T{});
+        bool any = false;
+        for (std::size_t l = 0; l < level.size(); ++l)
+            if (occupied[l])
+            {
+                for (std::size_t k = 0; k <= width; ++k)
+                    sum[k] = any ? level[l][k] + sum[k] : level[l][k];
+                any = true;
+            }
+
+        return {sum[0], std::vector<T>(sum.begin() + 1, sum.end())};
+    }
+
+    // What a checkpointed reversal cost.
+    struct checkpoint_statistics
+    {
+        std::size_t steps = 0;
+        // most states stored at once, the initial one included
+        std::size_t checkpoints = 0;
+        // steps run without recording, to get back to a state from a checkpoint
+        std::size_t advances = 0;
+        // steps recorded, one per step
+        std::size_t recorded = 0;
+        // the stored states and the tape at their largest together
+        std::size_t peak_bytes = 0;
+        std::size_t peak_tape_bytes = 0;
+
+        // forward evaluations per step, 1 for a plain reverse sweep
+        auto
+        recompute_factor() const noexcept
+            -> double
+        { return steps ? static_cast<double>(advances + recorded) / static_cast<double>(steps) : 0.0; }
+    };
+
+    template<typename T>
+    struct checkpointed_result : reverse_result<T>
+    {
+        checkpoint_statistics statistics;
+    };
+
+    namespace reverse_detail
+    {
+        // binomial(s + t, s), the steps s checkpoints reverse with t forward
+        // evaluations each at most, saturating
+        inline auto
+        reach(std::size_t s, std::size_t t) noexcept
+            -> std::size_t
+        {
+            constexpr std::size_t most = std::numeric_limits<std::size_t>::max();
+            std::size_t r = 1;
+            for (std::size_t i = 1; i <= s; ++i)
+            {
+                // r (t + i) / i is exact since r is binomial(t + i - 1, i - 1)
+                const std::size_t g = std::gcd(r, i);
+                const std::size_t a = r / g, b = (t + i) / (i / g);
+                if (a != 0 && b > most / a)
+                    return most;
+                r = a * b;
+            }
+            return r;
+        }
+
+        template<typename T, typename step_type, typename objective_type>
+        class revolve
+        {
+        public:
+
+            revolve(step_type& step, objective_type& objective, std::size_t steps, std::size_t width)
+                : m_step{ step }
+                , m_objective{ objective }
+                , m_steps{ steps }
+                , m_width{ width }
+            {
+                m_statistics.steps = steps;
+                m_statistics.checkpoints = 1;
+            }
+
+            // Reverses the steps [from, to) from x, the state at from, with
+            // free more states to store, leaving the adjoint of x in m_adjoint.
+            auto
+            run(std::size_t from, std::size_t to, const std::vector<T>& x, std::size_t free)
+                -> void
+            {
+                free = std::min(free, to - from - 1);
+                while (to - from > 1 && free > 0)
+                {
+                    // the split of the binomial schedule: what is left after
+                    // it fits free - 1 states and t evaluations, what is
+                    // before it free states and t - 1
+                    const std::size_t n = to - from;
+                    std::size_t t = 1;
+                    while (reach(free, t) < n)
+                        ++t;
+                    const std::size_t m = from + std::clamp<std::size_t>(n - std::min(n, reach(free - 1, t)), 1, n - 1);
+
+                    std::vector<T> y = advance(x, from, m);
+                    ++m_stored;
+                    m_statistics.checkpoints = std::max(m_statistics.checkpoints, m_stored);
+                    run(m, to, y, free - 1);
+                    --m_stored;
+                    to = m;
+                    free = std::min(free, to - from - 1);
+                }
+
+                // no state left to store: every step again from x
+                for (std::size_t i = to; i-- > from;)
+                    leaf(i, i == from ? x : advance(x, from, i));
+            }
+
+            auto
+            statistics() const noexcept
+                -> const checkpoint_statistics&
+            { return m_statistics; }
+
+            std::vector<T> m_adjoint;
+            T m_value{};
+
+        private:
+
+            auto
+            advance(std::vector<T> x, std::size_t from, std::size_t to)
+                -> std::vector<T>
+            {
+                for (std::size_t i = from; i < to; ++i)
+                    x = m_step(static_cast<const std::vector<T>&>(x), i);
+                m_statistics.advances += to - from;
+                return x;
+            }
+
+            // records step i from x and takes the adjoint of its output back to x
+            auto
+            leaf(std::size_t i, const std::vector<T>& x)
+                -> void
+            {
+                m_tape.clear();
+                typename tape<T>::recording active{m_tape};
+
+                std::vector<taped<T>> in;
+                in.reserve(x.size());
+                for (const T& v : x)
+                    in.push_back(m_tape.variable(v));
+                const std::vector<taped<T>> out = m_step(static_cast<const std::vector<taped<T>>&>(in), i);
+                if (out.size() != m_width)
+                    throw std::invalid_argument("dnn: a step changed the size of the state");
+
+                if (i + 1 == m_steps)
+                {
+                    const taped<T> j = m_objective(out);
+                    m_value = j.value();
+                    m_tape.seed(j);
+                }
+                else
+                    for (std::size_t k = 0; k < m_width; ++k)
+                        m_tape.seed(out[k], m_adjoint[k]);
+                m_tape.reverse();
+
+                m_adjoint.resize(m_width);
+                for (std::size_t k = 0; k < m_width; ++k)
+                    m_adjoint[k] = m_tape.adjoint(in[k]);
+
+                ++m_statistics.recorded;
+                m_statistics.peak_tape_bytes = std::max(m_statistics.peak_tape_bytes, m_tape.bytes());
+                m_statistics.peak_bytes = std::max(m_statistics.peak_bytes, (m_stored + 1) * m_width * sizeof(T) + m_tape.bytes());
+            }
+
+            step_type& m_step;
+            objective_type& m_objective;
+            std::size_t m_steps;
+            std::size_t m_width;
+            std::size_t m_stored = 1;
+            tape<T> m_tape;
+            checkpoint_statistics m_statistics;
+        };
+    }  /// namespace reverse_detail
+
+    // The value and gradient of objective(x_n) with respect to x_0, where
+    // x_{i+1} = step(x_i, i). step is called with const std::vector<T>& and
+    // with const std::vector<taped<T>>&, returning a std::vector of the same
+    // and size; objective with const std::vector<taped<T>>&, returning taped<T>.
+    // At most checkpoints states are stored at once, x_0 included; parameters
+    // to differentiate by are carried along in the state unchanged.
+    template<typename T, typename step_type, typename objective_type>
+    auto
+    checkpointed_gradient(step_type step, objective_type objective, std::vector<T> x0, std::size_t steps, std::size_t checkpoints)
+        -> checkpointed_result<T>
+    {
+        if (checkpoints == 0)
+            throw std::invalid_argument("dnn: checkpointing needs at least the initial state stored");
+
+        checkpointed_result<T> r;
+        if (steps == 0)
+        {
+            const auto g = gradient<T>([&](const std::vector<taped<T>>& x) { return objective(x); }, std::span<const T>{x0});
+            r.value = g.value;
+            r.gradient = g.gradient;
+            r.statistics.checkpoints = 1;
+            return r;
+        }
+
+        reverse_detail::revolve<T, step_type, objective_type> schedule{step, objective, steps, x0.size()};
+        schedule.run(0, steps, x0, checkpoints - 1);
+        r.value = schedule.m_value;
+        r.gradient = std::move(schedule.m_adjoint);
+        r.statistics = schedule.statistics();
+        return r;
+    }
+
+}  /// namespace dnn
+
+#endif  /// DUAL_REVERSE
@@ -0,0 +1,238 @@
+#ifndef DUAL_SOLVE
+#   define DUAL_SOLVE
+
+#include <dual_numbers.hxx>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace dnn
+{
+    // Linear solves A x = b with dual entries.
+    //
+    // Differentiating A x = b gives Ar xd = bd - Ad xr, so the tangent of x
+    // solves a system with the same real matrix as the value. We factorise Ar
+    // once in real arithmetic and reuse the factors for both right hand sides,
+    // the tangent costs one product Ad xr and a pair of triangular solves.
+
+    namespace solve_detail
+    {
+        // In place LU factorisation with partial pivoting of the n x n matrix lu
+        // (row-major, leading dimension n). Returns false if a pivot is exactly zero.
+        template<typename base_real_type, typename index_type>
+        constexpr auto
+        lu_factorize(std::size_t n, base_real_type* lu, index_type* piv) noexcept
+            -> bool
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                std::size_t p = k;
+                auto big = std::abs(lu[k * n + k]);
+                for (std::size_t i = k + 1; i < n; ++i)
+                {
+                    const auto v = std::abs(lu[i * n + k]);
+                    if (big < v)
+                    {
+                        big = v;
+                        p = i;
+                    }
+                }
+                piv[k] = static_cast<index_type>(p);
+                if (big == decltype(big){})
+                    return false;
+
+                if (p != k)
+                    for (std::size_t j = 0; j < n; ++j)
+                        std::swap(lu[k * n + j], lu[p * n + j]);
+
+                const base_real_type inv = base_real_type{1} / lu[k * n + k];
+                for (std::size_t i = k + 1; i < n; ++i)
+                {
+                    const base_real_type l = lu[i * n + k] *= inv;
+                    for (std::size_t j = k + 1; j < n; ++j)
+                        lu[i * n + j] -= l * lu[k * n + j];
+                }
+            }
+            return true;
+        }
+
+        // Solves LU x = P b in place on x.
+        template<typename base_real_type, typename index_type>
+        constexpr auto
+        lu_solve(std::size_t n, const base_real_type* lu, const index_type* piv, base_real_type* x) noexcept
+            -> void
+        {
+            for (std::size_t k = 0; k < n; ++k)
+                if (static_cast<std::size_t>(piv[k]) != k)
+                    std::swap(x[k], x[piv[k]]);
+
+            for (std::size_t i = 1; i < n; ++i)
+            {
+                base_real_type s = x[i];
+                for (std::size_t j = 0; j < i; ++j)
+                    s -= lu[i * n + j] * x[j];
+                x[i] = s;
+            }
+
+            for (std::size_t i = n; i-- > 0; )
+            {
+                base_real_type s = x[i];
+                for (std::size_t j = i + 1; j < n; ++j)
+                    s -= lu[i * n + j] * x[j];
+                x[i] = s / lu[i * n + i];
+            }
+        }
+
+        // Solves for the value and tangent of x given the factors of Ar.
+        // re and d are scratch of length n.
+        template<typename base_real_type, typename index_type>
+        constexpr auto
+        dual_solve(std::size_t n, const base_real_type* lu, const index_type* piv,
+                   const dual<base_real_type>* a, std::size_t lda,
+                   const dual<base_real_type>* b, dual<base_real_type>* x,
+                   base_real_type* re, base_real_type* d) noexcept
+            -> void
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                re[i] = b[i].re();
+            lu_solve(n, lu, piv, re);
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                base_real_type s = b[i].d();
+                for (std::size_t j = 0; j < n; ++j)
+                    s -= a[i * lda + j].d() * re[j];
+                d[i] = s;
+            }
+            lu_solve(n, lu, piv, d);
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                x[i].re() = re[i];
+                x[i].d()  = d[i];
+            }
+        }
+    }  /// namespace solve_detail
+
+    // Factorisation of the real part of a dual matrix, kept together with the
+    // matrix so the tangent right hand side bd - Ad xr can be formed on solve.
+    // Solving several right hand sides against the same A reuses the factors.
+    template<typename T>
+    class dual_lu
+    {
+    public:
+
+        using base_real_type = T;
+
+    public:
+
+        dual_lu() = default;
+
+        // Factorises the real part of the n x n matrix a. The matrix is
+        // referenced, not copied, and must outlive the solves.
+        auto
+        factorize(std::size_t n, const dual<base_real_type>* a, std::size_t lda)
+            -> bool
+        {
+            m_n = n;
+            m_a = a;
+            m_lda = lda;
+            m_lu.resize(n * n);
+            m_piv.resize(n);
+            m_re.resize(n);
+            m_d.resize(n);
+
+            for (std::size_t i = 0; i < n; ++i)
+                for (std::size_t j = 0; j < n; ++j)
+                    m_lu[i * n + j] = a[i * lda + j].re();
+
+            m_ok = solve_detail::lu_factorize(n, m_lu.data(), m_piv.data());
+            return m_ok;
+        }
+
+        // x = A^-1 b with x.d() = Ar^-1 (bd - Ad xr). Returns false if A was singular.
+        auto
+        solve(const dual<base_real_type>* b, dual<base_real_type>* x)
+            -> bool
+        {
+            if (!m_ok)
+                return false;
+
+            solve_detail::dual_solve(m_n, m_lu.data(), m_piv.data(), m_a, m_lda,
+                                     b, x, m_re.data(), m_d.data());
+            return true;
+        }
+
+        constexpr auto
+        size() const noexcept
+            -> std::size_t
+        { return m_n; }
+
+    private:
+
+        std::size_t m_n = 0;
+        const dual<base_real_type>* m_a = nullptr;
+        std::size_t m_lda = 0;
+        bool m_ok = false;
+
+        std::vector<base_real_type> m_lu;
+        std::vector<std::size_t> m_piv;
+        std::vector<base_real_type> m_re;
+        std::vector<base_real_type> m_d;
+    };
+
+    ///{@   linear solves
+    // Solves the n x n system A x = b. Returns false if the real part of A is singular.
+    template<typename base_real_type>
+    auto
+    solve(std::size_t n, const dual<base_real_type>* a, std::size_t lda,
+          const dual<base_real_type>* b, dual<base_real_type>* x)
+        -> bool
+    {
+        dual_lu<base_real_type> lu;
+        return lu.factorize(n, a, lda) && lu.solve(b, x);
+    }
+
+    // Solves count independent N x N systems stored back to back:
+    // a holds count row-major matrices, b and x count vectors of length N.
+    // The size is a template parameter so all scratch lives on the stack and the
+    // loops can be fully unrolled for the small systems this is meant for.
+    // Returns the number of singular systems, whose x is left untouched.
+    template<std::size_t N, typename base_real_type>
+    constexpr auto
+    solve_batched(std::size_t count, const dual<base_real_type>* a,
+                  const dual<base_real_type>* b, dual<base_real_type>* x) noexcept
+        -> std::size_t
+    {
+        std::size_t singular = 0;
+        for (std::size_t s = 0; s < count; ++s)
+        {
+            const dual<base_real_type>* as = a + s * N * N;
+
+            std::array<base_real_type, N * N> lu{};
+            std::array<unsigned, N> piv{};
+            std::array<base_real_type, N> re{};
+            std::array<base_real_type, N> d{};
+
+            for (std::size_t i = 0; i < N * N; ++i)
+                lu[i] = as[i].re();
+
+            if (!solve_detail::lu_factorize(N, lu.data(), piv.data()))
+            {
+                ++singular;
+                continue;
+            }
+
+            solve_detail::dual_solve(N, lu.data(), piv.data(), as, N,
+                                     b + s * N, x + s * N, re.data(), d.data());
+        }
+        return singular;
+    }
+    ///@}   linear solves
+
+}  /// namespace dnn
+
+#endif  /// DUAL_SOLVE
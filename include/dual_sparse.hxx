@@ -0,0 +1,680 @@
+#ifndef DUAL_SPARSE
+#   define DUAL_SPARSE
+
+#include <dual_numbers.hxx>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dnn
+{
+    // Duals with sparse tangents, for many inputs of which each intermediate
+    // depends on a few. The tangent is a list of (input index, value) sorted
+    // by index; sums and products merge the two lists, so an operation costs
+    // the number of nonzeros of its arguments instead of the number of inputs.
+    //
+    // Lists live in blocks of 2^k entries taken from a per-thread pool, which
+    // keeps a free list per size and recycles blocks instead of returning them
+    // to the allocator; after warm up a steady computation allocates nothing.
+    // The pool releases its memory when its thread exits, so a sparse_dual must
+    // not outlive the thread that created it, though it can be used and freed
+    // on another one meanwhile. Every block records the pool it was carved
+    // from; a block freed on another thread goes back to that pool through a
+    // lock-free list, which the owner drains into its free lists the next
+    // time one of them runs dry.
+
+    template<typename T>
+    class sparse_pool
+    {
+    public:
+
+        using base_real_type = T;
+        using index_type = std::uint32_t;
+
+        // A block is this header followed by capacity indices and then
+        // capacity values. Free blocks keep the header and link through the
+        // bytes after it.
+        struct block
+        {
+            std::uint32_t size;
+            std::uint32_t size_class;
+            sparse_pool*  owner;
+        };
+
+        static constexpr std::size_t classes = 32;
+        static constexpr std::size_t chunk_bytes = std::size_t{1} << 16;
+
+    public:
+
+        // the pool of the calling thread
+        static auto
+        local() noexcept
+            -> sparse_pool&
+        {
+            thread_local sparse_pool pool;
+            return pool;
+        }
+
+        sparse_pool(const sparse_pool&) = delete;
+        auto operator= (const sparse_pool&) -> sparse_pool& = delete;
+
+        ~sparse_pool()
+        {
+            for (void* chunk : m_chunks)
+                ::operator delete(chunk, std::align_val_t{alignment});
+        }
+
+        // a block for at least n entries
+        auto
+        allocate(std::size_t n)
+            -> block*
+        {
+            const auto c = static_cast<std::uint32_t>(std::bit_width(n - 1));
+            if (!m_free[c] && m_remote.load(std::memory_order_relaxed))
+                reclaim();
+            block* b = m_free[c];
+            if (b)
+                m_free[c] = next(b);
+            else
+                b = carve(c);
+            b->size = 0;
+            b->size_class = c;
+            b->owner = this;
+            return b;
+        }
+
+        // Returns b to the pool it came from, which is this one unless b was
+        // allocated on another thread.
+        auto
+        release(block* b) noexcept
+            -> void
+        {
+            if (!b)
+                return;
+            if (b->owner == this)
+            {
+                next(b) = m_free[b->size_class];
+                m_free[b->size_class] = b;
+                return;
+            }
+            auto& remote = b->owner->m_remote;
+            block* head = remote.load(std::memory_order_relaxed);
+            do
+                next(b) = head;
+            while (!remote.compare_exchange_weak(head, b, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        static auto
+        capacity(const block* b) noexcept
+            -> std::size_t
+        { return std::size_t{1} << b->size_class; }
+
+        static auto
+        indices(block* b) noexcept
+            -> index_type*
+        { return reinterpret_cast<index_type*>(reinterpret_cast<unsigned char*>(b) + sizeof(block)); }
+
+        static auto
+        values(block* b) noexcept
+            -> base_real_type*
+        { return reinterpret_cast<base_real_type*>(reinterpret_cast<unsigned char*>(b) + values_offset(b->size_class)); }
+
+        // chunks taken from the allocator so far
+        auto
+        chunks() const noexcept
+            -> std::size_t
+        { return m_chunks.size(); }
+
+    private:
+
+        static constexpr std::size_t alignment = std::max(alignof(base_real_type), alignof(block*)) < 16 ? 16
+                                               : std::max(alignof(base_real_type), alignof(block*));
+
+        sparse_pool() = default;
+
+        static constexpr auto
+        round_up(std::size_t n, std::size_t a) noexcept
+            -> std::size_t
+        { return (n + a - 1) / a * a; }
+
+        static constexpr auto
+        values_offset(std::size_t c) noexcept
+            -> std::size_t
+        { return round_up(sizeof(block) + (std::size_t{1} << c) * sizeof(index_type), alignof(base_real_type)); }
+
+        static constexpr auto
+        block_bytes(std::size_t c) noexcept
+            -> std::size_t
+        {
+            const std::size_t n = values_offset(c) + (std::size_t{1} << c) * sizeof(base_real_type);
+            return round_up(std::max(n, round_up(sizeof(block), alignof(block*)) + sizeof(block*)), alignment);
+        }
+
+        static auto
+        next(block* b) noexcept
+            -> block*&
+        { return *reinterpret_cast<block**>(reinterpret_cast<unsigned char*>(b) + round_up(sizeof(block), alignof(block*))); }
+
+        // Moves the blocks other threads released to the free lists. Taking
+        // the whole list at once leaves pushes as the only contended
+        // operation, so there is no ABA problem.
+        auto
+        reclaim() noexcept
+            -> void
+        {
+            for (block* b = m_remote.exchange(nullptr, std::memory_order_acquire); b; )
+            {
+                block* after = next(b);
+                release(b);
+                b = after;
+            }
+        }
+
+        // A fresh block of class c from the current chunk, starting a new chunk
+        // when it does not fit. The rest of the old chunk is given to the free
+        // lists rather than lost.
+        auto
+        carve(std::uint32_t c)
+            -> block*
+        {
+            const std::size_t bytes = block_bytes(c);
+            if (static_cast<std::size_t>(m_end - m_cursor) < bytes)
+            {
+                for (std::uint32_t k = c; k-- > 0; )
+                {
+                    while (static_cast<std::size_t>(m_end - m_cursor) >= block_bytes(k))
+                    {
+                        auto* b = reinterpret_cast<block*>(m_cursor);
+                        b->size_class = k;
+                        b->owner = this;
+                        release(b);
+                        m_cursor += block_bytes(k);
+                    }
+                }
+                const std::size_t size = std::max(chunk_bytes, bytes);
+                m_chunks.reserve(m_chunks.size() + 1);
+                m_cursor = static_cast<unsigned char*>(::operator new(size, std::align_val_t{alignment}));
+                m_end = m_cursor + size;
+                m_chunks.push_back(m_cursor);
+            }
+            auto* b = reinterpret_cast<block*>(m_cursor);
+            m_cursor += bytes;
+            return b;
+        }
+
+        std::array<block*, classes> m_free{};
+        // blocks released by other threads
+        std::atomic<block*> m_remote{nullptr};
+        std::vector<void*> m_chunks;
+        unsigned char* m_cursor = nullptr;
+        unsigned char* m_end = nullptr;
+    };
+
+    template<typename T>
+    class sparse_dual
+    {
+    public:
+
+        using base_real_type = T;
+        using pool_type = sparse_pool<T>;
+        using index_type = typename pool_type::index_type;
+
+    public:
+
+        explicit
+        sparse_dual(const base_real_type& re = base_real_type{}) noexcept
+            : m_re{ re }
+        { }
+
+        // input i, with tangent e_i
+        static auto
+        variable(const base_real_type& re, index_type i)
+            -> sparse_dual
+        {
+            sparse_dual x{re};
+            x.m_block = pool_type::local().allocate(1);
+            x.m_block->size = 1;
+            pool_type::indices(x.m_block)[0] = i;
+            pool_type::values(x.m_block)[0] = base_real_type{1};
+            return x;
+        }
+
+        sparse_dual(const sparse_dual& other)
+            : m_re{ other.m_re }
+        {
+            if (other.nnz() == 0)
+                return;
+            m_block = pool_type::local().allocate(other.nnz());
+            m_block->size = other.m_block->size;
+            std::copy_n(other.index_data(), other.nnz(), index_data());
+            std::copy_n(other.value_data(), other.nnz(), value_data());
+        }
+
+        sparse_dual(sparse_dual&& other) noexcept
+            : m_re{ other.m_re }
+            , m_block{ std::exchange(other.m_block, nullptr) }
+        { }
+
+        auto
+        operator= (const sparse_dual& other)
+            -> sparse_dual&
+        {
+            if (this != &other)
+                *this = sparse_dual(other);
+            return *this;
+        }
+
+        auto
+        operator= (sparse_dual&& other) noexcept
+            -> sparse_dual&
+        {
+            if (this != &other)
+            {
+                pool_type::local().release(m_block);
+                m_re = other.m_re;
+                m_block = std::exchange(other.m_block, nullptr);
+            }
+            return *this;
+        }
+
+        ~sparse_dual()
+        { pool_type::local().release(m_block); }
+
+        auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_re; }
+
+        // number of stored tangent entries
+        auto
+        nnz() const noexcept
+            -> std::size_t
+        { return m_block ? m_block->size : 0; }
+
+        auto
+        indices() const noexcept
+            -> std::span<const index_type>
+        { return {index_data(), nnz()}; }
+
+        auto
+        values() const noexcept
+            -> std::span<const base_real_type>
+        { return {value_data(), nnz()}; }
+
+        // the derivative with respect to input i
+        auto
+        d(index_type i) const noexcept
+            -> base_real_type
+        {
+            const auto idx = indices();
+            const auto it = std::lower_bound(idx.begin(), idx.end(), i);
+            return it != idx.end() && *it == i ? value_data()[it - idx.begin()] : base_real_type{};
+        }
+
+        // value a and tangents scaled by s
+        auto
+        chain(const base_real_type& a, const base_real_type& s) const
+            -> sparse_dual
+        {
+            sparse_dual r{a};
+            const std::size_t n = nnz();
+            if (n == 0 || s == base_real_type{})
+                return r;
+            r.m_block = pool_type::local().allocate(n);
+            r.m_block->size = m_block->size;
+            std::copy_n(index_data(), n, r.index_data());
+            const base_real_type* v = value_data();
+            base_real_type* rv = r.value_data();
+            for (std::size_t k = 0; k < n; ++k)
+                rv[k] = s * v[k];
+            return r;
+        }
+
+        // value a and tangents su du + sv dv, merging the two index lists
+        static auto
+        chain(const base_real_type& a, const base_real_type& su, const sparse_dual& u, const base_real_type& sv, const sparse_dual& v)
+            -> sparse_dual
+        {
+            const std::size_t nu = su == base_real_type{} ? 0 : u.nnz();
+            const std::size_t nv = sv == base_real_type{} ? 0 : v.nnz();
+            if (nv == 0)
+                return u.chain(a, nu ? su : base_real_type{});
+            if (nu == 0)
+                return v.chain(a, sv);
+
+            sparse_dual r{a};
+            r.m_block = pool_type::local().allocate(nu + nv);
+            const index_type* ui = u.index_data();
+            const index_type* vi = v.index_data();
+            const base_real_type* uv = u.value_data();
+            const base_real_type* vv = v.value_data();
+            index_type* ri = r.index_data();
+            base_real_type* rv = r.value_data();
+
+            std::size_t i = 0, j = 0, k = 0;
+            while (i < nu && j < nv)
+            {
+                if (ui[i] < vi[j])
+                {
+                    ri[k] = ui[i];
+                    rv[k++] = su * uv[i++];
+                }
+                else if (vi[j] < ui[i])
+                {
+                    ri[k] = vi[j];
+                    rv[k++] = sv * vv[j++];
+                }
+                else
+                {
+                    ri[k] = ui[i];
+                    rv[k++] = su * uv[i++] + sv * vv[j++];
+                }
+            }
+            for (; i < nu; ++i, ++k)
+            {
+                ri[k] = ui[i];
+                rv[k] = su * uv[i];
+            }
+            for (; j < nv; ++j, ++k)
+            {
+                ri[k] = vi[j];
+                rv[k] = sv * vv[j];
+            }
+            r.m_block->size = static_cast<std::uint32_t>(k);
+            return r;
+        }
+
+        ///{@  sparse dual unary arithmetic
+        auto
+        operator+= (const sparse_dual& v)
+            -> sparse_dual&
+        { return *this = *this + v; }
+
+        auto
+        operator-= (const sparse_dual& v)
+            -> sparse_dual&
+        { return *this = *this - v; }
+
+        auto
+        operator*= (const sparse_dual& v)
+            -> sparse_dual&
+        { return *this = *this * v; }
+
+        auto
+        operator/= (const sparse_dual& v)
+            -> sparse_dual&
+        { return *this = *this / v; }
+
+        auto
+        operator+= (const base_real_type& v) noexcept
+            -> sparse_dual&
+        {
+            m_re += v;
+            return *this;
+        }
+
+        auto
+        operator-= (const base_real_type& v) noexcept
+            -> sparse_dual&
+        {
+            m_re -= v;
+            return *this;
+        }
+
+        auto
+        operator*= (const base_real_type& v) noexcept
+            -> sparse_dual&
+        {
+            m_re *= v;
+            base_real_type* d = value_data();
+            for (std::size_t k = 0; k < nnz(); ++k)
+                d[k] *= v;
+            return *this;
+        }
+
+        auto
+        operator/= (const base_real_type& v) noexcept
+            -> sparse_dual&
+        { return *this *= base_real_type{1} / v; }
+        ///@}  sparse dual unary arithmetic
+
+        ///{@  sparse dual arithmetic
+        // defined as friends so that plain numbers convert to base_real_type
+        friend auto
+        operator+ (const sparse_dual& u)
+            -> sparse_dual
+        { return u; }
+
+        friend auto
+        operator- (const sparse_dual& u)
+            -> sparse_dual
+        { return u.chain(-u.m_re, base_real_type{-1}); }
+
+        friend auto
+        operator+ (const sparse_dual& u, const sparse_dual& v)
+            -> sparse_dual
+        { return chain(u.m_re + v.m_re, base_real_type{1}, u, base_real_type{1}, v); }
+
+        friend auto
+        operator- (const sparse_dual& u, const sparse_dual& v)
+            -> sparse_dual
+        { return chain(u.m_re - v.m_re, base_real_type{1}, u, base_real_type{-1}, v); }
+
+        friend auto
+        operator* (const sparse_dual& u, const sparse_dual& v)
+            -> sparse_dual
+        { return chain(u.m_re * v.m_re, v.m_re, u, u.m_re, v); }
+
+        friend auto
+        operator/ (const sparse_dual& u, const sparse_dual& v)
+            -> sparse_dual
+        {
+            const base_real_type inv = base_real_type{1} / v.m_re;
+            const base_real_type q = u.m_re * inv;
+            return chain(q, inv, u, -q * inv, v);
+        }
+
+        friend auto
+        operator+ (sparse_dual u, const base_real_type& v)
+            -> sparse_dual
+        { return std::move(u += v); }
+
+        friend auto
+        operator+ (const base_real_type& u, sparse_dual v)
+            -> sparse_dual
+        { return std::move(v += u); }
+
+        friend auto
+        operator- (sparse_dual u, const base_real_type& v)
+            -> sparse_dual
+        { return std::move(u -= v); }
+
+        friend auto
+        operator- (const base_real_type& u, const sparse_dual& v)
+            -> sparse_dual
+        { return v.chain(u - v.m_re, base_real_type{-1}); }
+
+        friend auto
+        operator* (const sparse_dual& u, const base_real_type& v)
+            -> sparse_dual
+        { return u.chain(u.m_re * v, v); }
+
+        friend auto
+        operator* (const base_real_type& u, const sparse_dual& v)
+            -> sparse_dual
+        { return v.chain(u * v.m_re, u); }
+
+        friend auto
+        operator/ (const sparse_dual& u, const base_real_type& v)
+            -> sparse_dual
+        { return u.chain(u.m_re / v, base_real_type{1} / v); }
+
+        friend auto
+        operator/ (const base_real_type& u, const sparse_dual& v)
+            -> sparse_dual
+        {
+            const base_real_type q = u / v.m_re;
+            return v.chain(q, -q / v.m_re);
+        }
+        ///@}  sparse dual arithmetic
+
+        ///{@   sparse dual comparison operators
+        // on the real part, like dual
+        friend auto
+        operator== (const sparse_dual& u, const sparse_dual& v) noexcept
+            -> bool
+        { return u.m_re == v.m_re; }
+
+        friend auto
+        operator<=> (const sparse_dual& u, const sparse_dual& v) noexcept
+        { return u.m_re <=> v.m_re; }
+
+        friend auto
+        operator== (const sparse_dual& u, const base_real_type& v) noexcept
+            -> bool
+        { return u.m_re == v; }
+
+        friend auto
+        operator<=> (const sparse_dual& u, const base_real_type& v) noexcept
+        { return u.m_re <=> v; }
+        ///@}   sparse dual comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const sparse_dual& v)
+            -> std::ostream&
+        {
+            os << v.m_re << " + {";
+            for (std::size_t k = 0; k < v.nnz(); ++k)
+                os << (k ? ", " : "") << v.index_data()[k] << ": " << v.value_data()[k];
+            os << "}_eps";
+            return os;
+        }
+        ///@}   ostream
+
+    private:
+
+        auto
+        index_data() const noexcept
+            -> index_type*
+        { return m_block ? pool_type::indices(m_block) : nullptr; }
+
+        auto
+        value_data() const noexcept
+            -> base_real_type*
+        { return m_block ? pool_type::values(m_block) : nullptr; }
+
+        base_real_type m_re;
+        typename pool_type::block* m_block = nullptr;
+    };
+
+    ///{@   elementary functions of sparse duals
+    template<typename T>
+    auto
+    sqrt(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    {
+        const T s = std::sqrt(x.re());
+        return x.chain(s, T{1} / (T{2} * s));
+    }
+
+    template<typename T>
+    auto
+    exp(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    {
+        const T e = std::exp(x.re());
+        return x.chain(e, e);
+    }
+
+    template<typename T>
+    auto
+    log(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::log(x.re()), T{1} / x.re()); }
+
+    template<typename T>
+    auto
+    sin(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::sin(x.re()), std::cos(x.re())); }
+
+    template<typename T>
+    auto
+    cos(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::cos(x.re()), -std::sin(x.re())); }
+
+    template<typename T>
+    auto
+    tan(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    {
+        const T t = std::tan(x.re());
+        return x.chain(t, T{1} + t * t);
+    }
+
+    template<typename T>
+    auto
+    atan(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::atan(x.re()), T{1} / (T{1} + x.re() * x.re())); }
+
+    template<typename T>
+    auto
+    tanh(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    {
+        const T c = std::cosh(x.re());
+        return x.chain(std::tanh(x.re()), T{1} / (c * c));
+    }
+
+    template<typename T>
+    auto
+    log1p(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::log1p(x.re()), T{1} / (T{1} + x.re())); }
+
+    template<typename T>
+    auto
+    expm1(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::expm1(x.re()), std::exp(x.re())); }
+
+    template<typename T>
+    auto
+    abs(const sparse_dual<T>& x)
+        -> sparse_dual<T>
+    { return x.chain(std::abs(x.re()), static_cast<T>((T{} < x.re()) - (x.re() < T{}))); }
+
+    template<typename T>
+    auto
+    pow(const sparse_dual<T>& x, const std::type_identity_t<T>& n)
+        -> sparse_dual<T>
+    { return x.chain(std::pow(x.re(), n), n * std::pow(x.re(), n - T{1})); }
+
+    template<typename T>
+    auto
+    pow(const sparse_dual<T>& x, const sparse_dual<T>& n)
+        -> sparse_dual<T>
+    {
+        const T p = std::pow(x.re(), n.re());
+        return sparse_dual<T>::chain(p, n.re() * std::pow(x.re(), n.re() - T{1}), x, n.nnz() ? p * std::log(x.re()) : T{}, n);
+    }
+    ///@}   elementary functions of sparse duals
+
+}  /// namespace dnn
+
+#endif  /// DUAL_SPARSE
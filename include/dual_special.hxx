@@ -0,0 +1,301 @@
+#ifndef DUAL_SPECIAL
+#   define DUAL_SPECIAL
+
+#include <dual_numbers.hxx>
+#include <dual_reduce.hxx>
+
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <type_traits>
+#include <utility>
+
+namespace dnn
+{
+    // Special functions on dual numbers.
+    //
+    // Each derivative is built from quantities the value already needs: erf and
+    // erfc share exp(-x^2), tgamma and lgamma differentiate through the digamma
+    // function, digamma and trigamma share one recurrence, and the Bessel
+    // functions of order 0 and 1 are each other's derivatives so they are
+    // always computed as a pair.
+
+    namespace special_detail
+    {
+        // psi(x) and, when wanted, psi'(x) for real x.
+        // Shifts x up past `shift` with psi(x) = psi(x + 1) - 1/x and
+        // psi'(x) = psi'(x + 1) + 1/x^2, which share the reciprocals, then uses
+        // the asymptotic series. Negative x go through the reflection formulas.
+        template<typename base_real_type, bool with_trigamma>
+        auto
+        polygamma01(base_real_type x) noexcept
+            -> std::pair<base_real_type, base_real_type>
+        {
+            constexpr auto pi = std::numbers::pi_v<base_real_type>;
+            const base_real_type one{1};
+
+            if (x <= base_real_type{0} && x == std::floor(x))
+                return {std::numeric_limits<base_real_type>::quiet_NaN(),
+                        std::numeric_limits<base_real_type>::quiet_NaN()};
+
+            if (x < base_real_type{0.5})
+            {
+                // psi(x) = psi(1 - x) - pi cot(pi x),  psi'(x) = -psi'(1 - x) + pi^2 / sin^2(pi x)
+                const auto [p, t] = polygamma01<base_real_type, with_trigamma>(one - x);
+                const base_real_type s = std::sin(pi * x);
+                const base_real_type c = std::cos(pi * x);
+                return {p - pi * c / s, with_trigamma ? -t + pi * pi / (s * s) : base_real_type{}};
+            }
+
+            // the series stops at B16, the first omitted term is below 1e-17 from 12 on
+            // and below 1e-21 from 16 on
+            constexpr base_real_type shift = std::numeric_limits<base_real_type>::digits > 53 ? 16 : 12;
+
+            base_real_type psi{};
+            base_real_type tri{};
+            for (; x < shift; x += one)
+            {
+                const base_real_type r = one / x;
+                psi -= r;
+                if constexpr (with_trigamma)
+                    tri += r * r;
+            }
+
+            const base_real_type r  = one / x;
+            const base_real_type r2 = r * r;
+            psi += std::log(x) - base_real_type{0.5} * r
+                 - r2 * (base_real_type{1} / 12 - r2 * (base_real_type{1} / 120 - r2 * (base_real_type{1} / 252
+                 - r2 * (base_real_type{1} / 240 - r2 * (base_real_type{1} / 132 - r2 * (base_real_type{691} / 32760
+                 - r2 * (base_real_type{1} / 12 - r2 * (base_real_type{3617} / 8160))))))));
+            if constexpr (with_trigamma)
+                tri += r + base_real_type{0.5} * r2
+                     + r * r2 * (base_real_type{1} / 6 - r2 * (base_real_type{1} / 30 - r2 * (base_real_type{1} / 42
+                     - r2 * (base_real_type{1} / 30 - r2 * (base_real_type{5} / 66 - r2 * (base_real_type{691} / 2730
+                     - r2 * (base_real_type{7} / 6 - r2 * (base_real_type{3617} / 510))))))));
+            return {psi, tri};
+        }
+
+        // 2/sqrt(pi) exp(-x^2), the derivative of erf. x^2 is carried with its
+        // rounding error, which exp would otherwise amplify by x^2.
+        template<typename base_real_type>
+        auto
+        erf_slope(base_real_type x) noexcept
+            -> base_real_type
+        {
+            const base_real_type x2 = x * x;
+            const base_real_type e  = reduce_detail::product_error(x, x, x2);
+            return base_real_type{2} * std::numbers::inv_sqrtpi_v<base_real_type> * std::exp(-x2) * (base_real_type{1} - e);
+        }
+
+        // libstdc++ evaluates the float Bessel functions in float and loses
+        // most of the digits, they are evaluated in double instead
+        template<typename real_type>
+        using bessel_type = std::conditional_t<std::is_same_v<real_type, float>, double, real_type>;
+    }  /// namespace special_detail
+
+    ///{@   special functions on scalars
+    template<scalar base_real_type>
+    auto
+    erf(const base_real_type& u)
+    {
+        return std::erf(u);
+    }
+
+    template<scalar base_real_type>
+    auto
+    erfc(const base_real_type& u)
+    {
+        return std::erfc(u);
+    }
+
+    template<scalar base_real_type>
+    auto
+    tgamma(const base_real_type& u)
+    {
+        return std::tgamma(u);
+    }
+
+    template<scalar base_real_type>
+    auto
+    lgamma(const base_real_type& u)
+    {
+        return std::lgamma(u);
+    }
+
+    template<scalar base_real_type>
+    auto
+    digamma(const base_real_type& u)
+    {
+        return special_detail::polygamma01<base_real_type, false>(u).first;
+    }
+
+    template<scalar base_real_type>
+    auto
+    trigamma(const base_real_type& u)
+    {
+        return special_detail::polygamma01<base_real_type, true>(u).second;
+    }
+
+    // std::cyl_bessel_j rejects negative arguments, J0 is even and J1 odd
+    template<scalar base_real_type>
+    auto
+    j0(const base_real_type& u)
+    {
+        using real_type = decltype(std::cyl_bessel_j(u, u));
+        using wide_type = special_detail::bessel_type<real_type>;
+        return static_cast<real_type>(std::cyl_bessel_j(wide_type{0}, std::abs(static_cast<wide_type>(u))));
+    }
+
+    template<scalar base_real_type>
+    auto
+    j1(const base_real_type& u)
+    {
+        using real_type = decltype(std::cyl_bessel_j(u, u));
+        using wide_type = special_detail::bessel_type<real_type>;
+        const wide_type x = static_cast<wide_type>(u);
+        return static_cast<real_type>(x < wide_type{} ? -std::cyl_bessel_j(wide_type{1}, -x) : std::cyl_bessel_j(wide_type{1}, x));
+    }
+
+    template<scalar base_real_type>
+    auto
+    y0(const base_real_type& u)
+    {
+        using real_type = decltype(std::cyl_neumann(u, u));
+        using wide_type = special_detail::bessel_type<real_type>;
+        return static_cast<real_type>(std::cyl_neumann(wide_type{0}, static_cast<wide_type>(u)));
+    }
+
+    template<scalar base_real_type>
+    auto
+    y1(const base_real_type& u)
+    {
+        using real_type = decltype(std::cyl_neumann(u, u));
+        using wide_type = special_detail::bessel_type<real_type>;
+        return static_cast<real_type>(std::cyl_neumann(wide_type{1}, static_cast<wide_type>(u)));
+    }
+    ///@}   special functions on scalars
+
+    ///{@   error functions
+    // erf(x) and erfc(x) together, both derivatives are -+2/sqrt(pi) exp(-x^2)
+    template<typename base_real_type>
+    auto
+    erf_erfc(const dual<base_real_type>& dn)
+        -> std::pair<dual<base_real_type>, dual<base_real_type>>
+    {
+        const base_real_type x = dn.re();
+        const base_real_type g = special_detail::erf_slope(x) * dn.d();
+        return {dual<base_real_type>{std::erf(x), g}, dual<base_real_type>{std::erfc(x), -g}};
+    }
+
+    template<typename base_real_type>
+    auto
+    erf(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        const base_real_type x = dn.re();
+        return dual<base_real_type>{std::erf(x), special_detail::erf_slope(x) * dn.d()};
+    }
+
+    template<typename base_real_type>
+    auto
+    erfc(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        const base_real_type x = dn.re();
+        return dual<base_real_type>{std::erfc(x), -special_detail::erf_slope(x) * dn.d()};
+    }
+    ///@}   error functions
+
+    ///{@   gamma functions
+    // Gamma'(x) = Gamma(x) psi(x), reusing the value
+    template<typename base_real_type>
+    auto
+    tgamma(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        const base_real_type g = std::tgamma(dn.re());
+        return dual<base_real_type>{g, g * digamma(dn.re()) * dn.d()};
+    }
+
+    // (log |Gamma(x)|)' = psi(x)
+    template<typename base_real_type>
+    auto
+    lgamma(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        return dual<base_real_type>{std::lgamma(dn.re()), digamma(dn.re()) * dn.d()};
+    }
+
+    // psi'(x) comes out of the same recurrence as psi(x)
+    template<typename base_real_type>
+    auto
+    digamma(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        const auto [psi, tri] = special_detail::polygamma01<base_real_type, true>(dn.re());
+        return dual<base_real_type>{psi, tri * dn.d()};
+    }
+    ///@}   gamma functions
+
+    ///{@   Bessel functions
+    // J0(x) and J1(x) together, with J0' = -J1 and J1' = J0 - J1/x (1/2 at x = 0)
+    template<typename base_real_type>
+    auto
+    j01(const dual<base_real_type>& dn)
+        -> std::pair<dual<base_real_type>, dual<base_real_type>>
+    {
+        const base_real_type x   = dn.re();
+        const base_real_type b0  = j0(x);
+        const base_real_type b1  = j1(x);
+        const base_real_type db1 = x == base_real_type{} ? base_real_type{0.5} : b0 - b1 / x;
+        return {dual<base_real_type>{b0, -b1 * dn.d()}, dual<base_real_type>{b1, db1 * dn.d()}};
+    }
+
+    // Y0(x) and Y1(x) together, with Y0' = -Y1 and Y1' = Y0 - Y1/x
+    template<typename base_real_type>
+    auto
+    y01(const dual<base_real_type>& dn)
+        -> std::pair<dual<base_real_type>, dual<base_real_type>>
+    {
+        const base_real_type x  = dn.re();
+        const base_real_type b0 = y0(x);
+        const base_real_type b1 = y1(x);
+        return {dual<base_real_type>{b0, -b1 * dn.d()}, dual<base_real_type>{b1, (b0 - b1 / x) * dn.d()}};
+    }
+
+    template<typename base_real_type>
+    auto
+    j0(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        return j01(dn).first;
+    }
+
+    template<typename base_real_type>
+    auto
+    j1(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        return j01(dn).second;
+    }
+
+    template<typename base_real_type>
+    auto
+    y0(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        return y01(dn).first;
+    }
+
+    template<typename base_real_type>
+    auto
+    y1(const dual<base_real_type>& dn)
+        -> dual<base_real_type>
+    {
+        return y01(dn).second;
+    }
+    ///@}   Bessel functions
+
+}  /// namespace dnn
+
+#endif  /// DUAL_SPECIAL
@@ -0,0 +1,254 @@
+#ifndef DUAL_STREAM
+#   define DUAL_STREAM
+
+#include <dual_numbers.hxx>
+#include <dual_multi.hxx>
+#include <dual_sweep.hxx>
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dnn
+{
+    // Samples of curves and sweeps streamed in batches, pulled on demand.
+    //
+    // generator<T> is a minimal std::generator, which libstdc++ only ships
+    // from GCC 14: a coroutine that co_yields values of T, consumed by a range
+    // for or by iterating begin() to end(). Nothing runs until the consumer
+    // asks for the next value, and a consumer that stops early destroys the
+    // coroutine and whatever it holds.
+    //
+    // curve_samples and sweep_samples yield std::span views of one buffer of
+    // batch samples, refilled for every batch, so a stream of any length, or
+    // an endless one, runs in the memory of a single batch. A span is valid
+    // until the consumer advances; copy out whatever must outlive that.
+
+    template<typename T>
+    class generator
+    {
+    public:
+
+        using value_type = std::remove_cvref_t<T>;
+
+        struct promise_type
+        {
+            const value_type* value = nullptr;
+            std::exception_ptr error;
+
+            auto
+            get_return_object() noexcept
+                -> generator
+            { return generator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+
+            auto
+            initial_suspend() const noexcept
+                -> std::suspend_always
+            { return {}; }
+
+            auto
+            final_suspend() const noexcept
+                -> std::suspend_always
+            { return {}; }
+
+            // the yielded value, temporaries included, lives until resumption
+            auto
+            yield_value(const value_type& v) noexcept
+                -> std::suspend_always
+            {
+                value = std::addressof(v);
+                return {};
+            }
+
+            auto
+            return_void() const noexcept
+                -> void
+            { }
+
+            auto
+            unhandled_exception() noexcept
+                -> void
+            { error = std::current_exception(); }
+
+            // a generator only yields
+            template<typename U>
+            auto await_transform(U&&) -> std::suspend_never = delete;
+        };
+
+        class iterator
+        {
+        public:
+
+            using value_type = generator::value_type;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+
+            auto
+            operator*() const noexcept
+                -> const value_type&
+            { return *m_coroutine.promise().value; }
+
+            auto
+            operator->() const noexcept
+                -> const value_type*
+            { return m_coroutine.promise().value; }
+
+            auto
+            operator++()
+                -> iterator&
+            {
+                advance(m_coroutine);
+                return *this;
+            }
+
+            auto
+            operator++(int)
+                -> void
+            { ++*this; }
+
+            friend auto
+            operator== (const iterator& it, std::default_sentinel_t) noexcept
+                -> bool
+            { return !it.m_coroutine || it.m_coroutine.done(); }
+
+        private:
+
+            friend class generator;
+
+            explicit
+            iterator(std::coroutine_handle<promise_type> coroutine) noexcept
+                : m_coroutine{ coroutine }
+            { }
+
+            std::coroutine_handle<promise_type> m_coroutine;
+        };
+
+    public:
+
+        generator(generator&& other) noexcept
+            : m_coroutine{ std::exchange(other.m_coroutine, {}) }
+        { }
+
+        auto
+        operator= (generator&& other) noexcept
+            -> generator&
+        {
+            if (this != &other)
+            {
+                if (m_coroutine)
+                    m_coroutine.destroy();
+                m_coroutine = std::exchange(other.m_coroutine, {});
+            }
+            return *this;
+        }
+
+        ~generator()
+        {
+            if (m_coroutine)
+                m_coroutine.destroy();
+        }
+
+        // starts the coroutine; a generator is iterated once
+        auto
+        begin()
+            -> iterator
+        {
+            advance(m_coroutine);
+            return iterator{m_coroutine};
+        }
+
+        auto
+        end() const noexcept
+            -> std::default_sentinel_t
+        { return {}; }
+
+    private:
+
+        explicit
+        generator(std::coroutine_handle<promise_type> coroutine) noexcept
+            : m_coroutine{ coroutine }
+        { }
+
+        // runs to the next co_yield and rethrows what the body threw
+        static auto
+        advance(std::coroutine_handle<promise_type> coroutine)
+            -> void
+        {
+            coroutine.resume();
+            if (auto error = std::exchange(coroutine.promise().error, nullptr))
+                std::rethrow_exception(error);
+        }
+
+        std::coroutine_handle<promise_type> m_coroutine;
+    };
+
+    // count that never runs out
+    inline constexpr std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+
+    // f(t) for t = t0 + i step, i < count, with t seeded as the variable, so
+    // the tangents of each sample are derivatives along the curve. A batch of
+    // 0 throws std::invalid_argument when iteration begins.
+    template<typename T, typename function_type>
+    auto
+    curve_samples(function_type f, std::type_identity_t<T> t0, std::type_identity_t<T> step,
+                  std::size_t count = unbounded, std::size_t batch = 256)
+        -> generator<std::span<const std::invoke_result_t<function_type&, const dual<T>&>>>
+    {
+        using sample_type = std::invoke_result_t<function_type&, const dual<T>&>;
+
+        if (batch == 0)
+            throw std::invalid_argument("dnn: curve samples need a batch of at least one");
+        std::vector<sample_type> buffer;
+        buffer.reserve(batch);
+        for (std::size_t i = 0; i < count;)
+        {
+            buffer.clear();
+            for (; i < count && buffer.size() < batch; ++i)
+                buffer.push_back(f(dual<T>{t0 + static_cast<T>(i) * step, T{1}}));
+            co_yield std::span<const sample_type>{buffer};
+        }
+    }
+
+    // f at every point of g in the order sweep uses, with one tangent per
+    // axis, serially and in the memory of one batch, which must not be 0.
+    template<typename T, std::size_t N, typename function_type>
+    auto
+    sweep_samples(sweep_grid<T, N> g, function_type f, std::size_t batch = 256)
+        -> generator<std::span<const std::invoke_result_t<function_type&, const std::array<mdual<T, N>, N>&>>>
+    {
+        using input_type = std::array<mdual<T, N>, N>;
+        using sample_type = std::invoke_result_t<function_type&, const input_type&>;
+
+        if (batch == 0)
+            throw std::invalid_argument("dnn: sweep samples need a batch of at least one");
+        std::vector<sample_type> buffer;
+        buffer.reserve(batch);
+        const std::size_t points = g.points();
+        for (std::size_t i = 0; i < points;)
+        {
+            buffer.clear();
+            for (; i < points && buffer.size() < batch; ++i)
+            {
+                const auto x = g.point(i);
+                input_type v;
+                for (std::size_t k = 0; k < N; ++k)
+                    v[k] = mdual<T, N>::variable(x[k], k);
+                buffer.push_back(f(v));
+            }
+            co_yield std::span<const sample_type>{buffer};
+        }
+    }
+
+}  /// namespace dnn
+
+#endif  /// DUAL_STREAM
@@ -0,0 +1,415 @@
+#ifndef DUAL_SWEEP
+#   define DUAL_SWEEP
+
+#include <dual_numbers.hxx>
+#include <dual_multi.hxx>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dnn
+{
+    // Parallel evaluation of a dual valued model over a parameter grid.
+    //
+    // sweep_pool runs a loop body over [0, n) on a fixed set of threads, the
+    // caller being one of them. Each thread starts with an equal share of the
+    // range and takes chunks off its front; a thread that runs dry steals the
+    // back half of another thread's remainder, so uneven per-point cost does
+    // not leave threads idle the way static partitioning does. The chunk size
+    // is tuned per thread while it runs: it doubles while chunks take less
+    // than target_chunk_time and halves while they take more than twice that.
+    //
+    // sweep evaluates f at every point of a sweep_grid, seeding one tangent per
+    // axis with mdual<T, N>, and writes the value and the N partials at each
+    // point into preallocated sweep_output planes.
+
+    class sweep_pool
+    {
+    public:
+
+        // counters of the last run
+        struct statistics
+        {
+            std::size_t chunks = 0;
+            std::size_t steals = 0;
+        };
+
+        static constexpr auto target_chunk_time = std::chrono::microseconds{20};
+
+    public:
+
+        // threads counts the caller, so sweep_pool{1} runs serially
+        explicit
+        sweep_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+            : m_slots(std::max<std::size_t>(threads, 1))
+        {
+            for (std::size_t k = 1; k < m_slots.size(); ++k)
+                m_threads.emplace_back([this, k] { work(k); });
+        }
+
+        sweep_pool(const sweep_pool&) = delete;
+        auto operator= (const sweep_pool&) -> sweep_pool& = delete;
+
+        ~sweep_pool()
+        {
+            {
+                std::lock_guard lock{m_mutex};
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& t : m_threads)
+                t.join();
+        }
+
+        // a pool with a thread per core, shared by the whole program
+        static auto
+        shared()
+            -> sweep_pool&
+        {
+            static sweep_pool pool;
+            return pool;
+        }
+
+        auto
+        size() const noexcept
+            -> std::size_t
+        { return m_slots.size(); }
+
+        auto
+        last_run() const noexcept
+            -> statistics
+        { return m_statistics; }
+
+        // Calls body(begin, end) on disjoint chunks covering [0, n) and returns
+        // when all are done. Calls from different threads take turns; calling
+        // run from inside a body deadlocks. The first exception thrown by a
+        // body is rethrown here once the remaining chunks have been skipped.
+        template<typename body_type>
+        auto
+        run(std::size_t n, body_type&& body)
+            -> void
+        {
+            using function_type = std::remove_reference_t<body_type>;
+
+            std::lock_guard turn{m_turn};
+            if (n == 0)
+                return;
+
+            m_job = [](void* context, std::size_t begin, std::size_t end)
+            { (*static_cast<function_type*>(context))(begin, end); };
+            m_context = const_cast<void*>(static_cast<const void*>(std::addressof(body)));
+            m_error = nullptr;
+            m_failed.store(false, std::memory_order_relaxed);
+            m_chunks.store(0, std::memory_order_relaxed);
+            m_steals.store(0, std::memory_order_relaxed);
+
+            const std::size_t threads = m_slots.size();
+            for (std::size_t k = 0; k < threads; ++k)
+            {
+                std::lock_guard lock{m_slots[k].mutex};
+                m_slots[k].begin = n * k / threads;
+                m_slots[k].end = n * (k + 1) / threads;
+            }
+
+            {
+                std::lock_guard lock{m_mutex};
+                m_active = threads - 1;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+
+            drain(0);
+
+            {
+                std::unique_lock lock{m_mutex};
+                m_idle.wait(lock, [this] { return m_active == 0; });
+            }
+            m_statistics = {m_chunks.load(std::memory_order_relaxed), m_steals.load(std::memory_order_relaxed)};
+            if (m_error)
+                std::rethrow_exception(m_error);
+        }
+
+    private:
+
+        // a thread's remaining range, on its own cache line
+        struct alignas(64) slot
+        {
+            std::mutex mutex;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+        };
+
+        auto
+        work(std::size_t k)
+            -> void
+        {
+            std::uint64_t seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock lock{m_mutex};
+                    m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                    if (m_stop)
+                        return;
+                    seen = m_generation;
+                }
+
+                drain(k);
+
+                {
+                    std::lock_guard lock{m_mutex};
+                    --m_active;
+                }
+                m_idle.notify_one();
+            }
+        }
+
+        // Runs chunks from slot k, then steals, until every slot is empty.
+        auto
+        drain(std::size_t k)
+            -> void
+        {
+            using clock = std::chrono::steady_clock;
+
+            slot& own = m_slots[k];
+            std::size_t chunk = 1;
+            std::size_t chunks = 0, steals = 0;
+            for (;;)
+            {
+                std::size_t begin, end;
+                {
+                    std::lock_guard lock{own.mutex};
+                    begin = own.begin;
+                    end = std::min(own.end, begin + chunk);
+                    own.begin = end;
+                }
+
+                if (begin == end)
+                {
+                    if (!steal(k))
+                        break;
+                    ++steals;
+                    continue;
+                }
+
+                const auto start = clock::now();
+                if (!m_failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        m_job(m_context, begin, end);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard lock{m_mutex};
+                        if (!m_error)
+                            m_error = std::current_exception();
+                        m_failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                const auto elapsed = clock::now() - start;
+                ++chunks;
+
+                // only a full chunk tells whether a larger one would pay; growing
+                // on short ones too would wrap chunk around to 0 eventually
+                if (elapsed < target_chunk_time / 2 && end - begin == chunk)
+                    chunk *= 2;
+                else if (elapsed > target_chunk_time * 2 && chunk > 1)
+                    chunk /= 2;
+            }
+            m_chunks.fetch_add(chunks, std::memory_order_relaxed);
+            m_steals.fetch_add(steals, std::memory_order_relaxed);
+        }
+
+        // Moves the back half of another slot's range into slot k, trying the
+        // slots after k in turn; false when all of them are empty.
+        auto
+        steal(std::size_t k)
+            -> bool
+        {
+            const std::size_t threads = m_slots.size();
+            for (std::size_t step = 1; step < threads; ++step)
+            {
+                slot& victim = m_slots[(k + step) % threads];
+                std::size_t begin, end;
+                {
+                    std::lock_guard lock{victim.mutex};
+                    const std::size_t left = victim.end - victim.begin;
+                    if (left == 0)
+                        continue;
+                    end = victim.end;
+                    begin = end - (left + 1) / 2;
+                    victim.end = begin;
+                }
+                std::lock_guard lock{m_slots[k].mutex};
+                m_slots[k].begin = begin;
+                m_slots[k].end = end;
+                return true;
+            }
+            return false;
+        }
+
+        std::vector<slot> m_slots;
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_turn;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::uint64_t m_generation = 0;
+        std::size_t m_active = 0;
+        bool m_stop = false;
+
+        void (*m_job)(void*, std::size_t, std::size_t) = nullptr;
+        void* m_context = nullptr;
+        std::exception_ptr m_error;
+        std::atomic<bool> m_failed{false};
+        std::atomic<std::size_t> m_chunks{0};
+        std::atomic<std::size_t> m_steals{0};
+        statistics m_statistics;
+    };
+
+    // count points from lo to hi inclusive, or just lo when count is 1
+    template<typename T>
+    struct sweep_axis
+    {
+        T lo;
+        T hi;
+        std::size_t count;
+
+        constexpr auto
+        operator[](std::size_t k) const noexcept
+            -> T
+        { return count > 1 ? lo + (hi - lo) * static_cast<T>(k) / static_cast<T>(count - 1) : lo; }
+    };
+
+    // The product of N axes, numbered in row major order, the last axis
+    // varying fastest.
+    template<typename T, std::size_t N>
+    struct sweep_grid
+    {
+        std::array<sweep_axis<T>, N> axes;
+
+        constexpr auto
+        points() const noexcept
+            -> std::size_t
+        {
+            std::size_t n = 1;
+            for (const auto& a : axes)
+                n *= a.count;
+            return n;
+        }
+
+        constexpr auto
+        point(std::size_t i) const noexcept
+            -> std::array<T, N>
+        {
+            std::array<T, N> x;
+            for (std::size_t k = N; k-- > 0;)
+            {
+                x[k] = axes[k][i % axes[k].count];
+                i /= axes[k].count;
+            }
+            return x;
+        }
+    };
+
+    // One output of a sweep as planes: re[i] is the value at point i and d[k][i]
+    // its partial along axis k.
+    template<typename T, std::size_t N>
+    struct sweep_output
+    {
+        std::vector<T> re;
+        std::array<std::vector<T>, N> d;
+
+        sweep_output() = default;
+
+        explicit
+        sweep_output(std::size_t points)
+            : re(points)
+        {
+            for (auto& plane : d)
+                plane.resize(points);
+        }
+
+        auto
+        size() const noexcept
+            -> std::size_t
+        { return re.size(); }
+    };
+
+    namespace sweep_detail
+    {
+        template<typename>
+        inline constexpr std::size_t outputs = 1;
+
+        template<typename T, std::size_t M>
+        inline constexpr std::size_t outputs<std::array<T, M>> = M;
+    }
+
+    // Evaluates f, taking std::array<mdual<T, N>, N> and returning mdual<T, N>
+    // or std::array<mdual<T, N>, M>, at every point of g into out, which must
+    // hold one output per result, each sized to g.points().
+    template<typename T, std::size_t N, std::size_t extent, typename function_type>
+    auto
+    sweep(const sweep_grid<T, N>& g, function_type f, std::span<sweep_output<T, N>, extent> out, sweep_pool& pool = sweep_pool::shared())
+        -> void
+    {
+        using input_type = std::array<mdual<T, N>, N>;
+        using result_type = std::invoke_result_t<function_type&, const input_type&>;
+        constexpr std::size_t outputs = sweep_detail::outputs<result_type>;
+
+        const std::size_t points = g.points();
+        if (out.size() != outputs)
+            throw std::invalid_argument("dnn: sweep needs one output per result of the model");
+        for (const auto& o : out)
+            if (o.size() != points)
+                throw std::invalid_argument("dnn: sweep output is not sized to the grid");
+
+        pool.run(points, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const auto x = g.point(i);
+                input_type v;
+                for (std::size_t k = 0; k < N; ++k)
+                    v[k] = mdual<T, N>::variable(x[k], k);
+
+                const auto y = f(v);
+                auto store = [&](sweep_output<T, N>& o, const mdual<T, N>& r)
+                {
+                    o.re[i] = r.re();
+                    for (std::size_t k = 0; k < N; ++k)
+                        o.d[k][i] = r.d(k);
+                };
+                if constexpr (outputs == 1 && !std::is_same_v<result_type, std::array<mdual<T, N>, 1>>)
+                    store(out[0], y);
+                else
+                    for (std::size_t m = 0; m < outputs; ++m)
+                        store(out[m], y[m]);
+            }
+        });
+    }
+
+    template<typename T, std::size_t N, typename function_type>
+    auto
+    sweep(const sweep_grid<T, N>& g, function_type f, sweep_output<T, N>& out, sweep_pool& pool = sweep_pool::shared())
+        -> void
+    { sweep(g, std::move(f), std::span<sweep_output<T, N>>{&out, 1}, pool); }
+
+}  /// namespace dnn
+
+#endif  /// DUAL_SWEEP
@@ -0,0 +1,686 @@
+#ifndef DUAL_TRACE
+#   define DUAL_TRACE
+
+#include <dual_numbers.hxx>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dnn
+{
+    // Recording a function once and replaying it at new points.
+    //
+    // trace<T>::record runs f once with traced<T> inputs. Every operation and
+    // elementary function on them appends an instruction to a flat array, so
+    // the result is the straight-line program f took at that point, with the
+    // user's control flow, virtual calls and allocations gone. replay runs the
+    // instructions at new inputs and tangent seeds in one loop over that array,
+    // through the dual<T> operators themselves, so its results are bit for bit
+    // those of evaluating f with dual<T>.
+    //
+    // Comparisons of traced values are recorded as guards holding the outcome
+    // seen while recording. replay checks them and returns false as soon as
+    // one comes out differently, since f would have taken another path there;
+    // the caller then records again, which traced_function does by itself.
+    // Branching on re() is not seen by the trace and is not guarded.
+    //
+    // Instruction i writes slot inputs() + i; slots [0, inputs()) are the
+    // inputs. An instruction names its arguments by slot, or by index into
+    // constants() for the _c forms, which take the constant as the second
+    // argument and have an r_ form for when it is the first.
+
+    enum class trace_op : std::uint8_t
+    {
+        add, sub, mul, div, neg,
+        sqrt, sin, cos, tan, exp, log, pow,
+        acos, asin, atan, hypot,
+        sinh, cosh, tanh, atan2,
+        log1p, expm1, cbrt, abs,
+
+        add_c, sub_c, rsub_c, mul_c, div_c, rdiv_c,
+        pow_c, rpow_c, hypot_c, atan2_c, ratan2_c,
+
+        // guards, flag holds the recorded outcome
+        guard_less, guard_less_equal, guard_equal,
+        guard_less_c, guard_greater_c, guard_less_equal_c, guard_greater_equal_c, guard_equal_c
+    };
+
+    // 12 bytes
+    struct trace_instruction
+    {
+        trace_op op;
+        std::uint8_t flag;
+        std::uint32_t a;
+        std::uint32_t b;
+    };
+
+    template<typename T>
+    class traced;
+
+    template<typename T>
+    class trace
+    {
+    public:
+
+        using base_real_type = T;
+        using slot_type = std::uint32_t;
+
+    public:
+
+        trace() = default;
+
+        // Runs f once at x with tangent seed, f taking a const std::vector<traced<T>>&
+        // and returning a traced<T> or a range of them.
+        template<typename function_type>
+        static auto
+        record(function_type&& f, std::span<const base_real_type> x, std::span<const base_real_type> seed = {})
+            -> trace
+        {
+            trace t;
+            t.m_inputs = static_cast<slot_type>(x.size());
+
+            recording_guard active{t};
+            std::vector<traced<T>> inputs;
+            inputs.reserve(x.size());
+            for (std::size_t i = 0; i < x.size(); ++i)
+                inputs.push_back(traced<T>{dual<T>{x[i], i < seed.size() ? seed[i] : base_real_type{}}, static_cast<slot_type>(i)});
+
+            const auto y = f(static_cast<const std::vector<traced<T>>&>(inputs));
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(y)>, traced<T>>)
+                t.m_outputs.push_back(y.slot());
+            else
+                for (const auto& v : y)
+                    t.m_outputs.push_back(v.slot());
+            return t;
+        }
+
+        auto
+        inputs() const noexcept
+            -> std::size_t
+        { return m_inputs; }
+
+        auto
+        outputs() const noexcept
+            -> std::span<const slot_type>
+        { return m_outputs; }
+
+        auto
+        instructions() const noexcept
+            -> std::span<const trace_instruction>
+        { return m_instructions; }
+
+        auto
+        constants() const noexcept
+            -> std::span<const base_real_type>
+        { return m_constants; }
+
+        auto
+        guards() const noexcept
+            -> std::size_t
+        { return m_guards; }
+
+        auto
+        empty() const noexcept
+            -> bool
+        { return m_instructions.empty() && m_outputs.empty(); }
+
+        // Evaluates the trace at x with tangent seed into y, one dual per
+        // output. False when a guard fails, y is then unspecified.
+        auto
+        replay(std::span<const base_real_type> x, std::span<const base_real_type> seed, std::span<dual<T>> y) const
+            -> bool
+        {
+            if (x.size() != m_inputs || seed.size() != m_inputs || y.size() != m_outputs.size())
+                throw std::invalid_argument("dnn: trace replayed with the wrong number of inputs or outputs");
+
+            thread_local std::vector<dual<T>> scratch;
+            scratch.resize(m_inputs + m_instructions.size());
+            dual<T>* const s = scratch.data();
+            const base_real_type* const c = m_constants.data();
+
+            for (std::size_t i = 0; i < m_inputs; ++i)
+                s[i] = dual<T>{x[i], seed[i]};
+
+            dual<T>* out = s + m_inputs;
+            for (const trace_instruction& in : m_instructions)
+            {
+                const dual<T>& a = s[in.a];
+                switch (in.op)
+                {
+                    case trace_op::add:      *out = a + s[in.b]; break;
+                    case trace_op::sub:      *out = a - s[in.b]; break;
+                    case trace_op::mul:      *out = a * s[in.b]; break;
+                    case trace_op::div:      *out = a / s[in.b]; break;
+                    case trace_op::neg:      *out = -a; break;
+                    case trace_op::sqrt:     *out = dnn::sqrt(a); break;
+                    case trace_op::sin:      *out = dnn::sin(a); break;
+                    case trace_op::cos:      *out = dnn::cos(a); break;
+                    case trace_op::tan:      *out = dnn::tan(a); break;
+                    case trace_op::exp:      *out = dnn::exp(a); break;
+                    case trace_op::log:      *out = dnn::log(a); break;
+                    case trace_op::pow:      *out = dnn::pow(a, s[in.b]); break;
+                    case trace_op::acos:     *out = dnn::acos(a); break;
+                    case trace_op::asin:     *out = dnn::asin(a); break;
+                    case trace_op::atan:     *out = dnn::atan(a); break;
+                    case trace_op::hypot:    *out = dnn::hypot(a, s[in.b]); break;
+                    case trace_op::sinh:     *out = dnn::sinh(a); break;
+                    case trace_op::cosh:     *out = dnn::cosh(a); break;
+                    case trace_op::tanh:     *out = dnn::tanh(a); break;
+                    case trace_op::atan2:    *out = dnn::atan2(a, s[in.b]); break;
+                    case trace_op::log1p:    *out = dnn::log1p(a); break;
+                    case trace_op::expm1:    *out = dnn::expm1(a); break;
+                    case trace_op::cbrt:     *out = dnn::cbrt(a); break;
+                    case trace_op::abs:      *out = dnn::abs(a); break;
+
+                    case trace_op::add_c:    *out = a + c[in.b]; break;
+                    case trace_op::sub_c:    *out = a - c[in.b]; break;
+                    case trace_op::rsub_c:   *out = c[in.b] - a; break;
+                    case trace_op::mul_c:    *out = a * c[in.b]; break;
+                    case trace_op::div_c:    *out = a / c[in.b]; break;
+                    case trace_op::rdiv_c:   *out = c[in.b] / a; break;
+                    case trace_op::pow_c:    *out = dnn::pow(a, c[in.b]); break;
+                    case trace_op::rpow_c:   *out = dnn::pow(c[in.b], a); break;
+                    case trace_op::hypot_c:  *out = dnn::hypot(a, c[in.b]); break;
+                    case trace_op::atan2_c:  *out = dnn::atan2(a, c[in.b]); break;
+                    case trace_op::ratan2_c: *out = dnn::atan2(c[in.b], a); break;
+
+                    case trace_op::guard_less:            if ((a.re() < s[in.b].re()) != bool(in.flag)) return false; break;
+                    case trace_op::guard_less_equal:      if ((a.re() <= s[in.b].re()) != bool(in.flag)) return false; break;
+                    case trace_op::guard_equal:           if ((a.re() == s[in.b].re()) != bool(in.flag)) return false; break;
+                    case trace_op::guard_less_c:          if ((a.re() < c[in.b]) != bool(in.flag)) return false; break;
+                    case trace_op::guard_greater_c:       if ((a.re() > c[in.b]) != bool(in.flag)) return false; break;
+                    case trace_op::guard_less_equal_c:    if ((a.re() <= c[in.b]) != bool(in.flag)) return false; break;
+                    case trace_op::guard_greater_equal_c: if ((a.re() >= c[in.b]) != bool(in.flag)) return false; break;
+                    case trace_op::guard_equal_c:         if ((a.re() == c[in.b]) != bool(in.flag)) return false; break;
+                }
+                ++out;
+            }
+
+            for (std::size_t k = 0; k < m_outputs.size(); ++k)
+                y[k] = s[m_outputs[k]];
+            return true;
+        }
+
+    private:
+
+        friend class traced<T>;
+
+        // makes t the calling thread's recording for its lifetime, restoring the previous one after
+        class recording_guard
+        {
+        public:
+
+            explicit
+            recording_guard(trace& t) noexcept
+                : m_previous{ std::exchange(active(), &t) }
+            { }
+
+            recording_guard(const recording_guard&) = delete;
+            auto operator= (const recording_guard&) -> recording_guard& = delete;
+
+            ~recording_guard()
+            { active() = m_previous; }
+
+        private:
+
+            trace* m_previous;
+        };
+
+        static auto
+        active() noexcept
+            -> trace*&
+        {
+            thread_local trace* current = nullptr;
+            return current;
+        }
+
+        static auto
+        current()
+            -> trace&
+        {
+            trace* t = active();
+            if (!t)
+                throw std::logic_error("dnn: traced value used outside of trace::record");
+            return *t;
+        }
+
+        auto
+        emit(trace_op op, std::uint32_t a, std::uint32_t b = 0, bool flag = false)
+            -> slot_type
+        {
+            m_instructions.push_back({op, static_cast<std::uint8_t>(flag), a, b});
+            if (op >= trace_op::guard_less)
+                ++m_guards;
+            return static_cast<slot_type>(m_inputs + m_instructions.size() - 1);
+        }
+
+        auto
+        constant(const base_real_type& v)
+            -> std::uint32_t
+        {
+            m_constants.push_back(v);
+            return static_cast<std::uint32_t>(m_constants.size() - 1);
+        }
+
+        std::vector<trace_instruction> m_instructions;
+        std::vector<base_real_type> m_constants;
+        std::vector<slot_type> m_outputs;
+        slot_type m_inputs = 0;
+        std::size_t m_guards = 0;
+    };
+
+    // A dual being recorded: its value at the recording point and its slot.
+    template<typename T>
+    class traced
+    {
+    public:
+
+        using base_real_type = T;
+        using slot_type = typename trace<T>::slot_type;
+
+    public:
+
+        auto
+        value() const noexcept
+            -> const dual<T>&
+        { return m_value; }
+
+        auto
+        re() const noexcept
+            -> const base_real_type&
+        { return m_value.re(); }
+
+        auto
+        d() const noexcept
+            -> const base_real_type&
+        { return m_value.d(); }
+
+        auto
+        slot() const noexcept
+            -> slot_type
+        { return m_slot; }
+
+        // the instruction op on a, and b when it has a second argument
+        static auto
+        apply(trace_op op, const dual<T>& value, const traced& a, std::uint32_t b = 0)
+            -> traced
+        { return traced{value, trace<T>::current().emit(op, a.m_slot, b)}; }
+
+        static auto
+        apply_c(trace_op op, const dual<T>& value, const traced& a, const base_real_type& c)
+            -> traced
+        {
+            trace<T>& t = trace<T>::current();
+            return traced{value, t.emit(op, a.m_slot, t.constant(c))};
+        }
+
+        ///{@  traced compound assignment
+        auto operator+= (const traced& v) -> traced& { return *this = *this + v; }
+        auto operator-= (const traced& v) -> traced& { return *this = *this - v; }
+        auto operator*= (const traced& v) -> traced& { return *this = *this * v; }
+        auto operator/= (const traced& v) -> traced& { return *this = *this / v; }
+        auto operator+= (const base_real_type& v) -> traced& { return *this = *this + v; }
+        auto operator-= (const base_real_type& v) -> traced& { return *this = *this - v; }
+        auto operator*= (const base_real_type& v) -> traced& { return *this = *this * v; }
+        auto operator/= (const base_real_type& v) -> traced& { return *this = *this / v; }
+        ///@}  traced compound assignment
+
+        ///{@  traced arithmetic
+        // defined as friends so that plain numbers convert to base_real_type
+        friend auto
+        operator+ (const traced& u)
+            -> traced
+        { return u; }
+
+        friend auto
+        operator- (const traced& u)
+            -> traced
+        { return apply(trace_op::neg, -u.m_value, u); }
+
+        friend auto
+        operator+ (const traced& u, const traced& v)
+            -> traced
+        { return apply(trace_op::add, u.m_value + v.m_value, u, v.m_slot); }
+
+        friend auto
+        operator- (const traced& u, const traced& v)
+            -> traced
+        { return apply(trace_op::sub, u.m_value - v.m_value, u, v.m_slot); }
+
+        friend auto
+        operator* (const traced& u, const traced& v)
+            -> traced
+        { return apply(trace_op::mul, u.m_value * v.m_value, u, v.m_slot); }
+
+        friend auto
+        operator/ (const traced& u, const traced& v)
+            -> traced
+        { return apply(trace_op::div, u.m_value / v.m_value, u, v.m_slot); }
+
+        friend auto
+        operator+ (const traced& u, const base_real_type& v)
+            -> traced
+        { return apply_c(trace_op::add_c, u.m_value + v, u, v); }
+
+        friend auto
+        operator+ (const base_real_type& u, const traced& v)
+            -> traced
+        { return apply_c(trace_op::add_c, v.m_value + u, v, u); }
+
+        friend auto
+        operator- (const traced& u, const base_real_type& v)
+            -> traced
+        { return apply_c(trace_op::sub_c, u.m_value - v, u, v); }
+
+        friend auto
+        operator- (const base_real_type& u, const traced& v)
+            -> traced
+        { return apply_c(trace_op::rsub_c, u - v.m_value, v, u); }
+
+        friend auto
+        operator* (const traced& u, const base_real_type& v)
+            -> traced
+        { return apply_c(trace_op::mul_c, u.m_value * v, u, v); }
+
+        friend auto
+        operator* (const base_real_type& u, const traced& v)
+            -> traced
+        { return apply_c(trace_op::mul_c, v.m_value * u, v, u); }
+
+        friend auto
+        operator/ (const traced& u, const base_real_type& v)
+            -> traced
+        { return apply_c(trace_op::div_c, u.m_value / v, u, v); }
+
+        friend auto
+        operator/ (const base_real_type& u, const traced& v)
+            -> traced
+        { return apply_c(trace_op::rdiv_c, u / v.m_value, v, u); }
+        ///@}  traced arithmetic
+
+        ///{@   traced comparison operators, each recorded as a guard
+        friend auto
+        operator< (const traced& u, const traced& v)
+            -> bool
+        { return guard(trace_op::guard_less, u, v, u.re() < v.re()); }
+
+        friend auto
+        operator> (const traced& u, const traced& v)
+            -> bool
+        { return guard(trace_op::guard_less, v, u, v.re() < u.re()); }
+
+        friend auto
+        operator<= (const traced& u, const traced& v)
+            -> bool
+        { return guard(trace_op::guard_less_equal, u, v, u.re() <= v.re()); }
+
+        friend auto
+        operator>= (const traced& u, const traced& v)
+            -> bool
+        { return guard(trace_op::guard_less_equal, v, u, v.re() <= u.re()); }
+
+        friend auto
+        operator== (const traced& u, const traced& v)
+            -> bool
+        { return guard(trace_op::guard_equal, u, v, u.re() == v.re()); }
+
+        friend auto
+        operator!= (const traced& u, const traced& v)
+            -> bool
+        { return !guard(trace_op::guard_equal, u, v, u.re() == v.re()); }
+
+        friend auto
+        operator< (const traced& u, const base_real_type& v)
+            -> bool
+        { return guard_c(trace_op::guard_less_c, u, v, u.re() < v); }
+
+        friend auto
+        operator< (const base_real_type& u, const traced& v)
+            -> bool
+        { return guard_c(trace_op::guard_greater_c, v, u, v.re() > u); }
+
+        friend auto
+        operator> (const traced& u, const base_real_type& v)
+            -> bool
+        { return guard_c(trace_op::guard_greater_c, u, v, u.re() > v); }
+
+        friend auto
+        operator> (const base_real_type& u, const traced& v)
+            -> bool
+        { return guard_c(trace_op::guard_less_c, v, u, v.re() < u); }
+
+        friend auto
+        operator<= (const traced& u, const base_real_type& v)
+            -> bool
+        { return guard_c(trace_op::guard_less_equal_c, u, v, u.re() <= v); }
+
+        friend auto
+        operator<= (const base_real_type& u, const traced& v)
+            -> bool
+        { return guard_c(trace_op::guard_greater_equal_c, v, u, v.re() >= u); }
+
+        friend auto
+        operator>= (const traced& u, const base_real_type& v)
+            -> bool
+        { return guard_c(trace_op::guard_greater_equal_c, u, v, u.re() >= v); }
+
+        friend auto
+        operator>= (const base_real_type& u, const traced& v)
+            -> bool
+        { return guard_c(trace_op::guard_less_equal_c, v, u, v.re() <= u); }
+
+        friend auto
+        operator== (const traced& u, const base_real_type& v)
+            -> bool
+        { return guard_c(trace_op::guard_equal_c, u, v, u.re() == v); }
+
+        friend auto
+        operator== (const base_real_type& u, const traced& v)
+            -> bool
+        { return guard_c(trace_op::guard_equal_c, v, u, v.re() == u); }
+
+        friend auto
+        operator!= (const traced& u, const base_real_type& v)
+            -> bool
+        { return !guard_c(trace_op::guard_equal_c, u, v, u.re() == v); }
+
+        friend auto
+        operator!= (const base_real_type& u, const traced& v)
+            -> bool
+        { return !guard_c(trace_op::guard_equal_c, v, u, v.re() == u); }
+        ///@}   traced comparison operators
+
+        ///{@   ostream
+        friend auto
+        operator<<(std::ostream& os, const traced& v)
+            -> std::ostream&
+        { return os << v.m_value << " @" << v.m_slot; }
+        ///@}   ostream
+
+    private:
+
+        friend class trace<T>;
+
+        traced(const dual<T>& value, slot_type slot) noexcept
+            : m_value{ value }
+            , m_slot{ slot }
+        { }
+
+        static auto
+        guard(trace_op op, const traced& a, const traced& b, bool outcome)
+            -> bool
+        {
+            trace<T>::current().emit(op, a.m_slot, b.m_slot, outcome);
+            return outcome;
+        }
+
+        static auto
+        guard_c(trace_op op, const traced& a, const base_real_type& c, bool outcome)
+            -> bool
+        {
+            trace<T>& t = trace<T>::current();
+            t.emit(op, a.m_slot, t.constant(c), outcome);
+            return outcome;
+        }
+
+        dual<T> m_value;
+        slot_type m_slot;
+    };
+
+    ///{@   elementary functions of traced duals
+    template<typename T>
+    auto sqrt(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::sqrt, dnn::sqrt(x.value()), x); }
+
+    template<typename T>
+    auto sin(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::sin, dnn::sin(x.value()), x); }
+
+    template<typename T>
+    auto cos(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::cos, dnn::cos(x.value()), x); }
+
+    template<typename T>
+    auto tan(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::tan, dnn::tan(x.value()), x); }
+
+    template<typename T>
+    auto exp(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::exp, dnn::exp(x.value()), x); }
+
+    template<typename T>
+    auto log(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::log, dnn::log(x.value()), x); }
+
+    template<typename T>
+    auto acos(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::acos, dnn::acos(x.value()), x); }
+
+    template<typename T>
+    auto asin(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::asin, dnn::asin(x.value()), x); }
+
+    template<typename T>
+    auto atan(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::atan, dnn::atan(x.value()), x); }
+
+    template<typename T>
+    auto sinh(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::sinh, dnn::sinh(x.value()), x); }
+
+    template<typename T>
+    auto cosh(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::cosh, dnn::cosh(x.value()), x); }
+
+    template<typename T>
+    auto tanh(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::tanh, dnn::tanh(x.value()), x); }
+
+    template<typename T>
+    auto log1p(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::log1p, dnn::log1p(x.value()), x); }
+
+    template<typename T>
+    auto expm1(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::expm1, dnn::expm1(x.value()), x); }
+
+    template<typename T>
+    auto cbrt(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::cbrt, dnn::cbrt(x.value()), x); }
+
+    // an instruction of its own rather than the generic abs, whose comparisons would become guards
+    template<typename T>
+    auto abs(const traced<T>& x) -> traced<T> { return traced<T>::apply(trace_op::abs, dnn::abs(x.value()), x); }
+
+    template<typename T>
+    auto
+    pow(const traced<T>& x, const traced<T>& n)
+        -> traced<T>
+    { return traced<T>::apply(trace_op::pow, dnn::pow(x.value(), n.value()), x, n.slot()); }
+
+    template<typename T>
+    auto
+    pow(const traced<T>& x, const std::type_identity_t<T>& n)
+        -> traced<T>
+    { return traced<T>::apply_c(trace_op::pow_c, dnn::pow(x.value(), n), x, n); }
+
+    template<typename T>
+    auto
+    pow(const std::type_identity_t<T>& x, const traced<T>& n)
+        -> traced<T>
+    { return traced<T>::apply_c(trace_op::rpow_c, dnn::pow(x, n.value()), n, x); }
+
+    template<typename T>
+    auto
+    hypot(const traced<T>& x, const traced<T>& y)
+        -> traced<T>
+    { return traced<T>::apply(trace_op::hypot, dnn::hypot(x.value(), y.value()), x, y.slot()); }
+
+    template<typename T>
+    auto
+    hypot(const traced<T>& x, const std::type_identity_t<T>& y)
+        -> traced<T>
+    { return traced<T>::apply_c(trace_op::hypot_c, dnn::hypot(x.value(), y), x, y); }
+
+    template<typename T>
+    auto
+    hypot(const std::type_identity_t<T>& x, const traced<T>& y)
+        -> traced<T>
+    { return traced<T>::apply_c(trace_op::hypot_c, dnn::hypot(y.value(), x), y, x); }
+
+    template<typename T>
+    auto
+    atan2(const traced<T>& y, const traced<T>& x)
+        -> traced<T>
+    { return traced<T>::apply(trace_op::atan2, dnn::atan2(y.value(), x.value()), y, x.slot()); }
+
+    template<typename T>
+    auto
+    atan2(const traced<T>& y, const std::type_identity_t<T>& x)
+        -> traced<T>
+    { return traced<T>::apply_c(trace_op::atan2_c, dnn::atan2(y.value(), x), y, x); }
+
+    template<typename T>
+    auto
+    atan2(const std::type_identity_t<T>& y, const traced<T>& x)
+        -> traced<T>
+    { return traced<T>::apply_c(trace_op::ratan2_c, dnn::atan2(y, x.value()), x, y); }
+    ///@}   elementary functions of traced duals
+
+    // f with its trace kept between calls and recorded again when a guard
+    // fails, so callers see a function from inputs and seeds to duals.
+    template<typename T, typename function_type>
+    class traced_function
+    {
+    public:
+
+        explicit
+        traced_function(function_type f)
+            : m_f{ std::move(f) }
+        { }
+
+        // the values and tangents of f at x along seed, into y
+        auto
+        operator()(std::span<const T> x, std::span<const T> seed, std::span<dual<T>> y)
+            -> void
+        {
+            if (!m_trace.empty() && m_trace.replay(x, seed, y))
+                return;
+            m_trace = trace<T>::record(m_f, x, seed);
+            ++m_records;
+            m_trace.replay(x, seed, y);
+        }
+
+        auto
+        current() const noexcept
+            -> const trace<T>&
+        { return m_trace; }
+
+        // times f has been recorded, the first time included
+        auto
+        records() const noexcept
+            -> std::size_t
+        { return m_records; }
+
+    private:
+
+        function_type m_f;
+        trace<T> m_trace;
+        std::size_t m_records = 0;
+    };
+
+}  /// namespace dnn
+
+#endif  /// DUAL_TRACE
@@ -0,0 +1,230 @@
+#ifndef DUAL_UNCERTAINTY
+#   define DUAL_UNCERTAINTY
+
+#include <dual_multi.hxx>
+#include <dual_sweep.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dnn
+{
+    // First order propagation of measurement uncertainty.
+    //
+    // For y = f(x) with inputs of covariance S, the linearised output covariance
+    // is J S J^T, J being the M x N Jacobian at the measured x. J comes from a
+    // single evaluation over mdual<T, N>, each input seeded with its own
+    // tangent, rather than one dual pass per uncertain input.
+    //
+    // S is factored once as L L^T, the factor being kept in input_covariance,
+    // so for every record B = J L is formed and J S J^T = B B^T is accumulated as
+    // N symmetric rank-1 updates of the lower triangle, which is then mirrored.
+    // The factorisation accepts semidefinite S, such as fully correlated or
+    // exactly known inputs: a pivot that is zero to rounding of its own
+    // variance zeroes its column, provided the rest of that column is zero to
+    // rounding too, as it is for any semidefinite S. Rounding is judged per
+    // entry, so inputs in units of very different size keep their variances.
+    //
+    // propagate_batch runs many records, e.g. the rows of a measurement log, on
+    // a sweep_pool, with one covariance for all of them or one per record.
+
+    template<typename T, std::size_t N>
+    class input_covariance
+    {
+    public:
+
+        using base_real_type = T;
+        using matrix_type = std::array<std::array<T, N>, N>;
+
+    public:
+
+        // exactly known inputs
+        input_covariance() noexcept
+            : m_factor{}
+        { }
+
+        // S, of which only the lower triangle is read
+        explicit
+        input_covariance(const matrix_type& s)
+            : m_factor{}
+        {
+            // rounding relative to each entry's own scale, so that inputs in
+            // units of very different size are not taken as exactly known
+            const T rounding = T{16} * static_cast<T>(N) * std::numeric_limits<T>::epsilon();
+
+            for (std::size_t j = 0; j < N; ++j)
+            {
+                const T tolerance = rounding * std::fabs(s[j][j]);
+                T pivot = s[j][j];
+                for (std::size_t k = 0; k < j; ++k)
+                    pivot -= m_factor[j][k] * m_factor[j][k];
+                if (pivot < -tolerance)
+                    throw std::invalid_argument("dnn: input covariance is not positive semidefinite");
+                if (pivot <= tolerance)
+                {
+                    for (std::size_t i = j + 1; i < N; ++i)
+                    {
+                        T v = s[i][j];
+                        for (std::size_t k = 0; k < j; ++k)
+                            v -= m_factor[i][k] * m_factor[j][k];
+                        if (std::fabs(v) > rounding * std::sqrt(std::fabs(s[i][i] * s[j][j])))
+                            throw std::invalid_argument("dnn: input covariance is not positive semidefinite");
+                    }
+                    continue;
+                }
+
+                const T l = std::sqrt(pivot);
+                m_factor[j][j] = l;
+                for (std::size_t i = j + 1; i < N; ++i)
+                {
+                    T v = s[i][j];
+                    for (std::size_t k = 0; k < j; ++k)
+                        v -= m_factor[i][k] * m_factor[j][k];
+                    m_factor[i][j] = v / l;
+                }
+            }
+        }
+
+        // independent inputs with standard deviations sigma
+        static auto
+        independent(const std::array<T, N>& sigma)
+            -> input_covariance
+        {
+            input_covariance c;
+            for (std::size_t i = 0; i < N; ++i)
+                c.m_factor[i][i] = std::fabs(sigma[i]);
+            return c;
+        }
+
+        // L, lower triangular with L L^T = S
+        auto
+        factor() const noexcept
+            -> const matrix_type&
+        { return m_factor; }
+
+    private:
+
+        matrix_type m_factor;
+    };
+
+    // The outputs at a record, their Jacobian with respect to the inputs and
+    // their propagated covariance.
+    template<typename T, std::size_t N, std::size_t M>
+    struct uncertainty_result
+    {
+        std::array<T, M> value{};
+        std::array<std::array<T, N>, M> jacobian{};
+        std::array<std::array<T, M>, M> covariance{};
+
+        // the standard deviation of output m
+        auto
+        sigma(std::size_t m = 0) const
+            -> T
+        { return std::sqrt(covariance[m][m]); }
+    };
+
+    namespace uncertainty_detail
+    {
+        template<typename T, std::size_t N, typename function_type>
+        using result_type = std::invoke_result_t<function_type&, const std::array<mdual<T, N>, N>&>;
+
+        template<typename T, std::size_t N, typename function_type>
+        inline constexpr std::size_t outputs_of = sweep_detail::outputs<result_type<T, N, function_type>>;
+
+        template<typename T, std::size_t N, typename function_type>
+        auto
+        propagate(function_type& f, const std::array<T, N>& x, const input_covariance<T, N>& s)
+            -> uncertainty_result<T, N, outputs_of<T, N, function_type>>
+        {
+            constexpr std::size_t M = outputs_of<T, N, function_type>;
+            using result_type = uncertainty_result<T, N, M>;
+
+            std::array<mdual<T, N>, N> v;
+            for (std::size_t k = 0; k < N; ++k)
+                v[k] = mdual<T, N>::variable(x[k], k);
+            const auto y = f(v);
+
+            result_type r;
+            auto store = [&](std::size_t m, const mdual<T, N>& u)
+            {
+                r.value[m] = u.re();
+                r.jacobian[m] = u.d();
+            };
+            if constexpr (M == 1 && !std::is_same_v<std::remove_cvref_t<decltype(y)>, std::array<mdual<T, N>, 1>>)
+                store(0, y);
+            else
+                for (std::size_t m = 0; m < M; ++m)
+                    store(m, y[m]);
+
+            // column k of B = J L, over the rows of L from k down
+            const auto& L = s.factor();
+            for (std::size_t k = 0; k < N; ++k)
+            {
+                std::array<T, M> b{};
+                for (std::size_t m = 0; m < M; ++m)
+                    for (std::size_t i = k; i < N; ++i)
+                        b[m] += r.jacobian[m][i] * L[i][k];
+                for (std::size_t a = 0; a < M; ++a)
+                    for (std::size_t c = 0; c <= a; ++c)
+                        r.covariance[a][c] += b[a] * b[c];
+            }
+            for (std::size_t a = 0; a < M; ++a)
+                for (std::size_t c = 0; c < a; ++c)
+                    r.covariance[c][a] = r.covariance[a][c];
+            return r;
+        }
+    }  /// namespace uncertainty_detail
+
+    // Propagates the covariance s of the inputs x through f, which takes
+    // std::array<mdual<T, N>, N> and returns mdual<T, N> or std::array<mdual<T, N>, M>.
+    template<typename T, std::size_t N, typename function_type>
+    auto
+    propagate(function_type f, const std::array<T, N>& x, const input_covariance<T, N>& s)
+        -> uncertainty_result<T, N, uncertainty_detail::outputs_of<T, N, function_type>>
+    { return uncertainty_detail::propagate(f, x, s); }
+
+    ///{@   batches of records
+    // out[i] is the propagation through f of record x[i] with covariance s,
+    // or s[i] when a covariance is given per record.
+    template<typename T, std::size_t N, typename function_type>
+    auto
+    propagate_batch(function_type f, std::span<const std::array<T, N>> x, const input_covariance<T, N>& s,
+                    std::span<uncertainty_result<T, N, uncertainty_detail::outputs_of<T, N, function_type>>> out,
+                    sweep_pool& pool = sweep_pool::shared())
+        -> void
+    {
+        if (out.size() != x.size())
+            throw std::invalid_argument("dnn: propagate_batch needs one result per record");
+        pool.run(x.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                out[i] = uncertainty_detail::propagate(f, x[i], s);
+        });
+    }
+
+    template<typename T, std::size_t N, typename function_type>
+    auto
+    propagate_batch(function_type f, std::span<const std::array<T, N>> x, std::span<const input_covariance<T, N>> s,
+                    std::span<uncertainty_result<T, N, uncertainty_detail::outputs_of<T, N, function_type>>> out,
+                    sweep_pool& pool = sweep_pool::shared())
+        -> void
+    {
+        if (out.size() != x.size() || s.size() != x.size())
+            throw std::invalid_argument("dnn: propagate_batch needs one covariance and one result per record");
+        pool.run(x.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                out[i] = uncertainty_detail::propagate(f, x[i], s[i]);
+        });
+    }
+    ///@}   batches of records
+
+}  /// namespace dnn
+
+#endif  /// DUAL_UNCERTAINTY
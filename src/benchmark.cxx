@@ -0,0 +1,1110 @@
+#include <dual_numbers.hxx>
+#include <dual_format.hxx>
+#include <dual_lazy.hxx>
+#include <dual_multi.hxx>
+#include <dual_sparse.hxx>
+#include <dual_dynamic.hxx>
+#include <dual_sweep.hxx>
+#include <dual_trace.hxx>
+#include <dual_codegen.hxx>
+#include <dual_reverse.hxx>
+#include <dual_hessian.hxx>
+#include <dual_fft.hxx>
+#include <dual_uncertainty.hxx>
+#include <dual_montecarlo.hxx>
+
+#include <bit>
+#include <chrono>
+#include <complex>
+#include <memory>
+#include <numbers>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace dnn;
+
+// A model assembled at run time from virtual nodes, the kind of user code a
+// trace flattens. Each node evaluates over duals, or over traced duals while
+// being recorded.
+struct model_node
+{
+    virtual ~model_node() = default;
+    virtual auto eval(const std::vector<dual<double>>& x) const -> dual<double> = 0;
+    virtual auto eval(const std::vector<traced<double>>& x) const -> traced<double> = 0;
+};
+
+template<typename derived_type>
+struct model_node_of : model_node
+{
+    auto eval(const std::vector<dual<double>>& x) const -> dual<double> override
+    { return static_cast<const derived_type&>(*this).value(x); }
+
+    auto eval(const std::vector<traced<double>>& x) const -> traced<double> override
+    { return static_cast<const derived_type&>(*this).value(x); }
+};
+
+struct model_input : model_node_of<model_input>
+{
+    std::size_t i;
+    explicit model_input(std::size_t i) : i{i} { }
+    template<typename X> auto value(const std::vector<X>& x) const -> X { return x[i]; }
+};
+
+struct model_step : model_node_of<model_step>
+{
+    std::unique_ptr<model_node> a, b;
+    int kind;
+    model_step(std::unique_ptr<model_node> a, std::unique_ptr<model_node> b, int kind) : a{std::move(a)}, b{std::move(b)}, kind{kind} { }
+
+    template<typename X>
+    auto value(const std::vector<X>& x) const -> X
+    {
+        const X u = a->eval(x), v = b->eval(x);
+        switch (kind)
+        {
+            case 0:  return u + v;
+            case 1:  return u * v * 0.5;
+            case 2:  return dnn::sin(u) + v;
+            default: return u < v ? dnn::exp(u * 0.1) : v - u * 0.25;
+        }
+    }
+};
+
+// A runtime-width dual with its tangents in a std::vector, the usual way to
+// write one, as the baseline for ddual. Only what the benchmark uses.
+struct vector_dual
+{
+    double value;
+    std::vector<double> d;
+
+    auto re() const noexcept -> double { return value; }
+
+    friend auto
+    operator+ (const vector_dual& u, const vector_dual& v)
+        -> vector_dual
+    {
+        vector_dual r{u.value + v.value, std::vector<double>(u.d.size())};
+        for (std::size_t i = 0; i < r.d.size(); ++i)
+            r.d[i] = u.d[i] + v.d[i];
+        return r;
+    }
+
+    friend auto
+    operator* (const vector_dual& u, const vector_dual& v)
+        -> vector_dual
+    {
+        vector_dual r{u.value * v.value, std::vector<double>(u.d.size())};
+        for (std::size_t i = 0; i < r.d.size(); ++i)
+            r.d[i] = v.value * u.d[i] + u.value * v.d[i];
+        return r;
+    }
+
+    friend auto
+    operator* (const vector_dual& u, double v)
+        -> vector_dual
+    {
+        vector_dual r{u.value * v, std::vector<double>(u.d.size())};
+        for (std::size_t i = 0; i < r.d.size(); ++i)
+            r.d[i] = v * u.d[i];
+        return r;
+    }
+
+    friend auto
+    sin(const vector_dual& u)
+        -> vector_dual
+    {
+        const double c = std::cos(u.value);
+        vector_dual r{std::sin(u.value), std::vector<double>(u.d.size())};
+        for (std::size_t i = 0; i < r.d.size(); ++i)
+            r.d[i] = c * u.d[i];
+        return r;
+    }
+};
+
+// Times f over every input, repeated until about 0.1 s has passed,
+// and returns nanoseconds per call. The results are summed into a
+// volatile so the calls cannot be optimised away.
+template<typename function_type>
+auto bench(const std::vector<dual<double>>& xs, function_type f) -> double
+{
+    using clock = std::chrono::steady_clock;
+
+    volatile double sink = 0;
+    std::size_t calls = 0;
+    auto start = clock::now();
+    auto elapsed = std::chrono::duration<double, std::nano>{};
+    do
+    {
+        double acc = 0;
+        for (const auto& x : xs)
+        {
+            auto y = f(x);
+            acc += y.re() + y.d();
+        }
+        sink = sink + acc;
+        calls += xs.size();
+        elapsed = clock::now() - start;
+    } while (elapsed.count() < 1e8);
+
+    return elapsed.count() / calls;
+}
+
+auto report(const char* name, double native, double composed) -> void
+{
+    std::printf("%-8s native %7.2f ns   composed %7.2f ns   speedup %5.2fx\n", name, native, composed, composed / native);
+}
+
+auto main() -> int
+{
+    {   // hyperbolic and related functions, native against composed from exp/log/pow
+        std::cout << "--hyperbolic and related functions--" << std::endl;
+        std::vector<dual<double>> xs(4096);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            xs[i] = dual<double>{-2 + 4.0 * i / xs.size(), 1};
+
+        report("sinh",
+            bench(xs, [](dual<double> x) { return dnn::sinh(x); }),
+            bench(xs, [](dual<double> x) { return (dnn::exp(x) - dnn::exp(0.0 - x)) * 0.5; }));
+        report("cosh",
+            bench(xs, [](dual<double> x) { return dnn::cosh(x); }),
+            bench(xs, [](dual<double> x) { return (dnn::exp(x) + dnn::exp(0.0 - x)) * 0.5; }));
+        report("tanh",
+            bench(xs, [](dual<double> x) { return dnn::tanh(x); }),
+            bench(xs, [](dual<double> x) { auto e = dnn::exp(x * 2.0); return (e - 1.0) / (e + 1.0); }));
+        report("atan2",
+            bench(xs, [](dual<double> x) { return dnn::atan2(x, dual<double>{0.5, 0.25}); }),
+            bench(xs, [](dual<double> x) { auto y = dual<double>{0.5, 0.25}; auto r = dnn::hypot(x, y); return 2.0 * dnn::atan(x / (r + y)); }));
+        report("log1p",
+            bench(xs, [](dual<double> x) { return dnn::log1p(x * 0.25); }),
+            bench(xs, [](dual<double> x) { return dnn::log(x * 0.25 + 1.0); }));
+        report("expm1",
+            bench(xs, [](dual<double> x) { return dnn::expm1(x); }),
+            bench(xs, [](dual<double> x) { return dnn::exp(x) - 1.0; }));
+        report("cbrt",
+            bench(xs, [](dual<double> x) { return dnn::cbrt(x + 3.0); }),
+            bench(xs, [](dual<double> x) { return dnn::pow(x + 3.0, 1.0 / 3); }));
+        std::cout << "--hyperbolic and related functions--" << std::endl;
+    }   // hyperbolic and related functions
+
+    {   // text formatting, to_chars against operator<<
+        std::cout << "--text formatting--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        std::vector<dual<double>> xs(1 << 16);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            xs[i] = dual<double>{std::sin(1.0 * i), std::cos(1.0 * i) / (i + 1)};
+
+        // ostream needs 17 digits to round trip like to_chars does
+        auto start = clock::now();
+        std::ostringstream os;
+        os.precision(17);
+        for (const auto& x : xs)
+            os << x << '\n';
+        const std::string text = os.str();
+        const double stream_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / xs.size();
+
+        std::vector<char> buffer(xs.size() * 64);
+        start = clock::now();
+        auto r = dnn::to_chars(buffer.data(), buffer.data() + buffer.size(), std::span<const dual<double>>(xs));
+        const double chars_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / xs.size();
+
+        std::vector<dual<double>> ys(xs.size());
+        start = clock::now();
+        auto p = dnn::from_chars(buffer.data(), r.ptr, std::span<dual<double>>(ys));
+        const double parse_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / xs.size();
+
+        std::size_t exact = 0;
+        for (std::size_t i = 0; i < p.count; ++i)
+            exact += dnn::equiv(ys[i], xs[i]);
+
+        std::printf("format   ostream %7.2f ns   to_chars %7.2f ns   speedup %5.2fx\n", stream_ns, chars_ns, stream_ns / chars_ns);
+        std::printf("parse    from_chars %7.2f ns   (%zu of %zu read back exactly)\n", parse_ns, exact, xs.size());
+        std::cout << "--text formatting--" << std::endl;
+    }   // text formatting
+
+    {   // lazy tangents, the spiral of spiral.cxx with every point's value and the tangents of some
+        std::cout << "--lazy tangents--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        const int n = 1000;
+
+        // ns per point of the whole sweep, reading the tangent of every stride-th point
+        auto sweep = [&](auto make, int stride)
+        {
+            volatile double sink = 0;
+            std::size_t points = 0;
+            auto start = clock::now();
+            auto elapsed = std::chrono::duration<double, std::nano>{};
+            do
+            {
+                lazy_scope<double> scope;
+                double acc = 0;
+                for (int i = 0; i < n; ++i)
+                {
+                    auto t = make(1.0 * i / n);
+                    auto x = dnn::cos(t * (2 * M_PI)) * t;
+                    auto y = dnn::sin(t * (2 * M_PI)) * t;
+                    acc += x.re() + y.re();
+                    if (i % stride == 0)
+                        acc += x.d() + y.d();
+                }
+                sink = sink + acc;
+                points += n;
+                elapsed = clock::now() - start;
+            } while (elapsed.count() < 1e8);
+            return elapsed.count() / points;
+        };
+
+        // the same with partials that cost as much as the values, x^t and t^x need a log each
+        auto sweep_pow = [&](auto make, int stride)
+        {
+            volatile double sink = 0;
+            std::size_t points = 0;
+            auto start = clock::now();
+            auto elapsed = std::chrono::duration<double, std::nano>{};
+            do
+            {
+                lazy_scope<double> scope;
+                double acc = 0;
+                for (int i = 0; i < n; ++i)
+                {
+                    auto t = make(1.0 + 1.0 * i / n);
+                    auto x = dnn::pow(t, t * 0.5) + dnn::atan2(t, 2.0);
+                    auto y = dnn::pow(t * 0.5, t) - dnn::cbrt(t);
+                    acc += x.re() + y.re();
+                    if (i % stride == 0)
+                        acc += x.d() + y.d();
+                }
+                sink = sink + acc;
+                points += n;
+                elapsed = clock::now() - start;
+            } while (elapsed.count() < 1e8);
+            return elapsed.count() / points;
+        };
+
+        auto eager = [](double t) { return dual<double>{t, 1}; };
+        auto lazy  = [](double t) { return lazy_dual<double>{t, 1}; };
+        std::printf("spiral\n");
+        for (int stride : {1, 10, 50, n})
+            std::printf("tangents of %4d in %d   dual %6.2f ns   lazy %6.2f ns per point\n",
+                        n / stride, n, sweep(eager, stride), sweep(lazy, stride));
+        std::printf("powers\n");
+        for (int stride : {1, 10, 50, n})
+            std::printf("tangents of %4d in %d   dual %6.2f ns   lazy %6.2f ns per point\n",
+                        n / stride, n, sweep_pow(eager, stride), sweep_pow(lazy, stride));
+        std::cout << "--lazy tangents--" << std::endl;
+    }   // lazy tangents
+
+    {   // sparse tangents against dense ones, 1024 inputs of which each output depends on k
+        std::cout << "--sparse tangents--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t n = 1024;
+        constexpr std::size_t outputs = 64;
+
+        std::vector<mdual<double, n>> dense;
+        std::vector<sparse_dual<double>> sparse;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dense.push_back(mdual<double, n>::variable(1.0 + 1.0 * i / n, i));
+            sparse.push_back(sparse_dual<double>::variable(1.0 + 1.0 * i / n, static_cast<std::uint32_t>(i)));
+        }
+
+        auto model = [](const auto& x, const std::vector<std::size_t>& idx)
+        {
+            auto acc = x[idx[0]];
+            for (std::size_t m = 1; m < idx.size(); ++m)
+                acc = acc * 0.5 + dnn::sin(x[idx[m]]) * x[idx[m]];
+            return acc;
+        };
+
+        // ns per output
+        auto run = [&](const auto& x, const std::vector<std::vector<std::size_t>>& deps)
+        {
+            volatile double sink = 0;
+            std::size_t evaluations = 0;
+            auto start = clock::now();
+            auto elapsed = std::chrono::duration<double, std::nano>{};
+            do
+            {
+                for (const auto& idx : deps)
+                {
+                    const auto y = model(x, idx);
+                    sink = sink + y.re();
+                }
+                evaluations += deps.size();
+                elapsed = clock::now() - start;
+            } while (elapsed.count() < 1e8);
+            return elapsed.count() / evaluations;
+        };
+
+        std::mt19937_64 rng{3};
+        for (std::size_t k : {2, 8, 32, 128, 512})
+        {
+            std::vector<std::vector<std::size_t>> deps(outputs);
+            for (auto& idx : deps)
+            {
+                std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+                for (std::size_t m = 0; m < k; ++m)
+                    idx.push_back(pick(rng));
+            }
+            const double dense_ns = run(dense, deps);
+            const double sparse_ns = run(sparse, deps);
+            std::printf("k %4zu of %zu   dense %10.1f ns   sparse %10.1f ns   speedup %6.2fx   pool chunks %zu\n",
+                        k, n, dense_ns, sparse_ns, dense_ns / sparse_ns, sparse_pool<double>::local().chunks());
+        }
+        std::cout << "--sparse tangents--" << std::endl;
+    }   // sparse tangents
+
+    {   // runtime-width tangents in a scoped arena against std::vector tangents
+        std::cout << "--runtime-width tangents--" << std::endl;
+        using clock = std::chrono::steady_clock;
+
+        auto model = [](const auto& x)
+        {
+            auto acc = x[0];
+            for (std::size_t m = 1; m < x.size(); ++m)
+                acc = acc * 0.5 + sin(x[m]) * x[m];
+            return acc;
+        };
+
+        // ns per evaluation; scoped evaluates inside an arena_scope
+        auto run = [&](const auto& x, bool scoped)
+        {
+            volatile double sink = 0;
+            std::size_t evaluations = 0;
+            auto start = clock::now();
+            auto elapsed = std::chrono::duration<double, std::nano>{};
+            do
+            {
+                if (scoped)
+                {
+                    arena_scope scope;
+                    sink = sink + model(x).re();
+                }
+                else
+                    sink = sink + model(x).re();
+                ++evaluations;
+                elapsed = clock::now() - start;
+            } while (elapsed.count() < 1e8);
+            return elapsed.count() / evaluations;
+        };
+
+        for (std::size_t n : {4, 16, 64, 256, 1024})
+        {
+            arena_scope scope;
+            std::vector<vector_dual> heap;
+            std::vector<ddual<double>> arena;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                heap.push_back({1.0 + 1.0 * i / n, std::vector<double>(n)});
+                heap.back().d[i] = 1;
+                arena.push_back(ddual<double>::variable(1.0 + 1.0 * i / n, i, n));
+            }
+            const double heap_ns = run(heap, false) / n;
+            const double arena_ns = run(arena, true) / n;
+            std::printf("width %5zu   vector %8.2f ns   arena %8.2f ns per input   speedup %5.2fx   arena blocks %zu\n",
+                        n, heap_ns, arena_ns, heap_ns / arena_ns, dual_arena::local().blocks());
+        }
+        std::cout << "--runtime-width tangents--" << std::endl;
+    }   // runtime-width tangents
+
+    {   // a parameter sweep with uneven cost per point, static partitioning against work stealing
+        std::cout << "--parameter sweep--" << std::endl;
+        using clock = std::chrono::steady_clock;
+
+        // a series whose length grows with the first parameter, so the cost
+        // per point ranges over two orders of magnitude along the grid
+        auto model = [](const auto& x)
+        {
+            const int terms = 4 + static_cast<int>(x[0].re() * x[0].re() * 400);
+            auto acc = x[1] * 0.0;
+            for (int k = 1; k <= terms; ++k)
+                acc = acc + sin(x[0] * static_cast<double>(k)) * x[1] / static_cast<double>(k);
+            return acc;
+        };
+
+        const sweep_grid<double, 2> g{{{{0.0, 1.0, 256}, {0.5, 1.5, 64}}}};
+        const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        sweep_output<double, 2> out(g.points());
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 5; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        // equal contiguous blocks of the grid, one per thread
+        const double static_ms = time([&]
+        {
+            std::vector<std::thread> pool;
+            for (std::size_t t = 0; t < threads; ++t)
+                pool.emplace_back([&, t]
+                {
+                    for (std::size_t i = g.points() * t / threads; i < g.points() * (t + 1) / threads; ++i)
+                    {
+                        const auto p = g.point(i);
+                        const auto y = model(std::array{mdual<double, 2>::variable(p[0], 0), mdual<double, 2>::variable(p[1], 1)});
+                        out.re[i] = y.re();
+                        out.d[0][i] = y.d(0);
+                        out.d[1][i] = y.d(1);
+                    }
+                });
+            for (auto& t : pool)
+                t.join();
+        });
+
+        sweep_pool& pool = sweep_pool::shared();
+        const double stealing_ms = time([&] { sweep(g, model, out, pool); });
+        std::printf("%zu points on %zu threads   static %8.2f ms   work stealing %8.2f ms   speedup %5.2fx   chunks %zu   steals %zu\n",
+                    g.points(), threads, static_ms, stealing_ms, static_ms / stealing_ms, pool.last_run().chunks, pool.last_run().steals);
+        std::cout << "--parameter sweep--" << std::endl;
+    }   // parameter sweep
+
+    {   // a model of virtual nodes, evaluated directly and replayed from its trace
+        std::cout << "--trace replay--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t inputs = 8;
+
+        std::mt19937_64 rng{5};
+        std::vector<std::vector<double>> points(1024, std::vector<double>(inputs));
+        std::uniform_real_distribution<double> u(0.5, 1.5);
+        for (auto& p : points)
+            for (auto& v : p)
+                v = u(rng);
+        std::vector<double> seed(inputs, 0.0);
+        seed[0] = 1;
+
+        auto run = [&](auto evaluate)
+        {
+            volatile double sink = 0;
+            std::size_t evaluations = 0;
+            auto start = clock::now();
+            auto elapsed = std::chrono::duration<double, std::nano>{};
+            do
+            {
+                for (const auto& p : points)
+                    sink = sink + evaluate(p);
+                evaluations += points.size();
+                elapsed = clock::now() - start;
+            } while (elapsed.count() < 1e8);
+            return elapsed.count() / evaluations;
+        };
+
+        // arithmetic only, then with sin and exp, whose cost hides the
+        // dispatch either way, then with branches, where most points take a
+        // path of their own and are recorded again
+        for (int kinds : {2, 3, 4})
+        {
+            std::function<std::unique_ptr<model_node>(int)> grow = [&](int depth) -> std::unique_ptr<model_node>
+            {
+                if (depth <= 0)
+                    return std::make_unique<model_input>(rng() % inputs);
+                return std::make_unique<model_step>(grow(depth - 1), grow(depth - 1 - static_cast<int>(rng() % 2)), static_cast<int>(rng() % kinds));
+            };
+            const auto root = grow(9);
+
+            std::vector<dual<double>> x(inputs);
+            const double direct_ns = run([&](const std::vector<double>& p)
+            {
+                for (std::size_t i = 0; i < inputs; ++i)
+                    x[i] = dual<double>{p[i], seed[i]};
+                return root->eval(x).d();
+            });
+
+            auto f = [&](const std::vector<traced<double>>& v) { return root->eval(v); };
+            traced_function<double, decltype(f)> g{f};
+            std::array<dual<double>, 1> y;
+            const double replay_ns = run([&](const std::vector<double>& p)
+            {
+                g(p, seed, y);
+                return y[0].d();
+            });
+            std::printf("%s %4zu instructions, %3zu guards   virtual %8.1f ns   replay %8.1f ns   speedup %5.2fx   records %zu\n",
+                        kinds == 2 ? "arith   " : kinds == 3 ? "straight" : "branchy ", g.current().instructions().size(), g.current().guards(),
+                        direct_ns, replay_ns, direct_ns / replay_ns, g.records());
+        }
+        std::cout << "--trace replay--" << std::endl;
+    }   // trace replay
+
+    {   // generated code
+        std::cout << "--generated code--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t inputs = 8, points = 1024;
+
+        std::mt19937_64 rng{7};
+        std::vector<double> xs(points * inputs), seeds(points * inputs, 0.0);
+        std::uniform_real_distribution<double> u(0.5, 1.5);
+        for (auto& v : xs)
+            v = u(rng);
+        for (std::size_t i = 0; i < points; ++i)
+            seeds[i * inputs] = 1;
+
+        auto run = [&](auto evaluate)
+        {
+            volatile double sink = 0;
+            std::size_t evaluations = 0;
+            auto start = clock::now();
+            auto elapsed = std::chrono::duration<double, std::nano>{};
+            do
+            {
+                sink = sink + evaluate();
+                evaluations += points;
+                elapsed = clock::now() - start;
+            } while (elapsed.count() < 1e8);
+            return elapsed.count() / evaluations;
+        };
+
+        // the straight model of the replay benchmark, arithmetic and then with sin and exp
+        for (int kinds : {2, 3})
+        {
+            std::function<std::unique_ptr<model_node>(int)> grow = [&](int depth) -> std::unique_ptr<model_node>
+            {
+                if (depth <= 0)
+                    return std::make_unique<model_input>(rng() % inputs);
+                return std::make_unique<model_step>(grow(depth - 1), grow(depth - 1 - static_cast<int>(rng() % 2)), static_cast<int>(rng() % kinds));
+            };
+            const auto root = grow(9);
+            auto f = [&](const std::vector<traced<double>>& v) { return root->eval(v); };
+            const auto t = trace<double>::record(f, std::span<const double>{xs.data(), inputs}, std::span<const double>{seeds.data(), inputs});
+
+            // compiled on the first run, found in the cache on later ones
+            const auto start = clock::now();
+            const compiled_trace<double> k{t};
+            const double compile_ms = std::chrono::duration<double, std::milli>{clock::now() - start}.count();
+            std::size_t lines = 0;
+            for (const char c : k.source())
+                lines += c == '\n';
+
+            std::array<dual<double>, 1> y;
+            const double replay_ns = run([&]
+            {
+                double s = 0;
+                for (std::size_t i = 0; i < points; ++i)
+                {
+                    t.replay(std::span<const double>{xs.data() + i * inputs, inputs}, std::span<const double>{seeds.data() + i * inputs, inputs}, y);
+                    s += y[0].d();
+                }
+                return s;
+            });
+            const double kernel_ns = run([&]
+            {
+                double s = 0;
+                for (std::size_t i = 0; i < points; ++i)
+                {
+                    k(std::span<const double>{xs.data() + i * inputs, inputs}, std::span<const double>{seeds.data() + i * inputs, inputs}, y);
+                    s += y[0].d();
+                }
+                return s;
+            });
+            std::vector<double> re(points), d(points);
+            const double batch_ns = run([&]
+            {
+                k.batch(points, xs.data(), seeds.data(), re.data(), d.data());
+                return d[points - 1];
+            });
+            std::printf("%s %4zu instructions -> %4zu lines, loaded in %6.0f ms   replay %7.1f ns   kernel %7.1f ns   batch %7.1f ns   speedup %5.2fx\n",
+                        kinds == 2 ? "arith   " : "straight", t.instructions().size(), lines, compile_ms, replay_ns, kernel_ns, batch_ns, replay_ns / batch_ns);
+        }
+        std::cout << "--generated code--" << std::endl;
+    }   // generated code
+
+    {   // checkpointed reverse mode
+        std::cout << "--checkpointed reverse mode--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t steps = 100000, width = 17;
+
+        // a damped chain of pendulums, its coupling carried in the last entry
+        auto step = [](const auto& x, std::size_t)
+        {
+            constexpr double h = 1e-3;
+            auto y = x;
+            for (std::size_t k = 0; k + 1 < width; k += 2)
+            {
+                const auto left = k >= 2 ? x[k - 2] : x[k];
+                const auto right = k + 2 < width - 1 ? x[k + 2] : x[k];
+                y[k] = x[k] + h * x[k + 1];
+                y[k + 1] = x[k + 1] - h * (sin(x[k]) + x[width - 1] * (2.0 * x[k] - left - right) + 0.1 * x[k + 1]);
+            }
+            return y;
+        };
+        auto objective = [](const auto& x)
+        {
+            auto j = x[0] * x[0];
+            for (std::size_t k = 2; k + 1 < width; k += 2)
+                j += x[k] * x[k];
+            return j;
+        };
+        std::vector<double> start(width, 0.0);
+        for (std::size_t k = 0; k + 1 < width; k += 2)
+            start[k] = 0.1 * static_cast<double>(k + 1);
+        start[width - 1] = 2.0;
+
+        // the whole loop on one tape
+        auto start_time = clock::now();
+        double plain_gradient = 0;
+        std::size_t plain_bytes = 0;
+        {
+            tape<double> t;
+            typename tape<double>::recording active{t};
+            std::vector<taped<double>> x0;
+            for (const double v : start)
+                x0.push_back(t.variable(v));
+            auto x = x0;
+            for (std::size_t i = 0; i < steps; ++i)
+                x = step(x, i);
+            t.seed(objective(x));
+            t.reverse();
+            plain_gradient = t.adjoint(x0[width - 1]);
+            plain_bytes = t.bytes() + width * sizeof(double);
+        }
+        const double plain_ms = std::chrono::duration<double, std::milli>{clock::now() - start_time}.count();
+        std::printf("one tape           %8.1f ms   peak %10.1f KiB   recompute 1.00   dJ/dk %.12g\n",
+                    plain_ms, static_cast<double>(plain_bytes) / 1024, plain_gradient);
+
+        for (const std::size_t k : {std::size_t{1000}, std::size_t{100}, std::size_t{20}, std::size_t{5}})
+        {
+            start_time = clock::now();
+            const auto r = checkpointed_gradient<double>(step, objective, start, steps, k);
+            const double ms = std::chrono::duration<double, std::milli>{clock::now() - start_time}.count();
+            std::printf("%5zu checkpoints  %8.1f ms   peak %10.1f KiB   recompute %4.2f   dJ/dk %.12g\n",
+                        k, ms, static_cast<double>(r.statistics.peak_bytes) / 1024, r.statistics.recompute_factor(), r.gradient[width - 1]);
+        }
+        std::cout << "--checkpointed reverse mode--" << std::endl;
+    }   // checkpointed reverse mode
+
+    {   // parallel reverse mode
+        std::cout << "--parallel reverse mode--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t shards = 2000, records = 64, width = 8;
+
+        // a sum of exponentials fitted to shards of records
+        auto residuals = [](const auto& p, std::size_t s)
+        {
+            auto sum = p[0] * 0.0;
+            for (std::size_t r = 0; r < records; ++r)
+            {
+                const double x = static_cast<double>(s * records + r) / (shards * records);
+                auto model = p[0] * 0.0;
+                for (std::size_t k = 0; k + 1 < width; k += 2)
+                    model += p[k] * exp(p[k + 1] * x);
+                const auto e = model - std::cos(3.0 * x);
+                sum += e * e;
+            }
+            return sum;
+        };
+        std::vector<double> p0(width);
+        for (std::size_t k = 0; k < width; ++k)
+            p0[k] = k % 2 ? -0.1 * static_cast<double>(k) : 0.5;
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 5; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        volatile double sink = 0;
+        const double serial_ms = time([&]
+        {
+            sink = gradient<double>([&](const std::vector<taped<double>>& p)
+            {
+                taped<double> sum = 0.0;
+                for (std::size_t s = 0; s < shards; ++s)
+                    sum += residuals(p, s);
+                return sum;
+            }, std::span<const double>{p0}).gradient[0];
+        });
+        std::printf("one tape            %8.2f ms\n", serial_ms);
+        for (std::size_t threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()); threads *= 2)
+        {
+            sweep_pool pool{threads};
+            const double ms = time([&] { sink = parallel_gradient<double>(residuals, std::span<const double>{p0}, shards, pool).gradient[0]; });
+            std::printf("%3zu threads         %8.2f ms   speedup %5.2fx\n", threads, ms, serial_ms / ms);
+        }
+        std::cout << "--parallel reverse mode--" << std::endl;
+    }   // parallel reverse mode
+
+    {   // preaccumulation
+        std::cout << "--preaccumulation--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t points = 100000;
+
+        // a spiral with a few harmonics, two inputs and a few dozen intermediates
+        auto point = [](const auto& v)
+        {
+            const auto t = v[0], w = v[1];
+            auto x = cos(t * w) * t, y = sin(t * w) * t;
+            for (int k = 2; k <= 5; ++k)
+            {
+                const auto a = t * (w * static_cast<double>(k));
+                const auto r = t / static_cast<double>(k * k);
+                x += cos(a) * r;
+                y += sin(a) * r;
+            }
+            return std::array{x, y};
+        };
+
+        for (const bool preaccumulated : {false, true})
+        {
+            tape<double> t;
+            double best = 1e300, gradient = 0;
+            for (int round = 0; round < 5; ++round)
+            {
+                const auto start = clock::now();
+                t.clear();
+                typename tape<double>::recording active{t};
+                const taped<double> w = t.variable(3.0);
+                taped<double> sum = 0.0;
+                for (std::size_t i = 0; i < points; ++i)
+                {
+                    const std::array<taped<double>, 2> v{taped<double>{static_cast<double>(i) / points}, w};
+                    const auto q = preaccumulated ? preaccumulate(point, v) : point(v);
+                    sum += q[0] * q[1];
+                }
+                t.seed(sum);
+                t.reverse();
+                gradient = t.adjoint(w);
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            std::printf("%-15s %9zu statements %10.1f KiB   record and reverse %8.2f ms   dy/dw %.12g\n",
+                        preaccumulated ? "preaccumulated" : "every operation", t.size(), static_cast<double>(t.bytes()) / 1024, best, gradient);
+        }
+        std::cout << "--preaccumulation--" << std::endl;
+    }   // preaccumulation
+
+    {   // hessian-vector products
+        std::cout << "--hessian-vector products--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t n = 10000;
+
+        // the extended Rosenbrock function with a smooth perturbation
+        auto f = [](const auto& x)
+        {
+            auto s = x[0] * 0.0;
+            for (std::size_t i = 0; i + 1 < n; ++i)
+            {
+                const auto a = x[i + 1] - x[i] * x[i], b = 1.0 - x[i];
+                s += 100.0 * a * a + b * b + 0.1 * sin(x[i] * x[i + 1]);
+            }
+            return s;
+        };
+        std::vector<double> x(n), v(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            x[i] = std::cos(0.37 * static_cast<double>(i));
+            v[i] = std::sin(0.11 * static_cast<double>(i));
+        }
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 5; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        volatile double sink = 0;
+        const double plain_ms = time([&] { sink = f(x); });
+        const double gradient_ms = time([&] { sink = gradient<double>(f, std::span<const double>{x}).gradient[0]; });
+        const double one_ms = time([&] { sink = hvp<double>(f, std::span<const double>{x}, std::span<const double>{v}).hv[0][0]; });
+        const double four_ms = time([&]
+        {
+            const std::span<const double> d{v};
+            sink = hvp<double, 4>(f, std::span<const double>{x}, std::array{d, d, d, d}).hv[3][0];
+        });
+        std::printf("n = %zu   f %8.3f ms   gradient %8.3f ms (%5.1fx)   H v %8.3f ms (%5.1fx)   4 H v %8.3f ms (%5.1fx)\n",
+                    n, plain_ms, gradient_ms, gradient_ms / plain_ms, one_ms, one_ms / plain_ms, four_ms, four_ms / plain_ms);
+        std::cout << "--hessian-vector products--" << std::endl;
+    }   // hessian-vector products
+
+    {   // complex base types
+        std::cout << "--complex base types--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        using cd = std::complex<double>;
+        constexpr std::size_t points = 1000000;
+        constexpr double R = 50.0, L = 1e-3, C = 1e-6;
+
+        // dH/dR of a series RLC, H = 1 / (1 - w^2 L C + i w R C), over a frequency sweep
+        std::vector<double> w(points);
+        for (std::size_t i = 0; i < points; ++i)
+            w[i] = 10.0 * std::pow(1e5, static_cast<double>(i) / points);
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 5; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        cd complex_sum{}, real_sum{};
+        const double complex_ms = time([&]
+        {
+            const dual<cd> r{cd{R}, cd{1.0}};
+            cd s{};
+            for (const double x : w)
+                s += (1.0 / (cd{1.0 - x * x * L * C} + cd{0.0, x * C} * r)).d();
+            complex_sum = s;
+        });
+        // the same from real and imaginary parts, each its own real dual pass
+        const double real_ms = time([&]
+        {
+            const dual<double> r{R, 1.0};
+            double re = 0, im = 0;
+            for (const double x : w)
+            {
+                const double a = 1.0 - x * x * L * C;
+                const auto b = x * C * r;
+                re += (a / (a * a + b * b)).d();
+            }
+            for (const double x : w)
+            {
+                const double a = 1.0 - x * x * L * C;
+                const auto b = x * C * r;
+                im += (-b / (a * a + b * b)).d();
+            }
+            real_sum = cd{re, im};
+        });
+        std::printf("%zu frequencies   complex dual %8.2f ms   two real passes %8.2f ms   sum dH/dR %.9g%+.9gi (real passes %.9g%+.9gi)\n",
+                    points, complex_ms, real_ms, complex_sum.real(), complex_sum.imag(), real_sum.real(), real_sum.imag());
+        std::cout << "--complex base types--" << std::endl;
+    }   // complex base types
+
+    {   // dual fft
+        std::cout << "--dual fft--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        using cd = std::complex<double>;
+
+        // a textbook radix-2 transform through the dual<std::complex> operators
+        auto generic = [](std::vector<dual<cd>>& a)
+        {
+            const std::size_t n = a.size();
+            for (std::size_t i = 1, j = 0; i < n; ++i)
+            {
+                std::size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1)
+                    j ^= bit;
+                j ^= bit;
+                if (i < j)
+                    std::swap(a[i], a[j]);
+            }
+            for (std::size_t len = 2; len <= n; len *= 2)
+                for (std::size_t s = 0; s < n; s += len)
+                    for (std::size_t k = 0; k < len / 2; ++k)
+                    {
+                        const auto w = std::polar(1.0, -2 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(len));
+                        const auto u = a[s + k], v = a[s + k + len / 2] * w;
+                        a[s + k] = u + v;
+                        a[s + k + len / 2] = u - v;
+                    }
+        };
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 3; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        for (const std::size_t n : {std::size_t{1} << 12, std::size_t{1} << 16, std::size_t{1} << 20})
+        {
+            std::vector<dual<cd>> x(n);
+            std::vector<dual<double>> r(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                x[i] = dual<cd>{cd{std::sin(0.001 * i), 0.5}, cd{std::cos(0.002 * i), 0.0}};
+                r[i] = dual<double>{std::sin(0.001 * i), std::cos(0.002 * i)};
+            }
+            const std::size_t repeats = (std::size_t{1} << 22) / n;
+
+            auto y = x;
+            const double generic_ms = time([&] { for (std::size_t k = 0; k < repeats; ++k) { y = x; generic(y); } }) / repeats;
+            fft_plan<double> plan{n}, unblocked{n, n};
+            const double plan_ms = time([&] { for (std::size_t k = 0; k < repeats; ++k) { y = x; plan.forward(std::span{y}); } }) / repeats;
+            const double unblocked_ms = time([&] { for (std::size_t k = 0; k < repeats; ++k) { y = x; unblocked.forward(std::span{y}); } }) / repeats;
+            std::vector<dual<cd>> S(n / 2 + 1);
+            const double real_ms = time([&] { for (std::size_t k = 0; k < repeats; ++k) plan.forward(std::span<const dual<double>>{r}, std::span{S}); }) / repeats;
+            std::printf("n = 2^%-2d  generic %9.3f ms   planes %9.3f ms (%4.1fx)   unblocked %9.3f ms   real, two for one %9.3f ms\n",
+                        std::countr_zero(n), generic_ms, plan_ms, generic_ms / plan_ms, unblocked_ms, real_ms);
+        }
+        std::cout << "--dual fft--" << std::endl;
+    }   // dual fft
+
+    {   // uncertainty propagation
+        std::cout << "--uncertainty propagation--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        constexpr std::size_t N = 8, M = 2, records = 100000;
+
+        // a small calibration model, two outputs of eight measured inputs
+        auto model = [](const auto& x)
+        {
+            const auto gain = x[0] * exp(-x[1] * x[2]) + x[3];
+            const auto phase = atan(x[4] / (x[5] + 2.0)) * sqrt(x[6] * x[6] + 1.0);
+            return std::array{gain * cos(phase) + x[7], gain * sin(phase) - 0.5 * x[7]};
+        };
+        std::vector<std::array<double, N>> x(records);
+        for (std::size_t i = 0; i < records; ++i)
+            for (std::size_t k = 0; k < N; ++k)
+                x[i][k] = 0.5 + 0.1 * std::sin(0.01 * static_cast<double>(i * (k + 1)));
+        std::array<std::array<double, N>, N> S{};
+        for (std::size_t i = 0; i < N; ++i)
+            for (std::size_t j = 0; j < N; ++j)
+                S[i][j] = 1e-4 * std::pow(0.5, std::abs(static_cast<int>(i) - static_cast<int>(j)));
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 5; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        // one dual pass per input, then J S J^T in full
+        double passes_sum = 0;
+        const double passes_ms = time([&]
+        {
+            double sum = 0;
+            for (const auto& r : x)
+            {
+                std::array<std::array<double, N>, M> J;
+                for (std::size_t k = 0; k < N; ++k)
+                {
+                    std::array<dual<double>, N> v;
+                    for (std::size_t i = 0; i < N; ++i)
+                        v[i] = dual<double>{r[i], i == k ? 1.0 : 0.0};
+                    const auto y = model(v);
+                    for (std::size_t m = 0; m < M; ++m)
+                        J[m][k] = y[m].d();
+                }
+                for (std::size_t m = 0; m < M; ++m)
+                    for (std::size_t i = 0; i < N; ++i)
+                        for (std::size_t j = 0; j < N; ++j)
+                            sum += J[m][i] * S[i][j] * J[m][j];
+            }
+            passes_sum = sum;
+        });
+
+        const input_covariance<double, N> s{S};
+        std::vector<uncertainty_result<double, N, M>> out(records);
+        sweep_pool serial{1};
+        const double single_ms = time([&] { propagate_batch(model, std::span<const std::array<double, N>>{x}, s, std::span{out}, serial); });
+        const double pool_ms = time([&] { propagate_batch(model, std::span<const std::array<double, N>>{x}, s, std::span{out}); });
+        double sum = 0;
+        for (const auto& o : out)
+            sum += o.covariance[0][0] + o.covariance[1][1];
+        std::printf("%zu records, %zu inputs   per-input passes %8.2f ms   one mdual pass %8.2f ms (%4.1fx)   on %zu threads %8.2f ms   sum of variances %.12g (%.12g)\n",
+                    records, N, passes_ms, single_ms, passes_ms / single_ms, sweep_pool::shared().size(), pool_ms, sum, passes_sum);
+        std::cout << "--uncertainty propagation--" << std::endl;
+    }   // uncertainty propagation
+
+    {   // monte-carlo greeks
+        std::cout << "--monte-carlo greeks--" << std::endl;
+        using clock = std::chrono::steady_clock;
+        static constexpr double K = 105;
+
+        // an Asian call on monthly averages
+        auto asian = [](std::span<const mdual<double, 3>> path)
+        {
+            mdual<double, 3> a{};
+            for (const auto& s : path)
+                a += s;
+            a /= static_cast<double>(path.size());
+            return a > K ? a - K : mdual<double, 3>{};
+        };
+        // the same on plain doubles, with the same normals
+        auto price = [](const monte_carlo_setup<double>& m)
+        {
+            const double dt = m.maturity / static_cast<double>(m.steps), root_dt = std::sqrt(dt);
+            const double log_spot = std::log(m.spot), drift = m.rate - 0.5 * m.volatility * m.volatility;
+            double sum = 0;
+            for (std::size_t p = 0; p < m.paths; ++p)
+            {
+                double w = 0, a = 0;
+                std::array<double, 2> z{};
+                for (std::size_t k = 0; k < m.steps; ++k)
+                {
+                    if (k % 2 == 0)
+                        z = normal_pair<double>(m.seed, p, k / 2);
+                    w += root_dt * z[k % 2];
+                    a += std::exp(log_spot + drift * dt * static_cast<double>(k + 1) + m.volatility * w);
+                }
+                a /= static_cast<double>(m.steps);
+                sum += a > K ? a - K : 0.0;
+            }
+            return std::exp(-m.rate * m.maturity) * sum / static_cast<double>(m.paths);
+        };
+
+        auto time = [&](auto run)
+        {
+            double best = 1e300;
+            for (int round = 0; round < 3; ++round)
+            {
+                const auto start = clock::now();
+                run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+            }
+            return best;
+        };
+
+        const monte_carlo_setup<double> setup{100, 0.2, 0.03, 1.5, 12, 200000, 1};
+        greeks_result<double> g;
+        const double pathwise_ms = time([&] { g = monte_carlo_greeks(setup, asian); });
+
+        // central differences, a base run and two per Greek
+        std::array<double, 4> bumped{};
+        const double bump_ms = time([&]
+        {
+            const double h = 1e-3;
+            auto m = setup;
+            bumped[0] = price(m);
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                double& x = k == 0 ? m.spot : k == 1 ? m.volatility : m.rate;
+                x += h;
+                const double up = price(m);
+                x -= 2 * h;
+                const double down = price(m);
+                x += h;
+                bumped[k + 1] = (up - down) / (2 * h);
+            }
+        });
+        std::printf("%zu paths x %zu dates   one mdual simulation %8.1f ms   bump and reprice (7 runs) %8.1f ms (%4.1fx)\n",
+                    setup.paths, setup.steps, pathwise_ms, bump_ms, bump_ms / pathwise_ms);
+        std::printf("price %.6f (%.6f)   delta %.6f (%.6f)   vega %.5f (%.5f)   rho %.5f (%.5f)   standard errors %.2g %.2g %.2g %.2g\n",
+                    g.price, bumped[0], g.delta, bumped[1], g.vega, bumped[2], g.rho, bumped[3],
+                    g.standard_error[0], g.standard_error[1], g.standard_error[2], g.standard_error[3]);
+        std::cout << "--monte-carlo greeks--" << std::endl;
+    }   // monte-carlo greeks
+
+    return 0;
+}
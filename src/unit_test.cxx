@@ -1,143 +1,2106 @@
 # include <dual_numbers.hxx>
+# include <dual_linalg.hxx>
+# include <dual_solve.hxx>
+# include <dual_reduce.hxx>
+# include <dual_poly.hxx>
+# include <dual_special.hxx>
+# include <dual_file.hxx>
+# include <dual_format.hxx>
+# include <dual_lazy.hxx>
+# include <dual_multi.hxx>
+# include <dual_sparse.hxx>
+# include <dual_dynamic.hxx>
+# include <dual_sweep.hxx>
+# include <dual_stream.hxx>
+# include <dual_trace.hxx>
+# include <dual_codegen.hxx>
+# include <dual_reverse.hxx>
+# include <dual_hessian.hxx>
+# include <dual_fft.hxx>
+# include <dual_uncertainty.hxx>
+# include <dual_montecarlo.hxx>
+
+# include <algorithm>
+# include <array>
+# include <atomic>
+# include <chrono>
+# include <complex>
+# include <cstddef>
+# include <cstdio>
+# include <cstdlib>
+# include <filesystem>
+# include <fstream>
+# include <functional>
+# include <limits>
+# include <map>
+# include <numbers>
+# include <random>
+# include <sstream>
+# include <stdexcept>
+# include <string>
+# include <string_view>
+# include <thread>
+# include <type_traits>
+# include <utility>
+# include <vector>
+
+# include <math.h>
+# include <unistd.h>
 
 using namespace dnn;
 
-auto main() -> int
+// Derivative correctness and throughput harness.
+//
+// Every operator and elementary function is evaluated at random points for
+// dual<float>, dual<double> and dual<long double>. Values are compared with
+// the long double std:: function, or for long double with the _Float128 one
+// of glibc's libm, which the duals do not call, where it is available; tangents with a complex step derivative
+// where std::complex provides the function and with a 7 point central
+// difference in long double where it does not. Errors are measured in ulps of
+// the tested type; for the tangent the ulp is taken at the sum of the
+// magnitudes of the partial contributions, which is the scale any rounding in
+// the tangent formula is relative to. The rounding error of a difference
+// quotient is subtracted first, so long double tangents of the functions
+// without a complex form are checked more loosely than the others.
+//
+// Next to the random cases run fixed checks of the other headers. All jobs
+// are spread over the cores, each case also records its time per call, which
+// can be saved with --timings and compared against a saved run with --baseline.
+//
+//      unit_test [--samples N] [--jobs N] [--seed N]
+//                [--timings file] [--baseline file] [--slowdown factor]
+
+namespace harness
+{
+    using real = long double;
+    using cplx = std::complex<long double>;
+
+    // ulp of the type T at magnitude r, subnormals counted at the smallest normal
+    template<typename T>
+    auto ulp(real r) -> real
+    {
+        r = std::fabs(r);
+        if (r < std::numeric_limits<T>::min())
+            r = std::numeric_limits<T>::min();
+        int e = 0;
+        std::frexp(r, &e);
+        return std::ldexp(real{1}, e - std::numeric_limits<T>::digits);
+    }
+
+    template<typename T>
+    auto ulps(real got, real ref, real scale) -> real
+    {
+        if (std::isnan(ref) && std::isnan(got))
+            return 0;
+        if (std::isinf(ref) && got == ref)
+            return 0;
+        if (!std::isfinite(got) || !std::isfinite(ref))
+            return std::numeric_limits<real>::infinity();
+        return std::fabs(got - ref) / ulp<T>(scale);
+    }
+
+#if defined(__GLIBC__) && defined(__HAVE_FLOAT128) && __HAVE_FLOAT128
+#   define DNN_TEST_QUAD
+    // the reference precision of long double values
+    using quad = __float128;
+#endif
+
+    // The reference functions, in long double from the std:: functions and in
+    // quad from the *f128 functions of glibc's libm.
+    namespace ref
+    {
+        inline auto fabs(real x) -> real { return std::fabs(x); }
+        inline auto sqrt(real x) -> real { return std::sqrt(x); }
+        inline auto cbrt(real x) -> real { return std::cbrt(x); }
+        inline auto exp(real x) -> real { return std::exp(x); }
+        inline auto expm1(real x) -> real { return std::expm1(x); }
+        inline auto log(real x) -> real { return std::log(x); }
+        inline auto log1p(real x) -> real { return std::log1p(x); }
+        inline auto pow(real x, real y) -> real { return std::pow(x, y); }
+        inline auto hypot(real x, real y) -> real { return std::hypot(x, y); }
+        inline auto sin(real x) -> real { return std::sin(x); }
+        inline auto cos(real x) -> real { return std::cos(x); }
+        inline auto tan(real x) -> real { return std::tan(x); }
+        inline auto asin(real x) -> real { return std::asin(x); }
+        inline auto acos(real x) -> real { return std::acos(x); }
+        inline auto atan(real x) -> real { return std::atan(x); }
+        inline auto atan2(real y, real x) -> real { return std::atan2(y, x); }
+        inline auto sinh(real x) -> real { return std::sinh(x); }
+        inline auto cosh(real x) -> real { return std::cosh(x); }
+        inline auto tanh(real x) -> real { return std::tanh(x); }
+        inline auto erf(real x) -> real { return std::erf(x); }
+        inline auto erfc(real x) -> real { return std::erfc(x); }
+        inline auto tgamma(real x) -> real { return std::tgamma(x); }
+        inline auto lgamma(real x) -> real { return std::lgamma(x); }
+        inline auto j0(real x) -> real { return std::cyl_bessel_j(real{0}, x); }
+        inline auto j1(real x) -> real { return std::cyl_bessel_j(real{1}, x); }
+        inline auto y0(real x) -> real { return std::cyl_neumann(real{0}, x); }
+        inline auto y1(real x) -> real { return std::cyl_neumann(real{1}, x); }
+
+#ifdef DNN_TEST_QUAD
+        inline auto fabs(quad x) -> quad { return fabsf128(x); }
+        inline auto sqrt(quad x) -> quad { return sqrtf128(x); }
+        inline auto cbrt(quad x) -> quad { return cbrtf128(x); }
+        inline auto exp(quad x) -> quad { return expf128(x); }
+        inline auto expm1(quad x) -> quad { return expm1f128(x); }
+        inline auto log(quad x) -> quad { return logf128(x); }
+        inline auto log1p(quad x) -> quad { return log1pf128(x); }
+        inline auto pow(quad x, quad y) -> quad { return powf128(x, y); }
+        inline auto hypot(quad x, quad y) -> quad { return hypotf128(x, y); }
+        inline auto sin(quad x) -> quad { return sinf128(x); }
+        inline auto cos(quad x) -> quad { return cosf128(x); }
+        inline auto tan(quad x) -> quad { return tanf128(x); }
+        inline auto asin(quad x) -> quad { return asinf128(x); }
+        inline auto acos(quad x) -> quad { return acosf128(x); }
+        inline auto atan(quad x) -> quad { return atanf128(x); }
+        inline auto atan2(quad y, quad x) -> quad { return atan2f128(y, x); }
+        inline auto sinh(quad x) -> quad { return sinhf128(x); }
+        inline auto cosh(quad x) -> quad { return coshf128(x); }
+        inline auto tanh(quad x) -> quad { return tanhf128(x); }
+        inline auto erf(quad x) -> quad { return erff128(x); }
+        inline auto erfc(quad x) -> quad { return erfcf128(x); }
+        inline auto tgamma(quad x) -> quad { return tgammaf128(x); }
+        inline auto lgamma(quad x) -> quad { return lgammaf128(x); }
+        inline auto j0(quad x) -> quad { return j0f128(x); }
+        inline auto j1(quad x) -> quad { return j1f128(x); }
+        inline auto y0(quad x) -> quad { return y0f128(x); }
+        inline auto y1(quad x) -> quad { return y1f128(x); }
+#endif
+
+        // Neither libm has the digamma function, so it is summed here, apart
+        // from dnn::digamma: the recurrence up to x >= 60 and then the
+        // asymptotic series to B20, whose next term is below 1e-34 there.
+        template<typename R>
+        auto digamma(R x) -> R
+        {
+            constexpr std::array<std::array<int, 2>, 10> bernoulli = {{
+                {1, 6}, {-1, 30}, {1, 42}, {-1, 30}, {5, 66},
+                {-691, 2730}, {7, 6}, {-3617, 510}, {43867, 798}, {-174611, 330}}};
+            R shift{0};
+            for (; x < R{60}; x += R{1})
+                shift -= R{1} / x;
+            const R w = R{1} / (x * x);
+            R series{0}, power = w;
+            for (std::size_t k = 0; k < bernoulli.size(); ++k, power *= w)
+                series += R(bernoulli[k][0]) / R(bernoulli[k][1] * 2 * static_cast<int>(k + 1)) * power;
+            return shift + log(x) - R{1} / (R{2} * x) - series;
+        }
+    }  // namespace ref
+
+    // (a, da, b, db) -> (value, tangent) of the case evaluated in some type
+    using evaluator = std::function<std::pair<real, real>(real, real, real, real)>;
+    // mean time per call in ns over the given (a, da, b, db) inputs
+    using timer = std::function<double(const std::vector<std::array<real, 4>>&)>;
+
+    inline constexpr const char* type_names[3] = {"float", "double", "long double"};
+
+    struct function_case
+    {
+        std::string name;
+        std::array<std::pair<real, real>, 2> domain;
+        std::array<bool, 2> seeded;                         // arguments carrying a tangent
+        std::function<real(real, real)> value;              // reference value
+#ifdef DNN_TEST_QUAD
+        std::function<quad(quad, quad)> precise;            // for long double, may be empty
+#endif
+        std::function<cplx(cplx, cplx)> holomorphic;        // for the complex step, may be empty
+        real value_budget;                                  // ulps of the tested type
+        real tangent_budget;
+        real value_floor;                                   // values are compared at least at this scale
+        real tangent_floor;                                 // tangents at least at this times |da| + |db|
+        std::array<evaluator, 3> eval;
+        std::array<timer, 3> time;
+    };
+
+    template<typename T, typename F>
+    auto make_evaluator(F f) -> evaluator
+    {
+        return [f](real a, real da, real b, real db)
+        {
+            const auto r = f(dual<T>{static_cast<T>(a), static_cast<T>(da)}, dual<T>{static_cast<T>(b), static_cast<T>(db)});
+            return std::pair<real, real>{static_cast<real>(r.re()), static_cast<real>(r.d())};
+        };
+    }
+
+    template<typename T, typename F>
+    auto make_timer(F f) -> timer
+    {
+        return [f](const std::vector<std::array<real, 4>>& in)
+        {
+            using clock = std::chrono::steady_clock;
+
+            std::vector<dual<T>> a, b;
+            for (const auto& v : in)
+            {
+                a.push_back(dual<T>{static_cast<T>(v[0]), static_cast<T>(v[1])});
+                b.push_back(dual<T>{static_cast<T>(v[2]), static_cast<T>(v[3])});
+            }
+
+            // the best of 5 rounds of about 5 ms, the minimum is what is stable
+            // against other jobs and the scheduler
+            volatile T sink = 0;
+            double best = std::numeric_limits<double>::infinity();
+            for (int round = 0; round < 5; ++round)
+            {
+                std::size_t calls = 0;
+                const auto start = clock::now();
+                auto elapsed = std::chrono::duration<double, std::nano>{};
+                do
+                {
+                    T acc = 0;
+                    for (std::size_t i = 0; i < a.size(); ++i)
+                    {
+                        const auto r = f(a[i], b[i]);
+                        acc += static_cast<T>(r.re() + r.d());
+                    }
+                    sink = sink + acc;
+                    calls += a.size();
+                    elapsed = clock::now() - start;
+                } while (elapsed.count() < 5e6);
+                best = std::min(best, elapsed.count() / calls);
+            }
+            return best;
+        };
+    }
+
+    struct case_options
+    {
+        std::array<std::pair<real, real>, 2> domain = {{{-4, 4}, {-4, 4}}};
+        std::array<bool, 2> seeded = {true, false};
+        std::function<cplx(cplx, cplx)> holomorphic = {};
+        real value_budget = 4;
+        real tangent_budget = 8;
+        real value_floor = 0;
+        real tangent_floor = 0;
+    };
+
+    // value is called on real, and on quad when it is generic over the two
+    template<typename F, typename V>
+    auto make_case(std::string name, F f, V value, case_options o) -> function_case
+    {
+        function_case c{
+            std::move(name), o.domain, o.seeded, [value](real a, real b) -> real { return value(a, b); },
+#ifdef DNN_TEST_QUAD
+            {},
+#endif
+            std::move(o.holomorphic), o.value_budget, o.tangent_budget, o.value_floor, o.tangent_floor,
+            {make_evaluator<float>(f), make_evaluator<double>(f), make_evaluator<long double>(f)},
+            {make_timer<float>(f), make_timer<double>(f), make_timer<long double>(f)}};
+#ifdef DNN_TEST_QUAD
+        if constexpr (std::is_same_v<std::invoke_result_t<V&, quad, quad>, quad>)
+            c.precise = value;
+#endif
+        return c;
+    }
+
+    struct reference
+    {
+        real tangent;       // along (da, db)
+        real scale;         // |df/da da| + |df/db db|
+        real uncertainty;   // bound on the error of tangent itself
+    };
+
+    // The partial derivatives of the reference, from a complex step when the
+    // case has a holomorphic extension, otherwise from a 7 point central
+    // difference in long double. The difference is exact to O(h^6); the error
+    // of the function values, taken as reference_ulps long double ulps of the
+    // larger of |f| and the value floor, grows by 1.8 / h in it and is returned
+    // so the caller can allow for it, which matters for long double only.
+    inline constexpr real reference_ulps = 16;
+
+    inline auto
+    reference_tangent(const function_case& c, real a, real da, real b, real db)
+        -> reference
+    {
+        auto partial = [&](int k, real t) -> std::pair<real, real>
+        {
+            if (t == 0)
+                return {0, 0};
+            if (c.holomorphic)
+            {
+                // a power of two, so the step and the division by it are exact
+                const real h = std::ldexp(real{1}, -300);
+                const cplx z = k == 0 ? c.holomorphic(cplx{a, h}, cplx{b}) : c.holomorphic(cplx{a}, cplx{b, h});
+                return {z.imag() / h, 0};
+            }
+            const real x = k == 0 ? a : b;
+            const real h = std::ldexp(real{1}, -10) * std::clamp(std::fabs(x), real{0.0625}, real{1});
+            real fmax = c.value_floor;
+            auto g = [&](real s)
+            {
+                const real f = k == 0 ? c.value(a + s * h, b) : c.value(a, b + s * h);
+                fmax = std::fmax(fmax, std::fabs(f));
+                return f;
+            };
+            const real p = (45 * (g(1) - g(-1)) - 9 * (g(2) - g(-2)) + (g(3) - g(-3))) / (60 * h);
+            return {p, 2 * reference_ulps * std::numeric_limits<real>::epsilon() * fmax / h};
+        };
+        const auto [pa, ua] = partial(0, da);
+        const auto [pb, ub] = partial(1, db);
+        return {pa * da + pb * db, std::fabs(pa * da) + std::fabs(pb * db), ua * std::fabs(da) + ub * std::fabs(db)};
+    }
+
+    struct outcome
+    {
+        std::string name;
+        std::string type;
+        real value_ulps = 0;
+        real tangent_ulps = 0;
+        std::size_t samples = 0;
+        std::size_t failures = 0;
+        double ns_per_call = 0;
+        std::vector<std::string> notes;
+    };
+
+    template<typename T>
+    auto round_to(real v) -> real
+    { return static_cast<real>(static_cast<T>(v)); }
+
+    template<typename T>
+    auto run_case(const function_case& c, int type, std::size_t samples, std::uint64_t seed) -> outcome
+    {
+        outcome out;
+        out.name = c.name;
+        out.type = type_names[type];
+        std::mt19937_64 rng{seed};
+        std::uniform_real_distribution<double> ua(static_cast<double>(c.domain[0].first), static_cast<double>(c.domain[0].second));
+        std::uniform_real_distribution<double> ub(static_cast<double>(c.domain[1].first), static_cast<double>(c.domain[1].second));
+        std::uniform_real_distribution<double> ud(-1, 1);
+
+        std::vector<std::array<real, 4>> inputs;
+        for (std::size_t i = 0; i < samples; ++i)
+        {
+            // inputs are rounded to T first so the reference sees exactly what the dual does
+            const real a  = round_to<T>(ua(rng));
+            const real b  = round_to<T>(ub(rng));
+            const real da = c.seeded[0] ? round_to<T>(ud(rng)) : 0;
+            const real db = c.seeded[1] ? round_to<T>(ud(rng)) : 0;
+            inputs.push_back({a, da, b, db});
+
+            const auto [re, d] = c.eval[type](a, da, b, db);
+            real ref = c.value(a, b);
+            const auto r = reference_tangent(c, a, da, b, db);
+
+            real ev = ulps<T>(re, ref, std::fmax(std::fabs(ref), c.value_floor));
+#ifdef DNN_TEST_QUAD
+            // the long double std:: function is what the dual calls, so long
+            // double values are measured against quad, the error taken in quad
+            if (std::is_same_v<T, long double> && c.precise)
+            {
+                const quad q = c.precise(a, b);
+                ref = static_cast<real>(q);
+                const real error = static_cast<real>(static_cast<quad>(re) - q);
+                if (std::isfinite(error))
+                    ev = std::fabs(error) / ulp<T>(std::fmax(std::fabs(ref), c.value_floor));
+            }
+#endif
+            const real scale = std::fmax(r.scale, c.tangent_floor * (std::fabs(da) + std::fabs(db)));
+            const real et = std::fmax(ulps<T>(d, r.tangent, scale) - r.uncertainty / ulp<T>(scale), real{0});
+            out.value_ulps = std::fmax(out.value_ulps, ev);
+            out.tangent_ulps = std::fmax(out.tangent_ulps, et);
+            ++out.samples;
+            if (!(ev <= c.value_budget) || !(et <= c.tangent_budget))
+            {
+                if (++out.failures <= 3)
+                {
+                    std::ostringstream os;
+                    os.precision(std::numeric_limits<T>::max_digits10);
+                    os << "at (" << static_cast<T>(a) << ", " << static_cast<T>(da) << ", " << static_cast<T>(b) << ", " << static_cast<T>(db) << "): "
+                       << "got " << static_cast<T>(re) << " + " << static_cast<T>(d) << "_eps, expected "
+                       << static_cast<T>(ref) << " + " << static_cast<T>(r.tangent) << "_eps";
+                    out.notes.push_back(os.str());
+                }
+            }
+        }
+        out.ns_per_call = c.time[type](inputs);
+        return out;
+    }
+
+    // Collects the results of fixed checks.
+    struct checker
+    {
+        std::size_t count = 0;
+        std::vector<std::string> failed;
+
+        auto operator()(const std::string& what, bool ok) -> void
+        {
+            ++count;
+            if (!ok)
+                failed.push_back(what);
+        }
+    };
+
+    struct check_group
+    {
+        std::string name;
+        std::function<void(checker&)> run;
+    };
+}  // namespace harness
+
+using harness::real;
+using harness::cplx;
+using harness::case_options;
+using harness::make_case;
+namespace ref = harness::ref;
+
+// the operators and elementary functions, with their reference values
+auto function_cases() -> std::vector<harness::function_case>
+{
+    const std::array<bool, 2> both = {true, true};
+    const std::array<std::pair<real, real>, 2> positive = {{{0.25, 4}, {0.25, 4}}};
+    const std::array<std::pair<real, real>, 2> power = {{{0.1, 4}, {-3, 3}}};
+    // holomorphic stand-ins with the right derivatives away from the branch cuts
+    const auto hypot = [](cplx a, cplx b) { return std::sqrt(a * a + b * b); };
+    const auto atan2 = [](cplx a, cplx b) { return std::atan(a / b); };
+
+    std::vector<harness::function_case> cases;
+
+    // arithmetic
+    cases.push_back(make_case("dual + dual", [](auto a, auto b) { return a + b; }, [](auto a, auto b) { return a + b; },
+        {.seeded = both, .holomorphic = [](cplx a, cplx b) { return a + b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("dual - dual", [](auto a, auto b) { return a - b; }, [](auto a, auto b) { return a - b; },
+        {.seeded = both, .holomorphic = [](cplx a, cplx b) { return a - b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("dual * dual", [](auto a, auto b) { return a * b; }, [](auto a, auto b) { return a * b; },
+        {.seeded = both, .holomorphic = [](cplx a, cplx b) { return a * b; }, .value_budget = 0.5, .tangent_budget = 2}));
+    cases.push_back(make_case("dual / dual", [](auto a, auto b) { return a / b; }, [](auto a, auto b) { return a / b; },
+        {.domain = positive, .seeded = both, .holomorphic = [](cplx a, cplx b) { return a / b; }, .value_budget = 0.5, .tangent_budget = 4}));
+    cases.push_back(make_case("dual + scalar", [](auto a, auto b) { return a + b.re(); }, [](auto a, auto b) { return a + b; },
+        {.holomorphic = [](cplx a, cplx b) { return a + b; }, .value_budget = 0.5, .tangent_budget = 0}));
+    cases.push_back(make_case("dual - scalar", [](auto a, auto b) { return a - b.re(); }, [](auto a, auto b) { return a - b; },
+        {.holomorphic = [](cplx a, cplx b) { return a - b; }, .value_budget = 0.5, .tangent_budget = 0}));
+    cases.push_back(make_case("dual * scalar", [](auto a, auto b) { return a * b.re(); }, [](auto a, auto b) { return a * b; },
+        {.holomorphic = [](cplx a, cplx b) { return a * b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("dual / scalar", [](auto a, auto b) { return a / b.re(); }, [](auto a, auto b) { return a / b; },
+        {.domain = positive, .holomorphic = [](cplx a, cplx b) { return a / b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("scalar + dual", [](auto a, auto b) { return b.re() + a; }, [](auto a, auto b) { return b + a; },
+        {.holomorphic = [](cplx a, cplx b) { return b + a; }, .value_budget = 0.5, .tangent_budget = 0}));
+    cases.push_back(make_case("scalar - dual", [](auto a, auto b) { return b.re() - a; }, [](auto a, auto b) { return b - a; },
+        {.holomorphic = [](cplx a, cplx b) { return b - a; }, .value_budget = 0.5, .tangent_budget = 0}));
+    cases.push_back(make_case("scalar * dual", [](auto a, auto b) { return b.re() * a; }, [](auto a, auto b) { return b * a; },
+        {.holomorphic = [](cplx a, cplx b) { return b * a; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("scalar / dual", [](auto a, auto b) { return b.re() / a; }, [](auto a, auto b) { return b / a; },
+        {.domain = positive, .holomorphic = [](cplx a, cplx b) { return b / a; }, .value_budget = 0.5, .tangent_budget = 4}));
+    cases.push_back(make_case("-dual", [](auto a, auto) { return -a; }, [](auto a, auto) { return -a; },
+        {.holomorphic = [](cplx a, cplx) { return -a; }, .value_budget = 0, .tangent_budget = 0}));
+    cases.push_back(make_case("dual += dual", [](auto a, auto b) { a += b; return a; }, [](auto a, auto b) { return a + b; },
+        {.seeded = both, .holomorphic = [](cplx a, cplx b) { return a + b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("dual -= dual", [](auto a, auto b) { a -= b; return a; }, [](auto a, auto b) { return a - b; },
+        {.seeded = both, .holomorphic = [](cplx a, cplx b) { return a - b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("dual *= dual", [](auto a, auto b) { a *= b; return a; }, [](auto a, auto b) { return a * b; },
+        {.seeded = both, .holomorphic = [](cplx a, cplx b) { return a * b; }, .value_budget = 0.5, .tangent_budget = 2}));
+    cases.push_back(make_case("dual /= dual", [](auto a, auto b) { a /= b; return a; }, [](auto a, auto b) { return a / b; },
+        {.domain = positive, .seeded = both, .holomorphic = [](cplx a, cplx b) { return a / b; }, .value_budget = 0.5, .tangent_budget = 4}));
+    cases.push_back(make_case("dual *= scalar", [](auto a, auto b) { a *= b.re(); return a; }, [](auto a, auto b) { return a * b; },
+        {.holomorphic = [](cplx a, cplx b) { return a * b; }, .value_budget = 0.5, .tangent_budget = 1}));
+    cases.push_back(make_case("dual /= scalar", [](auto a, auto b) { a /= b.re(); return a; }, [](auto a, auto b) { return a / b; },
+        {.domain = positive, .holomorphic = [](cplx a, cplx b) { return a / b; }, .value_budget = 0.5, .tangent_budget = 1}));
+
+    // elementary functions
+    cases.push_back(make_case("pow(dual, dual)", [](auto a, auto b) { return dnn::pow(a, b); }, [](auto a, auto b) { return ref::pow(a, b); },
+        {.domain = power, .seeded = both, .holomorphic = [](cplx a, cplx b) { return std::pow(a, b); }, .value_budget = 4, .tangent_budget = 16}));
+    cases.push_back(make_case("pow(dual, scalar)", [](auto a, auto b) { return dnn::pow(a, b.re()); }, [](auto a, auto b) { return ref::pow(a, b); },
+        {.domain = power, .holomorphic = [](cplx a, cplx b) { return std::pow(a, b); }, .value_budget = 4, .tangent_budget = 16}));
+    cases.push_back(make_case("pow(scalar, dual)", [](auto a, auto b) { return dnn::pow(a.re(), b); }, [](auto a, auto b) { return ref::pow(a, b); },
+        {.domain = power, .seeded = {false, true}, .holomorphic = [](cplx a, cplx b) { return std::pow(a, b); }, .value_budget = 4, .tangent_budget = 16}));
+    cases.push_back(make_case("sqrt", [](auto a, auto) { return dnn::sqrt(a); }, [](auto a, auto) { return ref::sqrt(a); },
+        {.domain = {{{0.01, 100}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::sqrt(a); }, .value_budget = 0.5, .tangent_budget = 2}));
+    cases.push_back(make_case("cos", [](auto a, auto) { return dnn::cos(a); }, [](auto a, auto) { return ref::cos(a); },
+        {.holomorphic = [](cplx a, cplx) { return std::cos(a); }}));
+    cases.push_back(make_case("sin", [](auto a, auto) { return dnn::sin(a); }, [](auto a, auto) { return ref::sin(a); },
+        {.holomorphic = [](cplx a, cplx) { return std::sin(a); }}));
+    cases.push_back(make_case("tan", [](auto a, auto) { return dnn::tan(a); }, [](auto a, auto) { return ref::tan(a); },
+        {.domain = {{{-1.4, 1.4}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::tan(a); }}));
+    cases.push_back(make_case("exp", [](auto a, auto) { return dnn::exp(a); }, [](auto a, auto) { return ref::exp(a); },
+        {.domain = {{{-10, 10}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::exp(a); }}));
+    cases.push_back(make_case("log", [](auto a, auto) { return dnn::log(a); }, [](auto a, auto) { return ref::log(a); },
+        {.domain = {{{0.01, 100}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::log(a); }}));
+    cases.push_back(make_case("acos", [](auto a, auto) { return dnn::acos(a); }, [](auto a, auto) { return ref::acos(a); },
+        {.domain = {{{-0.95, 0.95}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::acos(a); }}));
+    cases.push_back(make_case("asin", [](auto a, auto) { return dnn::asin(a); }, [](auto a, auto) { return ref::asin(a); },
+        {.domain = {{{-0.95, 0.95}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::asin(a); }}));
+    cases.push_back(make_case("atan", [](auto a, auto) { return dnn::atan(a); }, [](auto a, auto) { return ref::atan(a); },
+        {.domain = {{{-10, 10}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::atan(a); }}));
+    cases.push_back(make_case("hypot(dual, dual)", [](auto a, auto b) { return dnn::hypot(a, b); }, [](auto a, auto b) { return ref::hypot(a, b); },
+        {.seeded = both, .holomorphic = hypot}));
+    cases.push_back(make_case("hypot(dual, scalar)", [](auto a, auto b) { return dnn::hypot(a, b.re()); }, [](auto a, auto b) { return ref::hypot(a, b); },
+        {.holomorphic = hypot}));
+    cases.push_back(make_case("hypot(scalar, dual)", [](auto a, auto b) { return dnn::hypot(a.re(), b); }, [](auto a, auto b) { return ref::hypot(a, b); },
+        {.seeded = {false, true}, .holomorphic = hypot}));
+    cases.push_back(make_case("sinh", [](auto a, auto) { return dnn::sinh(a); }, [](auto a, auto) { return ref::sinh(a); },
+        {.domain = {{{-5, 5}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::sinh(a); }}));
+    cases.push_back(make_case("cosh", [](auto a, auto) { return dnn::cosh(a); }, [](auto a, auto) { return ref::cosh(a); },
+        {.domain = {{{-5, 5}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::cosh(a); }}));
+    // past the cutover to e^|x| / 2, up to near the float overflow
+    cases.push_back(make_case("sinh (large)", [](auto a, auto) { return dnn::sinh(a); }, [](auto a, auto) { return ref::sinh(a); },
+        {.domain = {{{-88, 88}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::sinh(a); }}));
+    cases.push_back(make_case("cosh (large)", [](auto a, auto) { return dnn::cosh(a); }, [](auto a, auto) { return ref::cosh(a); },
+        {.domain = {{{-88, 88}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::cosh(a); }}));
+    cases.push_back(make_case("tanh", [](auto a, auto) { return dnn::tanh(a); }, [](auto a, auto) { return ref::tanh(a); },
+        {.domain = {{{-5, 5}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::tanh(a); }}));
+    // through the cutover to 1, which comes later in the wider types
+    cases.push_back(make_case("tanh (large)", [](auto a, auto) { return dnn::tanh(a); }, [](auto a, auto) { return ref::tanh(a); },
+        {.domain = {{{-30, 30}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::tanh(a); }}));
+    cases.push_back(make_case("atan2(dual, dual)", [](auto a, auto b) { return dnn::atan2(a, b); }, [](auto a, auto b) { return ref::atan2(a, b); },
+        {.seeded = both, .holomorphic = atan2}));
+    cases.push_back(make_case("atan2(dual, scalar)", [](auto a, auto b) { return dnn::atan2(a, b.re()); }, [](auto a, auto b) { return ref::atan2(a, b); },
+        {.holomorphic = atan2}));
+    cases.push_back(make_case("atan2(scalar, dual)", [](auto a, auto b) { return dnn::atan2(a.re(), b); }, [](auto a, auto b) { return ref::atan2(a, b); },
+        {.seeded = {false, true}, .holomorphic = atan2}));
+    cases.push_back(make_case("log1p", [](auto a, auto) { return dnn::log1p(a); }, [](auto a, auto) { return ref::log1p(a); },
+        {.domain = {{{-0.9, 10}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::log(cplx{1} + a); }}));
+    cases.push_back(make_case("expm1", [](auto a, auto) { return dnn::expm1(a); }, [](auto a, auto) { return ref::expm1(a); },
+        {.domain = {{{-5, 5}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::exp(a) - cplx{1}; }}));
+    cases.push_back(make_case("cbrt", [](auto a, auto) { return dnn::cbrt(a); }, [](auto a, auto) { return ref::cbrt(a); },
+        {.domain = {{{0.1, 10}, {0, 0}}}, .holomorphic = [](cplx a, cplx) { return std::pow(a, cplx{1} / cplx{3}); }}));
+    cases.push_back(make_case("abs", [](auto a, auto) { return dnn::abs(a); }, [](auto a, auto) { return ref::fabs(a); },
+        {.holomorphic = [](cplx a, cplx) { return a.real() < 0 ? -a : a; }, .value_budget = 0, .tangent_budget = 0}));
+
+    // special functions
+    cases.push_back(make_case("erf", [](auto a, auto) { return dnn::erf(a); }, [](auto a, auto) { return ref::erf(a); },
+        {.domain = {{{-3, 3}, {0, 0}}}}));
+    cases.push_back(make_case("erfc", [](auto a, auto) { return dnn::erfc(a); }, [](auto a, auto) { return ref::erfc(a); },
+        {.domain = {{{-3, 3}, {0, 0}}}}));
+    cases.push_back(make_case("tgamma", [](auto a, auto) { return dnn::tgamma(a); }, [](auto a, auto) { return ref::tgamma(a); },
+        {.domain = {{{0.1, 10}, {0, 0}}}, .value_budget = 8, .tangent_budget = 64, .tangent_floor = 1}));
+    cases.push_back(make_case("lgamma", [](auto a, auto) { return dnn::lgamma(a); }, [](auto a, auto) { return ref::lgamma(a); },
+        {.domain = {{{0.1, 20}, {0, 0}}}, .tangent_budget = 64, .value_floor = 1, .tangent_floor = 1}));
+    cases.push_back(make_case("digamma", [](auto a, auto) { return dnn::digamma(a); }, [](auto a, auto) { return ref::digamma(a); },
+        {.domain = {{{0.1, 20}, {0, 0}}}, .value_budget = 128, .tangent_budget = 64, .value_floor = 1, .tangent_floor = 1}));
+    cases.push_back(make_case("j0", [](auto a, auto) { return dnn::j0(a); }, [](auto a, auto) { return ref::j0(a); },
+        {.domain = {{{0.1, 20}, {0, 0}}}, .value_budget = 32, .tangent_budget = 64, .value_floor = 1, .tangent_floor = 1}));
+    cases.push_back(make_case("j1", [](auto a, auto) { return dnn::j1(a); }, [](auto a, auto) { return ref::j1(a); },
+        {.domain = {{{0.1, 20}, {0, 0}}}, .value_budget = 32, .tangent_budget = 64, .value_floor = 1, .tangent_floor = 1}));
+    cases.push_back(make_case("y0", [](auto a, auto) { return dnn::y0(a); }, [](auto a, auto) { return ref::y0(a); },
+        {.domain = {{{0.5, 20}, {0, 0}}}, .value_budget = 32, .tangent_budget = 64, .value_floor = 1, .tangent_floor = 1}));
+    cases.push_back(make_case("y1", [](auto a, auto) { return dnn::y1(a); }, [](auto a, auto) { return ref::y1(a); },
+        {.domain = {{{0.5, 20}, {0, 0}}}, .value_budget = 32, .tangent_budget = 64, .value_floor = 1, .tangent_floor = 1}));
+
+    return cases;
+}
+
+// fixed checks of the construction semantics and of the other headers
+auto check_groups() -> std::vector<harness::check_group>
 {
-    // unit test
-    {   // default constructor
-        std::cout << "--default constructor--" << std::endl;
-        std::cout << dual<int>{} << std::endl;
-        std::cout << dual<double>{} << std::endl;
-        std::cout << "--default constructor--" << std::endl;
-    }   // default constructor
-    
-    {   // singe variable constructor
-        std::cout << "--single variable constructor--" << std::endl;
-        std::cout << dual<int>{1} << std::endl;
-        std::cout << dual<double>{1} << std::endl;
-        std::cout << "--single variable constructor--" << std::endl;
-    }   // singe variable constructor
-
-    {   // dual number specific functions
-        std::cout << "--dual number specific functions--" << std::endl;
-        auto x = dual<double>{-1,1};
-        std::cout << "auto x = dual<double>{-1,1}: " << std::endl;
-        std::cout << "re(x):    " << (dnn::equiv(x.re(), -1) ? "passed" : "failed") << std::endl;
-        std::cout << "d(x):     " << (dnn::equiv(x.d(), 1) ? "passed" : "failed") << std::endl;
-        std::cout << "norm(x)): " << (dnn::equiv(x.norm(), 1) ? "passed" : "failed") << std::endl;
-        std::cout << "conj(x):  " << (dnn::equiv(x.conj(), dual<double>{-1, -1}) ? "passed" : "failed") << std::endl;
-        std::cout << "x:        " << (dnn::equiv(x, dual<double>{-1, 1}) ? "passed" : "failed") << std::endl;
-        std::cout << "--dual number specific functions--" << std::endl;
-    }   // dual number specific functions
-    
-    {   // unary arithmetic
-        std::cout << "--unary arithmetic--" << std::endl;
-        {
-            auto x = dual<int>{1, 1};
-            std::cout << "auto x = dual<int>{1,1}" << std::endl;
-            std::cout << "(x += 2): " << (dnn::equiv((x += 2), dual<int>{3, 1}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x -= 2): " << (dnn::equiv((x -= 2), dual<int>{1, 1}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x /= 2): " << (dnn::equiv((x /= 2), dual<int>{0, 0}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x *= 2): " << (dnn::equiv((x *= 2), dual<int>{0, 0}) ? "passed" : "failed") << std::endl;
-        }
-
-        {
-            auto x = dual<double>{1, 1};
-            std::cout << "auto x = dual<double>{1,1}" << std::endl;
-            std::cout << "(x += 2): " << (dnn::equiv((x += 2), dual<double>{3, 1}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x -= 2): " << (dnn::equiv((x -= 2), dual<double>{1, 1}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x /= 2): " << (dnn::equiv((x /= 2), dual<double>{0.5, 0.5}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x *= 2): " << (dnn::equiv((x *= 2), dual<double>{1, 1}) ? "passed" : "failed") << std::endl;
-        }
-
-        {
-            auto x = dual<int>{1, 2};
-            auto y = dual<int>{3, 4};
-            std::cout << "auto x = dual<int>{1,2}" << std::endl;
-            std::cout << "auto y = dual<int>{3,4}" << std::endl;
-            std::cout << "(x += y): " << (dnn::equiv((x += y), dual<int>{4, 6}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x -= y): " << (dnn::equiv((x -= y), dual<int>{1, 2}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x /= y): " << (dnn::equiv((x /= y), dual<int>{0, 0}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x *= y): " << (dnn::equiv((x *= y), dual<int>{0, 0}) ? "passed" : "failed") << std::endl;
-        }
-
-        {
-            auto x = dual<double>{1, 2};
-            auto y = dual<double>{3, 4};
-            std::cout << "auto x = dual<double>{1,2}" << std::endl;
-            std::cout << "auto y = dual<double>{3,4}" << std::endl;
-            std::cout << "(x += y): " << (dnn::equiv((x += y), dual<double>{4, 6}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x -= y): " << (dnn::equiv((x -= y), dual<double>{1, 2}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x /= y): " << (dnn::equiv((x /= y), dual<double>{1.0/3, 2.0/9}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x *= y): " << (dnn::equiv((x *= y), dual<double>{1, 2}) ? "passed" : "failed") << std::endl;
-        }
-        {
-            auto x = dual<double>{1, 2};
-            auto y = dual<int>{3, 4};
-            std::cout << "auto x = dual<double>{1,2}" << std::endl;
-            std::cout << "auto y = dual<int>{3,4}" << std::endl;
-            std::cout << "(x += y): " << (dnn::equiv((x += y), dual<double>{4, 6}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x -= y): " << (dnn::equiv((x -= y), dual<double>{1, 2}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x /= y): " << (dnn::equiv((x /= y), dual<double>{1.0/3, 2.0/9}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x *= y): " << (dnn::equiv((x *= y), dual<double>{1, 2}) ? "passed" : "failed") << std::endl;
-        }
-        {
-            auto x = dual<int>{1, 2};
-            auto y = dual<double>{3.0, 4.0};
-            std::cout << "auto x = dual<int>{1,2}" << std::endl;
-            std::cout << "auto y = dual<double>{3,4}" << std::endl;
-            std::cout << "(x += y): " << (dnn::equiv((x += y), dual<int>{4, 6}) ? "passed" : "failed") << std::endl;
-            std::cout << "(x -= y): " << (dnn::equiv((x -= y), dual<int>{1, 2}) ? "passed" : "failed") << std::endl;
-            // --unexpected behaviour--
-            std::cout << "(x /= y): " << (dnn::equiv((x /= y), dual<int>{0, 0}) ? "passed" : "failed") << std::endl;
-            //
-            // /= yields an integer type in this case
-            // This mirrors the default cpp behaviour
-            // for example:
-            //
-            // int z = 1;
-            // std::cout << (z /= 3.0) << std::endl
-            //
-            // the above yields the result as integer division
-            // one would instead expect the result to be floating point division.
-            // --unexpected behaviour--
-            std::cout << "(x *= y): " << (dnn::equiv((x *= y), dual<int>{0, 0}) ? "passed" : "failed") << std::endl;
-        }
-
-        std::cout << "--unary arithmetic--" << std::endl;
-    }   // unary arithmetic
-
-    {   // elementary functions
-        std::cout << "--elementary functions--" << std::endl;
-        auto x = dual<int>{2, 2};
-        auto y = dual<double>{0.5, 2};
-        std::cout << "pow:  " << (dnn::equiv( dnn::pow(x, 0.5), dual<double>{dnn::pow(x.re(), 0.5), 0.5 * dnn::pow(x.re(), -0.5) * x.d()} ) ? "passed" : "failed") << std::endl; 
-        std::cout << "pow:  " << (dnn::equiv( dnn::pow(0.5, x), dual<double>{dnn::pow(0.5, x.re()), dnn::log(0.5) * dnn::pow(0.5, x.re()) * x.d()} ) ? "passed" : "failed") << std::endl;
-        std::cout << "pow:  " << (dnn::equiv( dnn::pow(x, y), dual<double>{dnn::pow(x.re(), y.re()), y.re() * dnn::pow(x.re(), y.re()-1) * x.d() + std::log(x.re()) * std::pow(x.re(), y.re()) * y.d()}) ? "passed" : "failed") << std::endl;
-        std::cout << "sqrt: " << (dnn::equiv( dnn::sqrt(x), dual<double>{dnn::sqrt(x.re()), 0.5 * dnn::pow(x.re(), -0.5) * x.d()} ) ? "passed" : "failed") << std::endl;
-        std::cout << "cos:  " << (dnn::equiv( dnn::cos(x), dual<double>{dnn::cos(x.re()), -dnn::sin(x.re()) * x.d()} ) ? "passed" : "failed") << std::endl;
-        std::cout << "sin:  " << (dnn::equiv( dnn::sin(x), dual<double>{dnn::sin(x.re()), dnn::cos(x.re()) * x.d()} ) ? "passed" : "failed") << std::endl;
-        // be careful of the arc-trig function domains, they are quite small
-        std::cout << "acos: " << (dnn::equiv( dnn::acos(y), dual<double>{dnn::acos(y.re()), -y.d()/dnn::sqrt(1-y.re()*y.re())} ) ? "passed" : "failed") << std::endl;
-        std::cout << "asin: " << (dnn::equiv( dnn::asin(y), dual<double>{dnn::asin(y.re()), y.d()/dnn::sqrt(1-y.re()*y.re())} ) ? "passed" : "failed") << std::endl;
-        std::cout << "atan: " << (dnn::equiv( dnn::atan(y), dual<double>{dnn::atan(y.re()), y.d()/(1+y.re()*y.re())} ) ? "passed" : "failed") << std::endl;
-        std::cout << "--elementary functions--" << std::endl;
-    }   // elementary functions
-
-    {   // elementary functions (general)
-        std::cout << "--elementary functions (general)--" << std::endl;
+    using harness::checker;
+
+    std::vector<harness::check_group> groups;
+
+    groups.push_back({"construction", [](checker& expect)
+    {
+        expect("default constructor", dnn::equiv(dual<int>{}, dual<int>{0, 0}) && dnn::equiv(dual<double>{}, dual<double>{0, 0}));
+        expect("single variable constructor", dnn::equiv(dual<int>{1}, 1) && dnn::equiv(dual<double>{1}, 1.0));
+        expect("converting constructor", dnn::equiv(dual<float>{dual<double>{0.5, 0.25}}, dual<float>{0.5f, 0.25f}));
+        auto x = dual<double>{-1, 1};
+        expect("re(x)", dnn::equiv(x.re(), -1));
+        expect("d(x)", dnn::equiv(x.d(), 1));
+        expect("norm(x)", dnn::equiv(x.norm(), 1));
+        expect("conj(x)", dnn::equiv(x.conj(), dual<double>{-1, -1}));
+        std::ostringstream os;
+        os << dual<double>{1.5, -2};
+        expect("operator<<", os.str() == "1.5 + -2_eps");
+    }});
+
+    groups.push_back({"integer arithmetic", [](checker& expect)
+    {
+        auto x = dual<int>{1, 1};
+        expect("(x += 2)", dnn::equiv((x += 2), dual<int>{3, 1}));
+        expect("(x -= 2)", dnn::equiv((x -= 2), dual<int>{1, 1}));
+        expect("(x /= 2)", dnn::equiv((x /= 2), dual<int>{0, 0}));
+        expect("(x *= 2)", dnn::equiv((x *= 2), dual<int>{0, 0}));
+
+        auto y = dual<int>{1, 2};
+        auto z = dual<int>{3, 4};
+        expect("(y += z)", dnn::equiv((y += z), dual<int>{4, 6}));
+        expect("(y -= z)", dnn::equiv((y -= z), dual<int>{1, 2}));
+        expect("(y /= z)", dnn::equiv((y /= z), dual<int>{0, 0}));
+        expect("(y *= z)", dnn::equiv((y *= z), dual<int>{0, 0}));
+
+        // /= into an integer dual truncates like int z = 1; z /= 3.0; does
+        auto w = dual<int>{1, 2};
+        expect("(w /= dual<double>)", dnn::equiv((w /= dual<double>{3.0, 4.0}), dual<int>{0, 0}));
+
+        // dual / dual must use the divisor's real part in the tangent
+        expect("dual / dual", dnn::equiv(dual<double>{1, 2} / dual<double>{4, 1}, dual<double>{0.25, (2 * 4 - 1 * 1) / 16.0}));
+        expect("const dual * const dual", [] { const auto a = dual<double>{2, 1}; const auto b = dual<double>{3, 1}; return dnn::equiv(a * b, dual<double>{6, 5}); }());
+        expect("pow(dual<int>, 0.5)", dnn::equiv(dnn::pow(dual<int>{4, 1}, 0.5), dual<double>{2, 0.25}));
+        expect("pow(negative, integer)", dnn::equiv(dnn::pow(dual<double>{-2, 1}, dual<double>{2, 0}), dual<double>{4, -4}));
+    }});
+
+    groups.push_back({"sign and absolute value", [](checker& expect)
+    {
         auto x = dual<int>{-2, 2};
         auto y = dual<double>{2, 0.5};
-        auto z = dual<int>{0,1};
-        std::cout << "sgn: " << (dnn::equiv( dnn::sgn(x), -1) ? "passed" : "failed") << std::endl; 
-        std::cout << "sgn: " << (dnn::equiv( dnn::sgn(y), 1) ? "passed" : "failed") << std::endl;
-        std::cout << "sgn: " << (dnn::equiv( dnn::sgn(z), 0) ? "passed" : "failed") << std::endl;
-        std::cout << "abs: " << (dnn::equiv( dnn::abs(x), dual<double>{2, -2}) ? "passed" : "failed") << std::endl; 
-        std::cout << "abs: " << (dnn::equiv( dnn::abs(y), dual<double>{2, 0.5}) ? "passed" : "failed") << std::endl;
-        std::cout << "abs: " << (dnn::equiv( dnn::abs(z), 0) ? "passed" : "failed") << std::endl;
-        std::cout << "--elementary functions (general)--" << std::endl;
-    }   // elementary functions (general)
-
-
-}
\ No newline at end of file
+        auto z = dual<int>{0, 1};
+        expect("sgn(x)", dnn::equiv(dnn::sgn(x), -1));
+        expect("sgn(y)", dnn::equiv(dnn::sgn(y), 1));
+        expect("sgn(z)", dnn::equiv(dnn::sgn(z), 0));
+        expect("sgn(scalar)", dnn::sgn(-3.5) == -1 && dnn::sgn(0) == 0 && dnn::sgn(2u) == 1);
+        expect("abs(x)", dnn::equiv(dnn::abs(x), dual<double>{2, -2}));
+        expect("abs(y)", dnn::equiv(dnn::abs(y), dual<double>{2, 0.5}));
+        expect("abs(z)", dnn::equiv(dnn::abs(z), 0));
+    }});
+
+    groups.push_back({"linear algebra kernels", [](checker& expect)
+    {
+        auto a = std::vector<dual<double>>{dual<double>{1, 2}, dual<double>{3, 4}, dual<double>{5, 6}, dual<double>{7, 8}};
+        auto b = std::vector<dual<double>>{dual<double>{-1, 1}, dual<double>{2, 0}, dual<double>{0.5, -2}, dual<double>{1, 3}};
+        auto c = std::vector<dual<double>>(4);
+        auto y = std::vector<dual<double>>(2);
+        dnn::gemm<double>(2, 2, 2, a.data(), 2, b.data(), 2, c.data(), 2);
+        dnn::gemv<double>(2, 2, a.data(), 2, b.data(), y.data());
+        expect("gemm", dnn::equiv(c[1], a[0]*b[1] + a[1]*b[3]) && dnn::equiv(c[2], a[2]*b[0] + a[3]*b[2]));
+        expect("gemv", dnn::equiv(y[0], a[0]*b[0] + a[1]*b[1]) && dnn::equiv(y[1], a[2]*b[0] + a[3]*b[1]));
+        dnn::axpy(2, dual<double>{2, 1}, b.data(), y.data());
+        expect("axpy", dnn::equiv(y[1], a[2]*b[0] + a[3]*b[1] + dual<double>{2, 1}*b[1]));
+
+        // a blocked product large enough to cross every cache block edge
+        std::mt19937_64 rng{7};
+        std::uniform_real_distribution<double> u(-1, 1);
+        const std::size_t m = 67, n = 1030, k = 131;
+        std::vector<dual<double>> A(m * k), B(k * n), C(m * n);
+        for (auto& v : A) v = dual<double>{u(rng), u(rng)};
+        for (auto& v : B) v = dual<double>{u(rng), u(rng)};
+        dnn::gemm<double>(m, n, k, A.data(), k, B.data(), n, C.data(), n);
+        double err = 0;
+        for (std::size_t i = 0; i < m; i += 11)
+            for (std::size_t j = 0; j < n; j += 13)
+            {
+                auto r = dual<double>{};
+                for (std::size_t p = 0; p < k; ++p)
+                    r += A[i * k + p] * B[p * n + j];
+                err = std::max({err, std::abs(r.re() - C[i * n + j].re()), std::abs(r.d() - C[i * n + j].d())});
+            }
+        expect("gemm (blocked)", err < 1e-12);
+    }});
+
+    groups.push_back({"linear solves", [](checker& expect)
+    {
+        auto a = std::vector<dual<double>>{dual<double>{2, 1}, dual<double>{1, 0}, dual<double>{1, 0}, dual<double>{3, 2}};
+        auto b = std::vector<dual<double>>{dual<double>{3, 1}, dual<double>{5, -1}};
+        auto x = std::vector<dual<double>>(2);
+        auto r = std::vector<dual<double>>(2);
+        expect("solve", dnn::solve<double>(2, a.data(), 2, b.data(), x.data()));
+        dnn::gemv<double>(2, 2, a.data(), 2, x.data(), r.data());
+        expect("A x = b", std::abs(r[0].re() - 3) + std::abs(r[0].d() - 1) + std::abs(r[1].re() - 5) + std::abs(r[1].d() + 1) < 1e-12);
+        auto xb = std::vector<dual<double>>(2);
+        expect("solve_batched", dnn::solve_batched<2>(1, a.data(), b.data(), xb.data()) == 0 && dnn::equiv(xb[0], x[0]) && dnn::equiv(xb[1], x[1]));
+        auto s = std::vector<dual<double>>{dual<double>{1, 0}, dual<double>{2, 0}, dual<double>{2, 0}, dual<double>{4, 0}};
+        expect("singular", !dnn::solve<double>(2, s.data(), 2, b.data(), x.data()));
+    }});
+
+    groups.push_back({"reductions", [](checker& expect)
+    {
+        auto v = std::vector<dual<double>>{dual<double>{3, 1}, dual<double>{4, 2}, dual<double>{1e16, 0}, dual<double>{1, 0}, dual<double>{-1e16, 0}};
+        auto x = std::span<const dual<double>>(v);
+        auto w = std::span<const dual<double>>(v.data(), 2);
+        expect("sum (ordered)", dnn::equiv(dnn::sum(w, reduction::ordered), dual<double>{7, 3}));
+        expect("sum (compensated)", dnn::equiv(dnn::sum(x, reduction::compensated), dual<double>{8, 3}));
+        expect("dot", dnn::equiv(dnn::dot(w, w), dual<double>{25, 22}));
+        expect("squared_norm", dnn::equiv(dnn::squared_norm(w), dual<double>{25, 22}));
+        expect("norm", dnn::equiv(dnn::norm(w), dual<double>{5, 2.2}));
+        auto z = std::vector<dual<double>>{dual<double>{0, 3}, dual<double>{0, 4}};
+        expect("norm at zero", dnn::equiv(dnn::norm(std::span<const dual<double>>(z)), dual<double>{0, 5}));
+    }});
+
+    groups.push_back({"polynomial evaluation", [](checker& expect)
+    {
+        auto c = std::array<double, 4>{1, -2, 3, 0.5};
+        auto cs = std::span<const double>(c);
+        auto x = dual<double>{2, 1};
+        // the same polynomial through the generic operators
+        auto p = dual<double>{1} + x*(dual<double>{-2} + x*(dual<double>{3} + x*0.5));
+        expect("horner", dnn::equiv(dnn::horner(cs, x), p));
+        expect("estrin", dnn::equiv(dnn::estrin(c, x), p));
+        // T_0 - 2 T_1 + 3 T_2 + 0.5 T_3 at t = 0.5 is 1 - 1 - 1.5 - 0.5 and its derivative -2 + 6 - 0
+        expect("clenshaw", dnn::equiv(dnn::clenshaw(cs, dual<double>{0.5, 1}), dual<double>{-2, 4}));
+        auto xs = std::vector<dual<double>>(11, x);
+        auto ys = std::vector<dual<double>>(11);
+        dnn::horner(cs, std::span<const dual<double>>(xs), std::span<dual<double>>(ys));
+        expect("horner (batch)", dnn::equiv(ys[0], p) && dnn::equiv(ys[10], p));
+    }});
+
+    groups.push_back({"special functions", [](checker& expect)
+    {
+        auto x = dual<double>{1, 2};
+        auto close = [](double a, double b) { return std::abs(a - b) <= 1e-12 * (1 + std::abs(b)); };
+        // psi(1) = -gamma, psi'(1) = pi^2/6
+        expect("digamma(1)", close(dnn::digamma(x).re(), -0.57721566490153286) && close(dnn::digamma(x).d(), 2 * M_PI*M_PI/6));
+        expect("digamma(-0.5)", close(dnn::digamma(-0.5), 0.03648997397857652));
+        expect("tgamma(1)", close(dnn::tgamma(x).re(), 1) && close(dnn::tgamma(x).d(), -2 * 0.57721566490153286));
+        expect("j1'(0)", close(dnn::j1(dual<double>{0, 1}).d(), 0.5));
+        auto [e, ec] = dnn::erf_erfc(x);
+        expect("erf_erfc", dnn::equiv(e, dnn::erf(x)) && dnn::equiv(ec, dnn::erfc(x)));
+    }});
+
+    groups.push_back({"hyperbolic edge cases", [](checker& expect)
+    {
+        expect("tanh saturates", dnn::equiv(dnn::tanh(dual<double>{-800, 1}), dual<double>{-1, 0}) && dnn::equiv(dnn::tanh(dual<double>{800, 1}), dual<double>{1, 0}));
+        expect("sinh near 0", dnn::sinh(dual<double>{1e-300, 1}).re() == 1e-300);
+
+        // finite up to where sinh itself overflows, also in constant expressions
+        constexpr auto wide = dnn::cosh(dual<double>{-700, 1});
+        expect("cosh(-700)", std::abs(wide.re() / std::cosh(700.0) - 1) < 1e-14 && std::abs(wide.d() / std::sinh(-700.0) - 1) < 1e-14);
+        const auto f = dnn::sinh(dual<float>{-88.5f, 1});
+        expect("float sinh(-88.5)", std::isfinite(f.re()) && std::abs(f.re() / std::sinh(-88.5f) - 1) < 1e-6f && f.d() == -f.re());
+        expect("sinh overflows", std::isinf(dnn::sinh(dual<double>{711, 1}).re()) && std::isinf(dnn::cosh(dual<float>{90, 1}).d()));
+        expect("atan2 at the origin", dnn::equiv(dnn::atan2(dual<double>{0, 1}, dual<double>{0, 1}), dual<double>{0, 0}));
+    }});
+
+    groups.push_back({"binary files", [](checker& expect)
+    {
+        auto x = std::vector<dual<double>>{dual<double>{1, 2}, dual<double>{3, 4}, dual<double>{-5, 0.25}};
+        const auto path = (std::filesystem::temp_directory_path() / "unit_test_duals.bin").string();
+        dnn::write_duals(path, std::span<const dual<double>>(x));
+        {
+            auto f = dnn::mapped_duals<double>{path};
+            auto v = f.duals();
+            expect("aos", v.size() == 3 && dnn::equiv(v[0], x[0]) && dnn::equiv(v[2], x[2]));
+        }
+        dnn::write_duals(path, std::span<const dual<double>>(x), dual_layout::soa);
+        {
+            auto f = dnn::mapped_duals<double>{path};
+            expect("soa", f.re()[1] == 3 && f.d()[1] == 4 && f.d()[2] == 0.25);
+        }
+        bool rejected = false;
+        try { dnn::mapped_duals<float>{path}; } catch (const std::runtime_error&) { rejected = true; }
+        expect("element type", rejected);
+
+        // sizes that would wrap around when multiplied out
+        auto corrupt = [&](std::size_t offset, std::uint64_t value)
+        {
+            dnn::write_duals(path, std::span<const dual<double>>(x), dual_layout::soa);
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(reinterpret_cast<const char*>(&value), sizeof value);
+            file.close();
+            try { dnn::mapped_duals<double>{path}; } catch (const std::runtime_error&) { return true; }
+            return false;
+        };
+        expect("wrapping sizes", corrupt(offsetof(dnn::dual_file_header, count), std::uint64_t{1} << 61)
+                                 && corrupt(offsetof(dnn::dual_file_header, plane_stride), std::uint64_t{1} << 63)
+                                 && corrupt(offsetof(dnn::dual_file_header, data_offset), ~std::uint64_t{63}));
+        std::remove(path.c_str());
+    }});
+
+    groups.push_back({"text formatting and parsing", [](checker& expect)
+    {
+        char buffer[128];
+        auto x = dual<double>{0.1, -2.5e-300};
+        auto r = dnn::to_chars(buffer, buffer + sizeof buffer, x);
+        expect("to_chars (eps)", std::string_view(buffer, r.ptr) == "0.1 + -2.5e-300_eps");
+        auto y = dual<double>{};
+        dnn::from_chars(buffer, r.ptr, y);
+        expect("round trip", dnn::equiv(x, y));
+        r = dnn::to_chars(buffer, buffer + sizeof buffer, x, dual_notation::csv);
+        expect("to_chars (csv)", std::string_view(buffer, r.ptr) == "0.1,-2.5e-300");
+        expect("buffer too small", dnn::to_chars(buffer, buffer + 4, x).ec == std::errc::value_too_large);
+        auto text = std::string_view{" 1.5 - 2_eps\n3,4\n5 + -6_eps\n"};
+        auto v = std::vector<dual<double>>(4);
+        auto p = dnn::from_chars(text.data(), text.data() + text.size(), std::span<dual<double>>(v));
+        expect("from_chars", p.count == 3 && dnn::equiv(v[0], dual<double>{1.5, -2}) && dnn::equiv(v[1], dual<double>{3, 4}) && dnn::equiv(v[2], dual<double>{5, -6}));
+    }});
+
+    groups.push_back({"lazy tangents", [](checker& expect)
+    {
+        // every lazy operation once, against the eager dual
+        auto f = [](auto x, auto y)
+        {
+            return sin(x)*exp(y)/hypot(x, y) + pow(x, y) - atan2(y, x)*cbrt(x) + tanh(x*y) + log1p(x) - expm1(-y)
+                 + sqrt(x)*2.0 + acos(y/4.0) + asin(x/4.0) + atan(x - y) + cosh(y)/sinh(x) + log(x) + tan(x/3.0)
+                 + abs(x - y) + pow(x, 2.0) + pow(2.0, y) + 1.0/x - 3.0 + (x + 1.0)*(2.0 - y) + hypot(x, 1.5) + atan2(0.5, y);
+        };
+        auto& tape = lazy_tape<double>::local();
+        lazy_scope<double> scope;
+
+        std::mt19937_64 rng{11};
+        std::uniform_real_distribution<double> u(0.5, 2);
+        double err = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            const double a = u(rng), b = u(rng);
+            const auto lazy  = f(lazy_dual<double>{a, 1}, lazy_dual<double>{b, 0.5});
+            const auto eager = f(dual<double>{a, 1}, dual<double>{b, 0.5});
+            err = std::max({err, std::abs(lazy.re() - eager.re()), std::abs(lazy.d() - eager.d()) / (1 + std::abs(eager.d()))});
+        }
+        expect("matches dual", err < 1e-14);
+
+        // only the ancestors of what is read are replayed
+        const std::size_t before = tape.size();
+        const std::size_t replayed = tape.replayed();
+        const auto x = lazy_dual<double>{0.5, 1};
+        const auto y = lazy_dual<double>{0.25, 1};
+        const auto p = f(x, x);
+        const auto q = sin(y) * y;
+        expect("q' = cos y y + sin y", std::abs(q.d() - (std::cos(0.25) * 0.25 + std::sin(0.25))) < 1e-15);
+        expect("p not replayed", tape.replayed() - replayed == 3 && tape.size() - before > 3);
+        expect("read twice", q.d() == q.d() && tape.replayed() - replayed == 3);
+        expect("p", std::abs(p.d() - f(dual<double>{0.5, 1}, dual<double>{0.5, 1}).d()) < 1e-13);
+
+        // constants stay off the tape
+        const std::size_t size = tape.size();
+        const auto c = lazy_dual<double>{2} * 3.0 + x * 0.0 * 0.0 - lazy_dual<double>{1};
+        expect("x + c reuses x", (x + 1.0).node() == x.node() && (2.0 + x).node() == x.node());
+        expect("constants", !lazy_dual<double>{4.0}.active() && tape.size() - size == 2 && c.d() == 0);
+        {
+            lazy_scope<double> inner;
+            for (int i = 0; i < 10; ++i)
+                static_cast<void>(exp(x) * x);
+        }
+        expect("scope rewinds", tape.size() - size == 2);
+    }});
+
+    groups.push_back({"multi-tangent and sparse duals", [](checker& expect)
+    {
+        // a model of 16 inputs through every operation, sparse against dense
+        auto f = [](const auto& x)
+        {
+            auto acc = x[3] * x[1];
+            acc = acc / x[7] + sin(x[2]) * 2.0 - 1.0 / x[5] + pow(x[4], 1.5) + pow(x[6], x[0]) - exp(x[2]) * tanh(x[1])
+                + sqrt(x[9]) * log(x[8]) - (3.0 - x[10]);
+            acc -= x[11];
+            acc *= x[12];
+            acc /= x[13];
+            acc += 2.0;
+            return abs(acc) + atan(x[14]) + log1p(x[15]) + expm1(x[3]) + tan(x[2]) + cos(x[1]) - (-x[0]);
+        };
+        std::vector<mdual<double, 16>> dense;
+        std::vector<sparse_dual<double>> sparse;
+        std::vector<dual<double>> single;
+        for (std::uint32_t i = 0; i < 16; ++i)
+        {
+            dense.push_back(mdual<double, 16>::variable(0.3 + 0.1 * i, i));
+            sparse.push_back(sparse_dual<double>::variable(0.3 + 0.1 * i, i));
+            single.push_back(dual<double>{0.3 + 0.1 * i, i == 5 ? 1.0 : 0.0});
+        }
+        const auto a = f(dense);
+        const auto b = f(sparse);
+        double err = std::abs(a.re() - b.re());
+        for (std::uint32_t i = 0; i < 16; ++i)
+            err = std::max(err, std::abs(a.d(i) - b.d(i)));
+        expect("sparse matches dense", err == 0 && b.nnz() == 16);
+        expect("dense matches dual", std::abs(f(single).d() - a.d(5)) < 1e-15);
+
+        // merging keeps the indices sorted and unique
+        const auto c = sparse[9] * sparse[2] + sparse[5] - sparse[9] * 2.0;
+        expect("merge", c.nnz() == 3 && c.indices()[0] == 2 && c.indices()[1] == 5 && c.indices()[2] == 9);
+        expect("d(i)", c.d(2) == sparse[9].re() && c.d(5) == 1 && c.d(9) == sparse[2].re() - 2 && c.d(4) == 0);
+        expect("constants", sparse_dual<double>{2.0}.nnz() == 0 && (sparse[1] * 0.0).nnz() == 0);
+
+        // a steady computation recycles its blocks
+        auto& pool = sparse_pool<double>::local();
+        for (int i = 0; i < 100; ++i)
+            static_cast<void>(f(sparse));
+        std::size_t chunks = pool.chunks();
+        for (int i = 0; i < 1000; ++i)
+            static_cast<void>(f(sparse));
+        expect("pool recycles", pool.chunks() == chunks);
+
+        // values freed on another thread go back to this thread's pool, and
+        // that thread's own allocations come from its own pool
+        for (int round = 0; round < 10; ++round)
+        {
+            std::vector<sparse_dual<double>> values;
+            for (int i = 0; i < 1000; ++i)
+                values.push_back(f(sparse));
+            std::size_t other_chunks = 0;
+            std::thread{[&]
+            {
+                values.clear();
+                for (int i = 0; i < 1000; ++i)
+                    static_cast<void>(f(sparse));
+                other_chunks = sparse_pool<double>::local().chunks();
+            }}.join();
+            expect("remote frees", other_chunks > 0 && (round == 0 || pool.chunks() == chunks));
+            if (round == 0)
+                chunks = pool.chunks();
+        }
+    }});
+
+    groups.push_back({"runtime-width duals", [](checker& expect)
+    {
+        auto f = [](const auto& x)
+        {
+            auto acc = x[3] * x[1];
+            acc = acc / x[7] + sin(x[2]) * 2.0 - 1.0 / x[5] + pow(x[4], 1.5) + pow(x[6], x[0]) - exp(x[2]) * tanh(x[1])
+                + sqrt(x[9]) * log(x[8]) - (3.0 - x[10]);
+            acc -= x[11];
+            acc *= x[12];
+            acc /= x[13];
+            acc += 2.0;
+            return abs(acc) + atan(x[14]) + log1p(x[15]) + expm1(x[3]) + tan(x[2]) + cos(x[1]) - (-x[0]);
+        };
+        auto& arena = dual_arena::local();
+        std::vector<mdual<double, 16>> dense;
+        for (std::size_t i = 0; i < 16; ++i)
+            dense.push_back(mdual<double, 16>::variable(0.3 + 0.1 * i, i));
+        const auto a = f(dense);
+        const std::size_t base = arena.used();
+        {
+            arena_scope scope;
+            std::vector<ddual<double>> x;
+            for (std::size_t i = 0; i < 16; ++i)
+                x.push_back(ddual<double>::variable(0.3 + 0.1 * i, i, 16));
+            const auto b = f(x);
+            double err = std::abs(a.re() - b.re());
+            for (std::size_t i = 0; i < 16; ++i)
+                err = std::max(err, std::abs(a.d(i) - b.d(i)));
+            expect("matches dense", err == 0 && b.width() == 16);
+
+            // constants have width 0 and mix with any width
+            const ddual<double> c{2.0};
+            const auto y = c * x[3] + c;
+            expect("constants", c.width() == 0 && y.width() == 16 && y.d(3) == 2 && y.d(4) == 0 && y.re() == 2 * x[3].re() + 2);
+            auto z = c;
+            z += x[2];
+            expect("widening", z.width() == 16 && z.d(2) == 1 && z.re() == 2 + x[2].re());
+
+            // scopes nest, and a scope frees everything allocated inside it
+            const std::size_t used = arena.used();
+            {
+                arena_scope inner;
+                static_cast<void>(f(x));
+                expect("allocates", arena.used() > used);
+            }
+            expect("rewinds", arena.used() == used);
+
+            // accumulating from inner scopes keeps the outer value's storage,
+            // also when the inner values are wider
+            auto acc = ddual<double>::variable(1.0, 0, 4);
+            for (std::size_t n : {4, 4, 16, 16})
+            {
+                arena_scope inner;
+                const auto v = ddual<double>::variable(0.5, 1, n);
+                acc = acc + v * v;
+                acc += v;
+                static_cast<void>(f(x));
+            }
+            {
+                arena_scope inner;
+                static_cast<void>(f(x));
+            }
+            bool kept = acc.width() == 16;
+            for (std::size_t i = 0; i < 16; ++i)
+                kept = kept && acc.d(i) == (i == 0 ? 1.0 : i == 1 ? 8.0 : 0.0);
+            expect("outer accumulation", kept && acc.re() == 4.0);
+            const double* storage = acc.d().data();
+            {
+                arena_scope inner;
+                acc = ddual<double>::variable(2.0, 3, 4);
+            }
+            {
+                arena_scope inner;
+                static_cast<void>(f(x));
+            }
+            expect("outer assignment", acc.d().data() == storage && acc.width() == 4 && acc.d(3) == 1 && acc.d(0) == 0
+                                       && acc.re() == 2.0);
+
+            // a moved-from value is a constant, so reusing it leaves the tangents it gave away alone
+            auto p = ddual<double>::variable(1.0, 0, 2), q = ddual<double>{0.0};
+            q = std::move(p);
+            const auto r = ddual<double>::variable(3.0, 1, 2);
+            p = r;
+            p += r;
+            expect("reuse after move", q.width() == 2 && q.d(0) == 1 && q.d(1) == 0 && p.d(0) == 0 && p.d(1) == 2);
+
+            // swapping with a value of an inner scope
+            auto outer = ddual<double>::variable(1.0, 0, 2);
+            bool swapped = false;
+            {
+                arena_scope inner;
+                auto v = ddual<double>::variable(2.0, 1, 2);
+                std::swap(outer, v);
+                swapped = v.re() == 1.0 && v.d(0) == 1 && v.d(1) == 0 && outer.re() == 2.0 && outer.d(0) == 0 && outer.d(1) == 1;
+            }
+            {
+                arena_scope inner;
+                static_cast<void>(f(x));
+            }
+            expect("swap", swapped && outer.re() == 2.0 && outer.d(0) == 0 && outer.d(1) == 1);
+        }
+        expect("empties", arena.used() == base);
+
+        // a steady loop of scoped evaluations reuses the same blocks, even
+        // when one evaluation spills over a block
+        for (std::size_t n : {16, 4096, 16})
+        {
+            const std::size_t before = arena.blocks();
+            std::size_t blocks = 0;
+            for (int i = 0; i < 100; ++i)
+            {
+                {
+                    arena_scope scope;
+                    std::vector<ddual<double>> x;
+                    for (std::size_t j = 0; j < 16; ++j)
+                        x.push_back(ddual<double>::variable(0.3 + 0.1 * j, j, n));
+                    static_cast<void>(f(x));
+                }
+                if (i == 0)
+                    blocks = arena.blocks();
+            }
+            expect("spills", n != 4096 || blocks > before);
+            expect("reuses blocks", arena.blocks() == blocks);
+        }
+    }});
+
+    groups.push_back({"parameter sweeps", [](checker& expect)
+    {
+        sweep_pool pool{4};
+        const sweep_grid<double, 2> g{{{{0.25, 2.0, 37}, {0.5, 1.5, 23}}}};
+        expect("grid", g.points() == 37 * 23 && g.point(24)[0] == g.axes[0][1] && g.point(24)[1] == g.axes[1][1]
+                       && g.axes[0][36] == 2.0);
+
+        // two outputs against a serial loop
+        auto f = [](const auto& x) { return std::array{sin(x[0]) * x[1] + x[0] * x[0], exp(x[1]) / x[0]}; };
+        std::array<sweep_output<double, 2>, 2> out{sweep_output<double, 2>(g.points()), sweep_output<double, 2>(g.points())};
+        sweep(g, f, std::span{out}, pool);
+        bool same = true;
+        for (std::size_t i = 0; i < g.points(); ++i)
+        {
+            const auto p = g.point(i);
+            const auto y = f(std::array{mdual<double, 2>::variable(p[0], 0), mdual<double, 2>::variable(p[1], 1)});
+            for (std::size_t m = 0; m < 2; ++m)
+                same = same && out[m].re[i] == y[m].re() && out[m].d[0][i] == y[m].d(0) && out[m].d[1][i] == y[m].d(1);
+        }
+        expect("matches serial", same);
+
+        // uneven cost: every point is visited once, and idle threads steal
+        std::vector<std::atomic<int>> visits(20000);
+        pool.run(visits.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                if (i < 2000)
+                    std::this_thread::sleep_for(std::chrono::microseconds{20});
+                ++visits[i];
+            }
+        });
+        expect("visits once", std::all_of(visits.begin(), visits.end(), [](const auto& v) { return v == 1; }));
+        expect("steals", pool.last_run().steals > 0);
+
+        // many more threads than cores and many cheap chunks per thread, which
+        // once grew the chunk size until it wrapped around to 0
+        sweep_pool crowded{16};
+        bool once = true;
+        for (std::size_t n = 1; n <= 600 && once; ++n)
+        {
+            std::vector<std::atomic<int>> hits(n);
+            crowded.run(n, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                    ++hits[i];
+            });
+            once = std::all_of(hits.begin(), hits.end(), [](const auto& v) { return v == 1; });
+        }
+        expect("crowded pool", once);
+
+        // errors
+        sweep_output<double, 2> wrong(5);
+        bool threw = false;
+        try { sweep(g, [](const auto& x) { return x[0]; }, wrong, pool); }
+        catch (const std::invalid_argument&) { threw = true; }
+        expect("output size", threw);
+
+        threw = false;
+        try { pool.run(1000, [](std::size_t begin, std::size_t) { if (begin <= 500) throw std::runtime_error("body"); }); }
+        catch (const std::runtime_error&) { threw = true; }
+        expect("rethrows", threw);
+
+        sweep_pool serial{1};
+        sweep_output<double, 1> line(1000);
+        sweep(sweep_grid<double, 1>{{{{0.0, 1.0, 1000}}}}, [](const auto& t) { return sin(t[0]) * t[0]; }, line, serial);
+        expect("serial pool", serial.size() == 1 && line.d[0][999] == std::cos(1.0) + std::sin(1.0));
+    }});
+
+    groups.push_back({"streamed samples", [](checker& expect)
+    {
+        // the spiral of spiral.cxx, in batches of 64 of a step exact in binary
+        auto spiral = [](const dual<double>& t)
+        { return std::array{dnn::cos(t * (2 * M_PI)) * t, dnn::sin(t * (2 * M_PI)) * t}; };
+        std::size_t n = 0, batches = 0;
+        bool same = true, one_buffer = true;
+        const void* buffer = nullptr;
+        for (const auto& batch : curve_samples<double>(spiral, 0.0, 1.0 / 1024, 1024, 64))
+        {
+            buffer = buffer ? buffer : batch.data();
+            one_buffer = one_buffer && batch.data() == buffer;
+            for (const auto& p : batch)
+            {
+                const auto q = spiral(dual<double>{1.0 * n / 1024, 1});
+                same = same && p[0].re() == q[0].re() && p[0].d() == q[0].d() && p[1].re() == q[1].re() && p[1].d() == q[1].d();
+                ++n;
+            }
+            ++batches;
+        }
+        expect("curve", same && n == 1024 && batches == 16);
+        expect("one buffer", one_buffer);
+
+        // an endless stream, reduced until the consumer has enough
+        double arc = 0;
+        std::size_t taken = 0;
+        for (const auto& batch : curve_samples<double>([](const auto& t) { return dnn::sin(t); }, 0.0, 1e-3))
+        {
+            for (const auto& p : batch)
+                arc += std::hypot(1e-3, 1e-3 * p.d());
+            if (++taken == 100)
+                break;
+        }
+        expect("endless", taken == 100 && arc > 25600e-3 && std::isfinite(arc));
+
+        // a sweep, streamed in grid order
+        const sweep_grid<double, 2> g{{{{0.25, 2.0, 13}, {0.5, 1.5, 7}}}};
+        auto f = [](const auto& x) { return sin(x[0]) * x[1] + x[0] * x[0]; };
+        sweep_output<double, 2> out(g.points());
+        sweep_pool serial{1};
+        sweep(g, f, out, serial);
+        std::size_t i = 0;
+        same = true;
+        for (const auto& batch : sweep_samples(g, f, 10))
+            for (const auto& y : batch)
+            {
+                same = same && y.re() == out.re[i] && y.d(0) == out.d[0][i] && y.d(1) == out.d[1][i];
+                ++i;
+            }
+        expect("sweep", same && i == g.points());
+
+        // errors reach the consumer
+        bool threw = false;
+        try
+        {
+            for (const auto& batch : curve_samples<double>([](const auto& t)
+                                     {
+                                         if (t.re() > 0.5)
+                                             throw std::domain_error("t");
+                                         return t;
+                                     }, 0.0, 0.01, 100, 8))
+                static_cast<void>(batch);
+        }
+        catch (const std::domain_error&) { threw = true; }
+        expect("rethrows", threw);
+
+        // a batch of 0 would yield empty spans forever; the loops stop after a
+        // few so that a regression fails rather than hangs
+        std::size_t curve_batches = 0, sweep_batches = 0;
+        bool curve_threw = false, sweep_threw = false;
+        try
+        {
+            for (const auto& batch : curve_samples<double>([](const auto& t) { return t; }, 0.0, 0.01, 100, 0))
+                if (batch.empty() && ++curve_batches == 4)
+                    break;
+        }
+        catch (const std::invalid_argument&) { curve_threw = true; }
+        try
+        {
+            for (const auto& batch : sweep_samples(g, f, 0))
+                if (batch.empty() && ++sweep_batches == 4)
+                    break;
+        }
+        catch (const std::invalid_argument&) { sweep_threw = true; }
+        expect("empty batch", curve_threw && sweep_threw && curve_batches == 0 && sweep_batches == 0);
+    }});
+
+    groups.push_back({"compile-time evaluation", [](checker& expect)
+    {
+        // every elementary function of dual, evaluated into a constant table
+        // and again at run time through libm
+        constexpr std::size_t functions = 18, points = 24;
+        auto apply = [](std::size_t f, const auto& x)
+        {
+            using dual_type = std::remove_cvref_t<decltype(x)>;
+            const auto y = x * 0.5 + 0.25;         // in (-1, 1) for the inverse trigonometric ones
+            switch (f)
+            {
+                case 0:  return dnn::sqrt(x + 8.0);
+                case 1:  return dnn::exp(x);
+                case 2:  return dnn::log(x + 8.0);
+                case 3:  return dnn::sin(x);
+                case 4:  return dnn::cos(x);
+                case 5:  return dnn::tan(x);
+                case 6:  return dnn::asin(y);
+                case 7:  return dnn::acos(y);
+                case 8:  return dnn::atan(x);
+                case 9:  return dnn::sinh(x);
+                case 10: return dnn::cosh(x);
+                case 11: return dnn::tanh(x);
+                case 12: return dnn::atan2(x, x * x + 0.5);
+                case 13: return dnn::hypot(x, x + 2.0);
+                case 14: return dnn::log1p(y);
+                case 15: return dnn::expm1(x);
+                case 16: return dnn::cbrt(x + 8.0);
+                default: return dnn::pow(x + 8.0, dual_type{1.5, 0.25});
+            }
+        };
+        auto input = [](std::size_t i) { return dual<double>{-1.4 + 2.8 * static_cast<double>(i) / points, 1.0}; };
+        constexpr auto table = [&]
+        {
+            std::array<std::array<dual<double>, points>, functions> t;
+            for (std::size_t f = 0; f < functions; ++f)
+                for (std::size_t i = 0; i < points; ++i)
+                    t[f][i] = apply(f, input(i));
+            return t;
+        }();
+
+        real worst = 0;
+        for (std::size_t f = 0; f < functions; ++f)
+            for (std::size_t i = 0; i < points; ++i)
+            {
+                const auto r = apply(f, input(i));
+                worst = std::max({worst, harness::ulps<double>(table[f][i].re(), r.re(), r.re()),
+                                         harness::ulps<double>(table[f][i].d(), r.d(), r.d())});
+            }
+        expect("matches libm", worst <= 4);
+
+        static_assert(dnn::exp(dual<double>{0.0, 1.0}).re() == 1 && dnn::exp(dual<double>{0.0, 1.0}).d() == 1);
+        static_assert(dnn::sin(dual<float>{0.0f, 1.0f}).d() == 1 && dnn::log(dual<double>{1.0, 2.0}).d() == 2);
+        static_assert(dnn::pow(dual<double>{2.0, 1.0}, 10).re() == 1024 && dnn::pow(dual<double>{-2.0, 1.0}, 3).d() == 12);
+        static_assert(dnn::sqrt(2.0) * dnn::sqrt(2.0) - 2 < 1e-15 && dnn::cmath::pow(2.0, -1074) > 0);
+        expect("limits", cmath::exp(1e4) == std::numeric_limits<double>::infinity() && std::isnan(cmath::log(-1.0)));
+        // long double sinh stays finite past the overflow of m * (m + 2), to about 11356
+        constexpr long double far = cmath::sinh(-6000.0L);
+        expect("long double sinh(-6000)", std::abs(far / std::sinh(-6000.0L) - 1) < 1e-17L && cmath::cosh(6000.0L) == -far);
+    }});
+
+    groups.push_back({"tracing and replay", [](checker& expect)
+    {
+        // every instruction, and a branch on the inputs
+        auto f = [](const auto& x)
+        {
+            auto u = x[0] * x[1] - x[2] / x[0] + (-x[1]);
+            if (x[0] < x[1])
+                u = u + sin(x[0]) * cos(x[1]) + tan(x[2]) - exp(x[0]) + log(x[1]) * sqrt(x[2]);
+            else
+                u = u + acos(x[0] - 1.0) + asin(x[2] * 0.5) + atan(x[1]) + pow(x[0], x[1]);
+            u += sinh(x[0]) + cosh(x[1]) + tanh(x[2]) + log1p(x[0]) + expm1(x[1]) + cbrt(x[2]) + abs(x[0] - 2.0);
+            u = u + hypot(x[0], x[1]) + atan2(x[1], x[2]) + hypot(x[0], 3.0) + hypot(3.0, x[1]) + atan2(x[0], 2.0) + atan2(2.0, x[1]);
+            u = u * 2.0 + 3.0 - (1.0 - u) / 4.0 + 5.0 / u + pow(x[1], 1.5) + pow(1.5, x[2]) + (2.0 + x[0]) * (3.0 * x[2]);
+            const auto w = x[2] >= 0.5 && 1.0 <= x[1] && x[0] != x[2] ? u / 2.0 : u;
+            return std::array{w, x[2] * x[0]};
+        };
+        auto direct = [&](std::array<double, 3> x, std::array<double, 3> s)
+        { return f(std::array{dual<double>{x[0], s[0]}, dual<double>{x[1], s[1]}, dual<double>{x[2], s[2]}}); };
+
+        const std::array<double, 3> x0{0.7, 1.3, 0.9}, s0{1.0, 0.0, 0.0};
+        const auto t = trace<double>::record(f, std::span<const double>{x0}, std::span<const double>{s0});
+        expect("flat", sizeof(trace_instruction) == 12 && t.instructions().size() > 60 && t.guards() == 4 && t.outputs().size() == 2);
+
+        // replayed on the recorded path, bit for bit what dual gives
+        bool same = true, replayed = true;
+        std::array<dual<double>, 2> y;
+        for (int k = 0; k < 50; ++k)
+        {
+            const std::array<double, 3> x{0.6 + 0.004 * k, 1.2 + 0.002 * k, 0.8 + 0.003 * k}, s{0.5, -1.0 * k, 2.0};
+            replayed = replayed && t.replay(x, s, y);
+            const auto r = direct(x, s);
+            same = same && equiv(y[0], r[0]) && equiv(y[1], r[1]);
+        }
+        expect("replays", replayed && same);
+
+        // a point taking the other branch fails its guard and is recorded again
+        const std::array<double, 3> x1{1.5, 1.2, 0.9};
+        expect("guards", !t.replay(x1, s0, y));
+        traced_function<double, decltype(f)> g{f};
+        g(x0, s0, y);
+        g(x1, s0, y);
+        const auto r = direct(x1, s0);
+        g(x0, s0, y);
+        expect("retraces", g.records() == 3 && equiv(y[0], direct(x0, s0)[0]));
+        g(x0, s0, y);
+        g(x0, std::array{0.0, 1.0, 0.0}, y);
+        expect("reuses", g.records() == 3 && equiv(y[0], direct(x0, std::array{0.0, 1.0, 0.0})[0]) && r[0].re() != y[0].re());
+
+        // a traced value outside of its recording
+        std::vector<traced<double>> kept;
+        static_cast<void>(trace<double>::record([&](const auto& x) { kept = x; return x[0]; }, std::span<const double>{x0}));
+        bool threw = false;
+        try { static_cast<void>(kept[0] + kept[1]); }
+        catch (const std::logic_error&) { threw = true; }
+        expect("outside a recording", threw);
+    }});
+
+    groups.push_back({"code generation", [](checker& expect)
+    {
+        // the tracing model without the branch, and sin and cos of the same argument
+        auto f = [](const auto& x)
+        {
+            auto u = x[0] * x[1] - x[2] / x[0] + (-x[1]) + sin(x[0]) * cos(x[0]) + sin(x[0]) + tan(x[2]) - exp(x[0]);
+            u = u + log(x[1]) * sqrt(x[2]) + acos(x[0] - 1.0) + asin(x[2] * 0.5) + atan(x[1]) + pow(x[0], x[1]);
+            u += sinh(x[0]) + cosh(x[1]) + tanh(x[2]) + log1p(x[0]) + expm1(x[1]) + cbrt(x[2]) + abs(x[0] - 2.0);
+            u = u + hypot(x[0], x[1]) + atan2(x[1], x[2]) + hypot(x[0], 3.0) + hypot(3.0, x[1]) + atan2(x[0], 2.0) + atan2(2.0, x[1]);
+            u = u * 2.0 + 3.0 - (1.0 - u) / 4.0 + 5.0 / u + pow(x[1], 1.5) + pow(1.5, x[2]) + (2.0 + x[0]) * (3.0 * x[2]);
+            const auto w = x[2] >= 0.5 && x[0] < x[1] ? u / 2.0 : u;
+            return std::array{w, x[2] * x[0], x[0] * x[2]};
+        };
+        const std::array<double, 3> x0{0.7, 1.3, 0.9}, s0{1.0, 0.0, 0.0};
+        const auto t = trace<double>::record(f, std::span<const double>{x0}, std::span<const double>{s0});
+
+        const compiled_trace<double> k{t};
+        const std::string& source = k.source();
+        auto count = [&](std::string_view what)
+        {
+            std::size_t n = 0;
+            for (auto at = source.find(what); at != std::string::npos; at = source.find(what, at + 1))
+                ++n;
+            return n;
+        };
+        // one sin and one cos, the tangents of each taking the other's value,
+        // and x[0] * x[2] computed once for both outputs
+        expect("subexpressions", count("std::sin(") == 1 && count("std::cos(") == 1 && count("v0 * v2") + count("v2 * v0") == 1);
+
+        bool close = true, passed = true;
+        std::array<dual<double>, 3> y, r;
+        for (int i = 0; i < 50; ++i)
+        {
+            const std::array<double, 3> x{0.6 + 0.004 * i, 1.2 + 0.002 * i, 0.8 + 0.003 * i}, s{0.5, -1.0 * i, 2.0};
+            passed = passed && k(x, s, y) && t.replay(x, s, r);
+            for (std::size_t o = 0; o < 3; ++o)
+                close = close && harness::ulps<double>(y[o].re(), r[o].re(), r[o].re()) <= 4
+                              && harness::ulps<double>(y[o].d(), r[o].d(), std::fabs(r[o].d()) + 1) <= 16;
+        }
+        expect("matches replay", passed && close);
+
+        // the point of the tracing check that takes the other branch
+        const std::array<double, 3> x1{1.5, 1.2, 0.9};
+        expect("guards", !k(x1, s0, y) && !t.replay(x1, s0, r));
+
+        std::vector<double> xs, ss, re(3 * 4), d(3 * 4);
+        for (const auto& p : {x0, x0, x1, x0})
+        {
+            xs.insert(xs.end(), p.begin(), p.end());
+            ss.insert(ss.end(), s0.begin(), s0.end());
+        }
+        k(x0, s0, y);
+        expect("batch", k.batch(4, xs.data(), ss.data(), re.data(), d.data()) == 2 && re[3] == y[0].re() && d[4] == y[1].d());
+
+        // only x[1] active: the seeds of the others are never read and
+        // nothing depending on x[0] and x[2] alone carries a tangent
+        codegen_options only;
+        only.active = {false, true, false};
+        const std::string pruned = emit_cpp(t, only);
+        expect("pruned tangents", pruned.find("seed[0]") == std::string::npos && pruned.find("seed[2]") == std::string::npos
+                                  && pruned.find("seed[1]") != std::string::npos && pruned.find("d[1] = real(0)") != std::string::npos);
+        const compiled_trace<double> kp{t, only};
+        const std::array<double, 3> s1{0.0, 1.0, 0.0};
+        expect("pruned values", kp(x0, s1, y) && t.replay(x0, s1, r)
+                                && harness::ulps<double>(y[0].d(), r[0].d(), std::fabs(r[0].d()) + 1) <= 16 && y[1].d() == 0);
+
+        bool threw = false;
+        codegen_options broken;
+        broken.flags = "-O2 -DDNN_NO_SUCH_FLAG -include dnn_no_such_header.h";
+        try { compiled_trace<double> bad{t, broken}; }
+        catch (const std::runtime_error&) { threw = true; }
+        expect("compiler errors", threw);
+
+        // a cache that others can write to is refused
+        const auto shared = std::filesystem::temp_directory_path() / ("dnn_codegen_shared_" + std::to_string(::getpid()));
+        std::filesystem::create_directory(shared);
+        std::filesystem::permissions(shared, std::filesystem::perms::all);
+        codegen_options unsafe;
+        unsafe.cache = shared;
+        threw = false;
+        try { compiled_trace<double> planted{t, unsafe}; }
+        catch (const std::runtime_error&) { threw = true; }
+        std::filesystem::remove_all(shared);
+        const auto mode = std::filesystem::status(dnn::codegen_detail::default_cache()).permissions();
+        expect("private cache", threw && mode == std::filesystem::perms::owner_all);
+
+        // sinh and cosh past the point where m (m + 2) overflows
+        const std::array<double, 1> big{-600.0}, one{1.0};
+        const auto th = trace<double>::record([](const auto& x) { return std::array{sinh(x[0]), cosh(x[0])}; },
+                                              std::span<const double>{big}, std::span<const double>{one});
+        const compiled_trace<double> kh{th};
+        std::array<dual<double>, 2> yh, rh;
+        expect("large sinh and cosh", kh(big, one, yh) && th.replay(big, one, rh) && std::isfinite(yh[0].re())
+                                      && harness::ulps<double>(yh[0].re(), rh[0].re(), rh[0].re()) <= 4
+                                      && harness::ulps<double>(yh[1].d(), rh[1].d(), rh[1].d()) <= 4);
+
+        // long double tanh between 20 and its cutover to 1, near 22.9
+        const std::array<long double, 1> near{-20.5L}, unit{1.0L};
+        const auto tt = trace<long double>::record([](const auto& x) { return std::array{tanh(x[0])}; },
+                                                   std::span<const long double>{near}, std::span<const long double>{unit});
+        const compiled_trace<long double> kt{tt};
+        std::array<dual<long double>, 1> yt;
+        bool saturates = true;
+        for (const long double v : {-20.5L, 21.5L, 22.5L, 23.5L, -40.0L})
+        {
+            const std::array<long double, 1> xv{v};
+            saturates = saturates && kt(xv, unit, yt) && harness::ulps<long double>(yt[0].re(), std::tanh(v), 1.0L) <= 2;
+        }
+        expect("long double tanh", saturates);
+    }});
+
+    groups.push_back({"reverse mode", [](checker& expect)
+    {
+        auto f = [](const auto& x)
+        {
+            auto u = x[0] * x[1] - x[2] / x[0] + (-x[1]) + sin(x[0]) * cos(x[1]) + tan(x[2]) - exp(x[0]) + log(x[1]) * sqrt(x[2]);
+            u = u + acos(x[0] - 1.0) + asin(x[2] * 0.5) + atan(x[1]) + pow(x[0], x[1]) + pow(x[1], 1.5) + pow(1.5, x[2]);
+            u += sinh(x[0]) + cosh(x[1]) + tanh(x[2]) + log1p(x[0]) + expm1(x[1]) + cbrt(x[2]) + abs(x[0] - 2.0);
+            return u + hypot(x[0], x[1]) + atan2(x[1], x[2]) + 5.0 / u - (1.0 - u) / 4.0 + (x[0] < x[1] ? x[2] : x[0]);
+        };
+        const std::array<double, 3> x0{0.7, 1.3, 0.9};
+        const auto g = gradient<double>(f, std::span<const double>{x0});
+        bool close = true;
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            std::array<dual<double>, 3> x{dual<double>{x0[0]}, dual<double>{x0[1]}, dual<double>{x0[2]}};
+            x[i] = dual<double>{x0[i], 1.0};
+            const auto r = f(x);
+            close = close && harness::ulps<double>(g.value, r.re(), r.re()) == 0
+                          && harness::ulps<double>(g.gradient[i], r.d(), std::fabs(r.d()) + 1) <= 16;
+        }
+        expect("gradient", close);
+
+        // a pendulum with its stiffness and damping carried in the state
+        constexpr std::size_t steps = 200;
+        auto step = [](const auto& x, std::size_t)
+        {
+            constexpr double h = 0.01;
+            auto y = x;
+            y[0] = x[0] + h * x[1];
+            y[1] = x[1] - h * (x[2] * sin(x[0]) + x[3] * x[1]);
+            return y;
+        };
+        auto objective = [](const auto& x) { return x[0] * x[0] + x[1]; };
+        const std::vector<double> start{0.5, 0.0, 4.0, 0.3};
+
+        std::array<double, 4> reference;
+        double reference_value = 0;
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            std::vector<dual<double>> x(start.begin(), start.end());
+            x[i] = dual<double>{start[i], 1.0};
+            for (std::size_t k = 0; k < steps; ++k)
+                x = step(x, k);
+            const auto j = objective(x);
+            reference[i] = j.d();
+            reference_value = j.re();
+        }
+
+        bool matches = true, bounded = true;
+        for (const std::size_t k : {std::size_t{steps + 1}, std::size_t{20}, std::size_t{5}, std::size_t{2}, std::size_t{1}})
+        {
+            const auto r = checkpointed_gradient<double>(step, objective, start, steps, k);
+            for (std::size_t i = 0; i < 4; ++i)
+                matches = matches && harness::ulps<double>(r.gradient[i], reference[i], std::fabs(reference[i]) + 1) <= 64;
+            matches = matches && harness::ulps<double>(r.value, reference_value, std::fabs(reference_value)) <= 4;
+
+            // at most t + 1 evaluations per step, binomial(k - 1 + t, t) >= steps
+            std::size_t t = k > 1 ? 0 : steps - 1;
+            while (k > 1 && reverse_detail::reach(k - 1, t) < steps)
+                ++t;
+            const auto& s = r.statistics;
+            bounded = bounded && s.recorded == steps && s.checkpoints <= k && s.recompute_factor() <= static_cast<double>(t + 1)
+                              && s.peak_bytes >= s.peak_tape_bytes;
+        }
+        expect("checkpointed", matches);
+        expect("schedule", bounded);
+        const auto one = checkpointed_gradient<double>(step, objective, start, steps, 1).statistics;
+        const auto all = checkpointed_gradient<double>(step, objective, start, steps, steps).statistics;
+        expect("recomputation", one.advances == steps * (steps - 1) / 2 && all.advances == steps - 1 && all.checkpoints == steps);
+
+        std::vector<taped<double>> kept;
+        static_cast<void>(gradient<double>([&](const auto& x) { kept = x; return x[0]; }, std::span<const double>{x0}));
+        bool threw = false;
+        try { static_cast<void>(kept[0] * kept[1]); }
+        catch (const std::logic_error&) { threw = true; }
+        expect("outside a recording", threw && (taped<double>{2.0} * taped<double>{3.0}).value() == 6.0);
+    }});
+
+    groups.push_back({"parallel reverse mode", [](checker& expect)
+    {
+        // least squares of a*exp(b*x) + c over shards of 16 records each
+        constexpr std::size_t shards = 300, records = 16;
+        auto residuals = [](const auto& p, std::size_t s)
+        {
+            auto sum = p[0] * 0.0;
+            for (std::size_t r = 0; r < records; ++r)
+            {
+                const double x = static_cast<double>(s * records + r) / (shards * records);
+                const double y = 1.5 * std::exp(-0.7 * x) + 0.2 + 0.01 * std::sin(97.0 * x);
+                const auto e = p[0] * exp(p[1] * x) + p[2] - y;
+                sum += e * e;
+            }
+            return sum;
+        };
+        const std::array<double, 3> p0{1.2, -0.5, 0.1};
+
+        const auto serial = gradient<double>([&](const std::vector<taped<double>>& p)
+        {
+            taped<double> sum = 0.0;
+            for (std::size_t s = 0; s < shards; ++s)
+                sum += residuals(p, s);
+            return sum;
+        }, std::span<const double>{p0});
+
+        sweep_pool one{1}, three{3};
+        const auto a = parallel_gradient<double>(residuals, std::span<const double>{p0}, shards, one);
+        const auto b = parallel_gradient<double>(residuals, std::span<const double>{p0}, shards, three);
+        bool close = harness::ulps<double>(a.value, serial.value, serial.value) <= 64;
+        for (std::size_t k = 0; k < 3; ++k)
+            close = close && harness::ulps<double>(a.gradient[k], serial.gradient[k], std::fabs(serial.gradient[k])) <= 64;
+        expect("gradient", close);
+        // waves of 1, 4 and 8 blocks, over 256 blocks and over 44, a partial run of waves
+        sweep_pool five{5};
+        const auto g = parallel_gradient<double>(residuals, std::span<const double>{p0}, 44, one);
+        const auto h = parallel_gradient<double>(residuals, std::span<const double>{p0}, 44, five);
+        const auto w = parallel_gradient<double>(residuals, std::span<const double>{p0}, shards, five);
+        expect("deterministic", a.value == b.value && a.gradient == b.gradient && a.value == w.value && a.gradient == w.gradient
+                                && g.value == h.value && g.gradient == h.gradient);
+
+        // fewer shards than blocks, and none
+        const auto c = parallel_gradient<double>(residuals, std::span<const double>{p0}, 2, three);
+        const auto d = gradient<double>([&](const std::vector<taped<double>>& p) { return residuals(p, 0) + residuals(p, 1); }, std::span<const double>{p0});
+        const auto e = parallel_gradient<double>(residuals, std::span<const double>{p0}, 0, three);
+        expect("few shards", c.value == d.value && c.gradient == d.gradient && e.value == 0 && e.gradient == std::vector<double>(3, 0.0));
+    }});
+
+    groups.push_back({"preaccumulation", [](checker& expect)
+    {
+        // the spiral of spiral.cxx with a frequency, its length from points along it
+        auto point = [](const auto& v)
+        {
+            const auto t = v[0], w = v[1];
+            const auto angle = t * w * 6.283185307179586;
+            const auto r = t * (1.0 + 0.1 * t * t);
+            return std::array{cos(angle) * r, sin(angle) * r};
+        };
+        auto length = [&](const std::vector<taped<double>>& p, bool preaccumulated)
+        {
+            constexpr int n = 50;
+            taped<double> sum = 0.0;
+            std::array<taped<double>, 2> last{};
+            for (int i = 0; i <= n; ++i)
+            {
+                const std::array<taped<double>, 2> v{p[0] * (static_cast<double>(i) / n), p[1]};
+                const auto q = preaccumulated ? preaccumulate(point, v) : point(v);
+                if (i > 0)
+                    sum += hypot(q[0] - last[0], q[1] - last[1]);
+                last = q;
+            }
+            return sum;
+        };
+        const std::array<double, 2> p0{1.5, 0.8};
+
+        std::size_t plain_statements = 0, preaccumulated_statements = 0;
+        tape<double> t;
+        auto run = [&](bool preaccumulated, std::size_t& statements)
+        {
+            t.clear();
+            typename tape<double>::recording active{t};
+            const std::vector<taped<double>> p{t.variable(p0[0]), t.variable(p0[1])};
+            const auto y = length(p, preaccumulated);
+            statements = t.size();
+            t.seed(y);
+            t.reverse();
+            return std::array{y.value(), t.adjoint(p[0]), t.adjoint(p[1])};
+        };
+        const auto plain = run(false, plain_statements);
+        const auto accumulated = run(true, preaccumulated_statements);
+        bool close = true;
+        for (std::size_t k = 0; k < 3; ++k)
+            close = close && harness::ulps<double>(accumulated[k], plain[k], std::fabs(plain[k]) + 1) <= 16;
+        expect("gradient", close);
+        expect("statements", 2 * preaccumulated_statements < plain_statements);
+
+        // constants in, a constant out with nothing recorded
+        t.clear();
+        typename tape<double>::recording active{t};
+        const auto c = preaccumulate(point, std::array<taped<double>, 2>{taped<double>{0.5}, taped<double>{1.0}});
+        expect("constants", t.size() == 0 && c[0].index() == 0 && c[0].value() == point(std::array{0.5, 1.0})[0]);
+    }});
+
+    groups.push_back({"hessian-vector products", [](checker& expect)
+    {
+        constexpr std::size_t n = 6;
+        auto f = [](const auto& x)
+        {
+            auto s = x[0] * 0.0;
+            for (std::size_t i = 0; i + 1 < n; ++i)
+            {
+                const auto a = x[i + 1] - x[i] * x[i], b = 1.0 - x[i];
+                s += 100.0 * a * a + b * b + sin(x[i]) * exp(0.1 * x[i + 1]) + log1p(x[i] * x[i]) / (2.0 + cos(x[i + 1]));
+                s += sqrt(1.0 + x[i] * x[i]) * tanh(x[i + 1]) + atan(x[i]) * pow(1.5 + x[i + 1], 2.5) + expm1(-x[i] * x[i + 1]);
+            }
+            return s + log(1.0 + x[0] * x[0]) + tan(0.1 * x[n - 1]) + abs(x[2]) + pow(x[1] * x[1] + 1.0, x[3]);
+        };
+        const std::array<double, n> x0{0.3, -0.7, 1.1, 0.4, -0.2, 0.9};
+        const std::array<double, n> v0{1.0, 0.5, -0.25, 2.0, 0.0, -1.0}, v1{0, 0, 1, 0, 0, 0}, v2{0.1, 0.2, 0.3, 0.4, 0.5, 0.6};
+
+        const auto r = hvp<double>(f, std::span<const double>{x0}, std::span<const double>{v0});
+        const auto g = gradient<double>(f, std::span<const double>{x0});
+        bool same = harness::ulps<double>(r.value, g.value, g.value) <= 4;
+        for (std::size_t i = 0; i < n; ++i)
+            same = same && harness::ulps<double>(r.gradient[i], g.gradient[i], std::fabs(g.gradient[i]) + 1) <= 16;
+        expect("gradient", same);
+
+        // against central differences of the reverse gradient along v0
+        auto differences = [&](const auto& fn)
+        {
+            constexpr double h = 1e-6;
+            std::array<double, n> up, down;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                up[i] = x0[i] + h * v0[i];
+                down[i] = x0[i] - h * v0[i];
+            }
+            const auto p = hvp<double>(fn, std::span<const double>{x0}, std::span<const double>{v0});
+            const auto gu = gradient<double>(fn, std::span<const double>{up}), gd = gradient<double>(fn, std::span<const double>{down});
+            bool close = true;
+            for (std::size_t i = 0; i < n; ++i)
+                close = close && std::fabs(p.hv[0][i] - (gu.gradient[i] - gd.gradient[i]) / (2 * h)) <= 1e-6 * (1 + std::fabs(p.hv[0][i]));
+            return close;
+        };
+        expect("product", differences(f));
+
+        // the rest of the functions taped values have
+        auto e = [](const auto& x)
+        {
+            return sinh(0.5 * x[0]) * cosh(x[1]) + asin(0.3 * x[2]) * acos(0.2 * x[3]) + atan2(x[4], 2.0 + x[5] * x[5])
+                 + hypot(x[0], x[4]) * cbrt(2.0 + x[1]) + pow(1.7, x[2] * x[3]) + atan2(x[5] - x[0], x[1]);
+        };
+        expect("other functions", differences(e));
+
+        // a quadratic, exactly
+        auto q = [](const auto& x) { return 0.5 * (3.0 * x[0] * x[0] + 2.0 * x[0] * x[1] + 4.0 * x[1] * x[1]) + x[1]; };
+        const std::array<double, 2> y0{0.3, -2.0}, w{1.0, -3.0};
+        const auto rq = hvp<double>(q, std::span<const double>{y0}, std::span<const double>{w});
+        expect("quadratic", rq.hv[0] == std::vector<double>{3.0 * 1.0 + 1.0 * -3.0, 1.0 * 1.0 + 4.0 * -3.0});
+
+        // three directions at once give what three single ones do
+        const auto b = hvp<double, 3>(f, std::span<const double>{x0},
+                                      std::array{std::span<const double>{v0}, std::span<const double>{v1}, std::span<const double>{v2}});
+        bool batched = b.hv[0] == r.hv[0] && b.gradient == r.gradient;
+        for (const auto& [k, v] : {std::pair{1, v1}, std::pair{2, v2}})
+            batched = batched && b.hv[k] == hvp<double>(f, std::span<const double>{x0}, std::span<const double>{v}).hv[0];
+        expect("batched", batched);
+    }});
+
+    groups.push_back({"complex base types", [](checker& expect)
+    {
+        using cd = std::complex<double>;
+        using cl = std::complex<long double>;
+        static_assert(sizeof(dual<cd>) == 4 * sizeof(double));
+        static_assert(!ordered<dual<cd>> && ordered<dual<double>>);
+
+        // an RC low pass H = 1 / (1 + i w R C), seeded in R
+        constexpr double R = 1e3, C = 1e-7, w = 2e4;
+        const dual<cd> r{cd{R}, cd{1.0}};
+        const auto H = 1.0 / (1.0 + cd{0.0, w * C} * r);
+        const cd den = 1.0 + cd{0.0, w * R * C};
+        const cd dH = -cd{0.0, w * C} / (den * den);
+        expect("transfer function", std::abs(H.re() - 1.0 / den) <= 1e-15 && std::abs(H.d() - dH) <= 1e-15 * std::abs(dH));
+
+        // holomorphic functions against a central difference along the real axis in long double
+        const cd z{0.7, -0.4};
+        const dual<cd> x{z, cd{1.0}};
+        auto check = [&](const char* name, auto f, const dual<cd>& got)
+        {
+            const long double h = 1e-7L;
+            const cl zl{z}, ref = (f(zl + h) - f(zl - h)) / (2 * h);
+            const cl val = f(zl);
+            expect(name, std::abs(cl{got.re()} - val) <= 1e-15L * std::abs(val)
+                      && std::abs(cl{got.d()} - ref) <= 1e-9L * (1 + std::abs(ref)));
+        };
+        check("exp", [](cl u) { return std::exp(u); }, exp(x));
+        check("log", [](cl u) { return std::log(u); }, log(x));
+        check("sqrt", [](cl u) { return std::sqrt(u); }, sqrt(x));
+        check("sin", [](cl u) { return std::sin(u); }, sin(x));
+        check("cos", [](cl u) { return std::cos(u); }, cos(x));
+        check("tan", [](cl u) { return std::tan(u); }, tan(x));
+        check("atan", [](cl u) { return std::atan(u); }, atan(x));
+        check("sinh", [](cl u) { return std::sinh(u); }, sinh(x));
+        check("cosh", [](cl u) { return std::cosh(u); }, cosh(x));
+        check("tanh", [](cl u) { return std::tanh(u); }, tanh(x));
+        check("pow", [](cl u) { return std::pow(u, 2.5L); }, pow(x, 2.5));
+        check("pow complex", [](cl u) { return std::pow(u, cl{1.5L, 0.5L}); }, pow(x, cd{1.5, 0.5}));
+        check("pow dual", [](cl u) { return std::pow(u, u); }, pow(x, x));
+        check("quotient", [](cl u) { return (u * u + 1.0L) / (u - cl{0.0L, 2.0L}); }, (x * x + 1.0) / (x - cd{0.0, 2.0}));
+        dual<cd> q = x * x + 1.0;
+        q /= x - cd{0.0, 2.0};
+        // division over the whole range, where |z|^2 overflows or underflows
+        using cf = std::complex<float>;
+        bool ranged = true;
+        for (int k = -36; k <= 36; k += 4)
+        {
+            const float scale = std::pow(10.0f, static_cast<float>(k));
+            const dual<cf> u{cf{scale}}, v{cf{2 * scale, scale}, cf{1.0f}};
+            dual<cf> w = u;
+            w /= v;
+            const cd d = -cd{1.0} / (cd{2.0, 1.0} * cd{2.0, 1.0} * static_cast<double>(scale));
+            for (const auto& q : {u / v, w, scale / v})
+                ranged = ranged && std::abs(cd{q.re()} - cd{0.4, -0.2}) <= 1e-6 && std::abs(cd{q.d()} - d) <= 1e-6 * std::abs(d);
+        }
+        const auto big = dual<cd>{cd{1e200}} / dual<cd>{cd{2e200, 1e200}, cd{1.0}};
+        const auto tiny = dual<cd>{cd{1e-200}} / dual<cd>{cd{2e-200, 1e-200}};
+        expect("quotient range", ranged && std::abs(big.re() - cd{0.4, -0.2}) <= 1e-15 && std::abs(big.d() / -cd{0.12e-200, -0.16e-200} - 1.0) <= 1e-15
+                                 && std::abs(tiny.re() - cd{0.4, -0.2}) <= 1e-15);
+        check("quotient assignment", [](cl u) { return (u * u + 1.0L) / (u - cl{0.0L, 2.0L}); }, q);
+
+        // a complex derivative is the same along the imaginary axis
+        const auto f = [](const auto& u) { return exp(u) * sin(u); };
+        const auto along_i = f(dual<cd>{z, cd{0.0, 1.0}});
+        expect("cauchy-riemann", std::abs(along_i.d() - cd{0.0, 1.0} * f(x).d()) <= 1e-15 * std::abs(f(x).d()));
+
+        // sgn and abs are the modulus ones
+        expect("modulus", abs(cd{3.0, 4.0}) == 5.0 && sgn(cd{3.0, 4.0}) == cd{0.6, 0.8} && sgn(cd{}) == cd{}
+                       && dual<cd>{cd{3.0, -4.0}}.norm() == cd{5.0});
+    }});
+
+    groups.push_back({"dual fft", [](checker& expect)
+    {
+        using cd = std::complex<double>;
+        using cl = std::complex<long double>;
+
+        // a direct DFT of each plane in long double
+        auto dft = [](const std::vector<cl>& x, int sign)
+        {
+            const std::size_t n = x.size();
+            std::vector<cl> X(n);
+            for (std::size_t k = 0; k < n; ++k)
+                for (std::size_t j = 0; j < n; ++j)
+                    X[k] += x[j] * std::polar(1.0L, sign * 2 * std::numbers::pi_v<long double> * static_cast<long double>((j * k) % n) / n);
+            return X;
+        };
+        auto close = [](const cd& got, const cl& ref, long double scale)
+        { return std::abs(cl{got} - ref) <= 1e-13L * scale; };
+
+        bool complex_ok = true, real_ok = true, blocked = true, round_trip = true;
+        for (const std::size_t n : {1u, 2u, 8u, 64u, 512u})
+        {
+            std::vector<dual<cd>> x(n);
+            std::vector<dual<double>> r(n);
+            std::vector<cl> xv(n), xd(n), rv(n), rd(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                const double t = static_cast<double>(i);
+                x[i] = dual<cd>{cd{std::sin(0.3 * t) + 0.1, std::cos(1.7 * t)}, cd{t / n, -0.5 * std::sin(t)}};
+                r[i] = dual<double>{std::cos(0.9 * t) - 0.2 * t / n, std::exp(-t / n)};
+                xv[i] = cl{x[i].re()}; xd[i] = cl{x[i].d()};
+                rv[i] = r[i].re(); rd[i] = r[i].d();
+            }
+            const long double scale = n;
+
+            auto X = x;
+            fft_plan<double> plan{n};
+            plan.forward(std::span{X});
+            const auto Xv = dft(xv, -1), Xd = dft(xd, -1);
+            for (std::size_t k = 0; k < n; ++k)
+                complex_ok = complex_ok && close(X[k].re(), Xv[k], scale) && close(X[k].d(), Xd[k], scale);
+
+            // a block of 4 splits every size past 4, with the same arithmetic
+            auto B = x;
+            fft_plan<double>{n, 4}.forward(std::span{B});
+            for (std::size_t k = 0; k < n; ++k)
+                blocked = blocked && equiv(B[k], X[k]);
+
+            plan.inverse(std::span{X});
+            for (std::size_t i = 0; i < n; ++i)
+                round_trip = round_trip && close(X[i].re(), xv[i], 1) && close(X[i].d(), xd[i], 1);
+
+            std::vector<dual<cd>> S(n / 2 + 1);
+            plan.forward(std::span<const dual<double>>{r}, std::span{S});
+            const auto Rv = dft(rv, -1), Rd = dft(rd, -1);
+            for (std::size_t k = 0; k <= n / 2; ++k)
+                real_ok = real_ok && close(S[k].re(), Rv[k], scale) && close(S[k].d(), Rd[k], scale);
+
+            std::vector<dual<double>> back(n);
+            plan.inverse(std::span<const dual<cd>>{S}, std::span{back});
+            for (std::size_t i = 0; i < n; ++i)
+                round_trip = round_trip && std::fabs(back[i].re() - r[i].re()) <= 1e-13 && std::fabs(back[i].d() - r[i].d()) <= 1e-13;
+        }
+        expect("complex", complex_ok);
+        expect("real, two for one", real_ok);
+        expect("blocked", blocked);
+        expect("round trip", round_trip);
+
+        // the sensitivity of a low-pass filtered signal to the cutoff, against a central difference
+        constexpr std::size_t n = 256;
+        auto filtered = [&](const dual<double>& cutoff)
+        {
+            std::vector<dual<double>> x(n);
+            for (std::size_t i = 0; i < n; ++i)
+                x[i] = dual<double>{std::sin(0.05 * i) + 0.3 * std::sin(1.3 * i)};
+            std::vector<dual<cd>> S(n / 2 + 1);
+            fft_plan<double> plan{n};
+            plan.forward(std::span<const dual<double>>{x}, std::span{S});
+            for (std::size_t k = 0; k <= n / 2; ++k)
+            {
+                const auto g = 1.0 / (1.0 + static_cast<double>(k * k) / (cutoff * cutoff));
+                S[k] = S[k] * dual<cd>{cd{g.re()}, cd{g.d()}};
+            }
+            plan.inverse(std::span<const dual<cd>>{S}, std::span{x});
+            return x[17];
+        };
+        const double h = 1e-5, c = 9.0;
+        const double fd = (filtered(dual<double>{c + h}).re() - filtered(dual<double>{c - h}).re()) / (2 * h);
+        expect("filter sensitivity", std::fabs(filtered(dual<double>{c, 1.0}).d() - fd) <= 1e-7 * (1 + std::fabs(fd)));
+
+        bool threw = false;
+        try { fft_plan<double>{12}; } catch (const std::invalid_argument&) { threw = true; }
+        expect("power of two", threw);
+    }});
+
+    groups.push_back({"uncertainty propagation", [](checker& expect)
+    {
+        // the area and the aspect of a rectangle, with correlated sides
+        auto rectangle = [](const auto& x) { return std::array{x[0] * x[1], x[0] / x[1]}; };
+        const double w = 3.0, h = 2.0, sw = 0.1, sh = 0.05, rho = 0.3;
+        const input_covariance<double, 2> s{{{{sw * sw, 0.0}, {rho * sw * sh, sh * sh}}}};
+        const auto r = propagate(rectangle, std::array{w, h}, s);
+        const double area = h * h * sw * sw + w * w * sh * sh + 2 * w * h * rho * sw * sh;
+        const double aspect = sw * sw / (h * h) + w * w * sh * sh / (h * h * h * h) - 2 * w * rho * sw * sh / (h * h * h);
+        const double cross = h * sw * sw / h - w * w * sh * sh / (h * h) + rho * sw * sh * (w / h - h * w / (h * h));
+        expect("values", r.value == std::array{6.0, 1.5} && r.jacobian[0] == std::array{2.0, 3.0});
+        expect("covariance", harness::ulps<double>(r.covariance[0][0], area, area) <= 8
+                          && harness::ulps<double>(r.covariance[1][1], aspect, aspect) <= 8
+                          && std::fabs(r.covariance[0][1] - cross) <= 1e-15 && r.covariance[0][1] == r.covariance[1][0]);
+
+        // a linear model exactly, against J S J^T formed directly
+        auto linear = [](const auto& x) { return std::array{2.0 * x[0] - x[1] + 0.5 * x[2], x[2] - 3.0 * x[0]}; };
+        const std::array<std::array<double, 3>, 3> S{{{4.0, 1.0, 0.5}, {1.0, 2.0, -0.25}, {0.5, -0.25, 1.0}}};
+        const auto q = propagate(linear, std::array{1.0, 2.0, 3.0}, input_covariance<double, 3>{S});
+        bool linear_ok = true;
+        for (std::size_t a = 0; a < 2; ++a)
+            for (std::size_t b = 0; b < 2; ++b)
+            {
+                double ref = 0;
+                for (std::size_t i = 0; i < 3; ++i)
+                    for (std::size_t j = 0; j < 3; ++j)
+                        ref += q.jacobian[a][i] * S[i][j] * q.jacobian[b][j];
+                linear_ok = linear_ok && std::fabs(q.covariance[a][b] - ref) <= 1e-14 * 16;
+            }
+        expect("linear", linear_ok);
+
+        // fully correlated inputs are semidefinite, x - y then has no uncertainty beyond rounding
+        auto difference = [](const auto& x) { return x[0] - x[1]; };
+        const auto d = propagate(difference, std::array{1.0, 1.0}, input_covariance<double, 2>{{{{0.04, 0.04}, {0.04, 0.04}}}});
+        const double independent = propagate(difference, std::array{1.0, 1.0}, input_covariance<double, 2>::independent({0.2, 0.2})).sigma();
+        expect("semidefinite", d.covariance[0][0] <= 1e-30 && harness::ulps<double>(independent, std::sqrt(0.08), 1) <= 4);
+        bool threw = false;
+        try { input_covariance<double, 2>{{{{1.0, 0.0}, {2.0, 1.0}}}}; } catch (const std::invalid_argument&) { threw = true; }
+        expect("indefinite", threw);
+        // a zero pivot over a nonzero column, with no negative pivot to give it away
+        threw = false;
+        try { input_covariance<double, 2>{{{{0.0, 1.0}, {1.0, 1.0}}}}; } catch (const std::invalid_argument&) { threw = true; }
+        expect("zero pivot", threw);
+        // inputs in units of very different size, e.g. pascals next to metres:
+        // a small variance is not rounding, and correlation is still found at its scale
+        const input_covariance<double, 2> mixed{{{{1e4, 0.0}, {0.0, 1e-12}}}};
+        const double scaled = propagate([](const auto& x) { return 1e8 * x[1]; }, std::array{1.0, 1.0}, mixed).sigma();
+        const auto tied = propagate([](const auto& x) { return 1e-8 * x[0] - x[1]; }, std::array{1.0, 1.0},
+                                    input_covariance<double, 2>{{{{1e4, 1e-4}, {1e-4, 1e-12}}}});
+        expect("disparate scales", harness::ulps<double>(scaled, 100, 100) <= 4 && tied.sigma() <= 1e-13);
+
+        // a batch gives what single records do, with one pool thread or three
+        auto model = [](const auto& x) { return exp(-x[0]) * sin(x[1]) + x[2] * x[2]; };
+        std::vector<std::array<double, 3>> records(500);
+        std::vector<input_covariance<double, 3>> each(records.size());
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            records[i] = {0.01 * i, 1.0 - 0.003 * i, std::cos(0.1 * i)};
+            each[i] = input_covariance<double, 3>::independent({0.01 * (1 + i % 7), 0.02, 0.005 * i});
+        }
+        sweep_pool one{1}, three{3};
+        std::vector<uncertainty_result<double, 3, 1>> a(records.size()), b(records.size()), c(records.size());
+        propagate_batch(model, std::span<const std::array<double, 3>>{records}, input_covariance<double, 3>{S}, std::span{a}, one);
+        propagate_batch(model, std::span<const std::array<double, 3>>{records}, input_covariance<double, 3>{S}, std::span{b}, three);
+        propagate_batch(model, std::span<const std::array<double, 3>>{records}, std::span<const input_covariance<double, 3>>{each}, std::span{c}, three);
+        bool batch_ok = true;
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            const auto single = propagate(model, records[i], input_covariance<double, 3>{S});
+            batch_ok = batch_ok && a[i].covariance == single.covariance && b[i].covariance == single.covariance && a[i].value == single.value
+                    && c[i].covariance == propagate(model, records[i], each[i]).covariance;
+        }
+        expect("batch", batch_ok);
+    }});
+
+    groups.push_back({"monte-carlo greeks", [](checker& expect)
+    {
+        // Random123's known answers for Philox4x32-10
+        expect("philox", philox4x32({0, 0, 0, 0}, {0, 0}) == std::array<std::uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}
+                      && philox4x32({~0u, ~0u, ~0u, ~0u}, {~0u, ~0u}) == std::array<std::uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}
+                      && philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}) == std::array<std::uint32_t, 4>{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+        // a European call against Black-Scholes
+        const double S = 100, K = 105, sigma = 0.2, r = 0.03, T = 1.5;
+        auto call = [K](std::span<const mdual<double, 3>> path)
+        {
+            const auto& s = path.back();
+            return s > K ? s - K : mdual<double, 3>{};
+        };
+        const monte_carlo_setup<double> setup{S, sigma, r, T, 1, 200000, 7};
+        const auto g = monte_carlo_greeks(setup, call);
+
+        auto Phi = [](double x) { return 0.5 * std::erfc(-x / std::numbers::sqrt2); };
+        const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T)), d2 = d1 - sigma * std::sqrt(T);
+        const double price = S * Phi(d1) - K * std::exp(-r * T) * Phi(d2);
+        const double delta = Phi(d1);
+        const double vega = S * std::sqrt(T) * std::exp(-0.5 * d1 * d1) / std::sqrt(2 * std::numbers::pi);
+        const double rho = K * T * std::exp(-r * T) * Phi(d2);
+        const std::array<double, 4> got{g.price, g.delta, g.vega, g.rho}, ref{price, delta, vega, rho};
+        bool within = g.paths == 200000;
+        for (std::size_t k = 0; k < 4; ++k)
+            within = within && std::fabs(got[k] - ref[k]) <= 4 * g.standard_error[k] && g.standard_error[k] < 0.01 * std::fabs(ref[k]);
+        expect("black-scholes", within);
+
+        // the pathwise delta of an Asian call is the limit of bumping the spot on the same paths
+        auto asian = [K](std::span<const mdual<double, 3>> path)
+        {
+            mdual<double, 3> a{};
+            for (const auto& s : path)
+                a += s;
+            a /= static_cast<double>(path.size());
+            return a > K ? a - K : mdual<double, 3>{};
+        };
+        monte_carlo_setup<double> monthly{S, sigma, r, T, 18, 20000, 11};
+        const auto base = monte_carlo_greeks(monthly, asian);
+        const double h = 1e-4;
+        monthly.spot = S + h;
+        const double up = monte_carlo_greeks(monthly, asian).price;
+        monthly.spot = S - h;
+        const double down = monte_carlo_greeks(monthly, asian).price;
+        expect("bump and reprice", std::fabs((up - down) / (2 * h) - base.delta) <= 1e-6);
+
+        // the same numbers whatever the pool
+        sweep_pool one{1}, three{3};
+        monthly.spot = S;
+        const auto a = monte_carlo_greeks(monthly, asian, one), b = monte_carlo_greeks(monthly, asian, three);
+        expect("reproducible", a.price == b.price && a.delta == b.delta && a.vega == b.vega && a.rho == b.rho && a.standard_error == b.standard_error
+                            && a.price == base.price);
+    }});
+
+    return groups;
+}
+
+auto main(int argc, char** argv) -> int
+{
+    std::size_t samples = 2000;
+    std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::uint64_t seed = 20240601;
+    std::string timings_path, baseline_path;
+    double slowdown = 1.5;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view opt = argv[i];
+        if (opt == "--samples")        samples = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--jobs")      jobs = std::max<std::size_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        else if (opt == "--seed")      seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--timings")   timings_path = argv[i + 1];
+        else if (opt == "--baseline")  baseline_path = argv[i + 1];
+        else if (opt == "--slowdown")  slowdown = std::strtod(argv[i + 1], nullptr);
+        else
+        {
+            std::cerr << "unknown option " << opt << std::endl;
+            return 2;
+        }
+    }
+
+    const auto cases = function_cases();
+    const auto groups = check_groups();
+
+    // one job per case and type, then one per check group
+    const std::size_t case_jobs = cases.size() * 3;
+    std::vector<harness::outcome> outcomes(case_jobs + groups.size());
+    std::atomic<std::size_t> next{0};
+
+    auto worker = [&]
+    {
+        for (std::size_t j; (j = next.fetch_add(1)) < outcomes.size(); )
+        {
+            if (j < case_jobs)
+            {
+                const auto& c = cases[j / 3];
+                const int type = static_cast<int>(j % 3);
+                const std::uint64_t s = seed ^ (std::hash<std::string>{}(c.name) + type);
+                switch (type)
+                {
+                case 0:  outcomes[j] = harness::run_case<float>(c, type, samples, s); break;
+                case 1:  outcomes[j] = harness::run_case<double>(c, type, samples, s); break;
+                default: outcomes[j] = harness::run_case<long double>(c, type, samples, s); break;
+                }
+            }
+            else
+            {
+                const auto& g = groups[j - case_jobs];
+                harness::checker expect;
+                const auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    g.run(expect);
+                }
+                catch (const std::exception& e)
+                {
+                    expect(std::string{"threw "} + e.what(), false);
+                }
+                auto& o = outcomes[j];
+                o.name = g.name;
+                o.type = "fixed";
+                o.samples = expect.count;
+                o.failures = expect.failed.size();
+                o.notes = expect.failed;
+                o.ns_per_call = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < jobs; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+        t.join();
+
+    // timings of an earlier run, keyed by "name/type"; names like
+    // "pow(dual, dual)" hold commas, types and times do not
+    std::map<std::string, double> baseline;
+    if (!baseline_path.empty())
+    {
+        std::ifstream in(baseline_path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const auto b = line.rfind(',');
+            const auto a = b == std::string::npos || b == 0 ? std::string::npos : line.rfind(',', b - 1);
+            if (a != std::string::npos)
+                baseline[line.substr(0, a) + "/" + line.substr(a + 1, b - a - 1)] = std::strtod(line.c_str() + b + 1, nullptr);
+        }
+    }
+
+    std::size_t failed = 0, slower = 0;
+    std::printf("%-22s %-12s %8s %12s %12s %10s  %s\n", "case", "type", "samples", "value ulps", "tangent ulps", "ns/call", "status");
+    for (const auto& o : outcomes)
+    {
+        const char* status = o.failures ? "FAILED" : "passed";
+        if (o.failures)
+            ++failed;
+        if (o.type != "fixed")
+        {
+            const auto it = baseline.find(o.name + "/" + o.type);
+            // a nanosecond of slack keeps the cheapest operators from flagging on jitter
+            if (it != baseline.end() && o.ns_per_call > slowdown * it->second && o.ns_per_call > it->second + 1)
+            {
+                status = o.failures ? "FAILED, SLOWER" : "SLOWER";
+                ++slower;
+            }
+            std::printf("%-22s %-12s %8zu %12.3Lg %12.3Lg %10.2f  %s\n", o.name.c_str(), o.type.c_str(), o.samples, o.value_ulps, o.tangent_ulps, o.ns_per_call, status);
+        }
+        else
+        {
+            std::printf("%-22s %-12s %8zu %12s %12s %10s  %s\n", o.name.c_str(), o.type.c_str(), o.samples, "", "", "", status);
+        }
+        for (const auto& n : o.notes)
+            std::printf("    %s\n", n.c_str());
+    }
+
+    if (!timings_path.empty())
+    {
+        std::ofstream out(timings_path);
+        for (const auto& o : outcomes)
+            if (o.type != "fixed")
+                out << o.name << ',' << o.type << ',' << o.ns_per_call << '\n';
+    }
+
+    std::printf("%zu of %zu jobs failed, %zu slower than baseline\n", failed, outcomes.size(), slower);
+    return failed || slower ? 1 : 0;
+}